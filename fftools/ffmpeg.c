@@ -104,6 +104,7 @@ atomic_uint nb_output_dumped = 0;
 
 static BenchmarkTimeStamps current_time;
 AVIOContext *progress_avio = NULL;
+AVIOContext *sched_stats_avio = NULL;
 
 InputFile   **input_files   = NULL;
 int        nb_input_files   = 0;
@@ -547,6 +548,43 @@ int check_avoptions_used(const AVDictionary *opts, const AVDictionary *opts_used
     return 0;
 }
 
+// threads of -thread_budget given to each node, once all nodes are known
+static int thread_budget_node;
+
+int thread_budget_share(void)
+{
+    if (thread_budget <= 0)
+        return 0;
+    return FFMAX(thread_budget_node, 1);
+}
+
+int thread_budget_finalise(void)
+{
+    int nb_nodes = nb_filtergraphs + nb_decoders;
+
+    if (thread_budget <= 0)
+        return 0;
+
+    for (InputStream *ist = ist_iter(NULL); ist; ist = ist_iter(ist))
+        nb_nodes += !!ist->decoder;
+    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost))
+        nb_nodes += !!ost->enc;
+
+    thread_budget_node = FFMAX(1, thread_budget / FFMAX(nb_nodes, 1));
+
+    /* Input stream decoders are opened while the outputs are created, with a
+     * single thread, as their share is not known yet. */
+    for (InputStream *ist = ist_iter(NULL); ist; ist = ist_iter(ist)) {
+        if (ist->decoder) {
+            int ret = dec_thread_budget_apply(ist->decoder);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+
 void update_benchmark(const char *fmt, ...)
 {
     if (do_benchmark_all) {
@@ -880,6 +918,22 @@ static int check_keyboard_interaction(int64_t cur_time)
     return 0;
 }
 
+static void print_sched_stats(Scheduler *sch)
+{
+    AVBPrint buf;
+
+    if (!sched_stats_avio)
+        return;
+
+    av_bprint_init(&buf, 0, AV_BPRINT_SIZE_UNLIMITED);
+    sch_print_stats(sch, &buf);
+    if (av_bprint_is_complete(&buf)) {
+        avio_write(sched_stats_avio, buf.str, buf.len);
+        avio_flush(sched_stats_avio);
+    }
+    av_bprint_finalize(&buf, NULL);
+}
+
 /*
  * The following code is the main loop of the file converter
  */
@@ -915,10 +969,19 @@ static int transcode(Scheduler *sch)
 
         /* dump report by using the output first video and audio streams */
         print_report(0, timer_start, cur_time, transcode_ts);
+        print_sched_stats(sch);
     }
 
     ret = sch_stop(sch, &transcode_ts);
 
+    print_sched_stats(sch);
+    if (sched_stats_avio) {
+        int err = avio_closep(&sched_stats_avio);
+        if (err < 0)
+            av_log(NULL, AV_LOG_ERROR,
+                   "Error closing scheduler statistics: %s\n", av_err2str(err));
+    }
+
     /* write the trailer if needed */
     for (int i = 0; i < nb_output_files; i++) {
         int err = of_write_trailer(output_files[i]);
@@ -635,6 +635,9 @@ typedef struct Encoder {
     // number of frames/samples sent to the encoder
     uint64_t                frames_encoded;
     uint64_t                samples_encoded;
+
+    // the thread count was set explicitly by the user
+    int                     threads_manual;
 } Encoder;
 
 enum CroppingType {
@@ -777,11 +780,14 @@ extern int print_stats;
 extern int64_t stats_period;
 extern int stdin_interaction;
 extern AVIOContext *progress_avio;
+extern AVIOContext *sched_stats_avio;
 extern float max_error_rate;
 
 extern char *filter_nbthreads;
 extern int filter_complex_nbthreads;
+extern int thread_budget;
 extern int filter_buffered_frames;
+extern int filter_pipeline;
 extern int vstats_version;
 extern int print_graphs;
 extern char *print_graphs_file;
@@ -892,6 +898,13 @@ int dec_init(Decoder **pdec, Scheduler *sch,
              AVFrame *param_out);
 void dec_free(Decoder **pdec);
 
+/**
+ * Reopen a decoder opened with a provisional share of -thread_budget with
+ * the final share, if they differ. Must be called before any packet is sent
+ * to the decoder.
+ */
+int dec_thread_budget_apply(Decoder *dec);
+
 /*
  * Called by filters to connect decoder's output to given filtergraph input.
  *
@@ -961,6 +974,23 @@ OutputStream *ost_iter(OutputStream *prev);
 
 void update_benchmark(const char *fmt, ...);
 
+/**
+ * Get the number of worker threads a decoder, encoder or filtergraph whose
+ * thread count was not set by the user should use, when a -thread_budget is
+ * set. The budget is split evenly between all of them, which is only known
+ * once thread_budget_finalise() was called; before that, 1 is returned.
+ *
+ * @return the thread count, or 0 when no budget is set
+ */
+int thread_budget_share(void);
+
+/**
+ * Compute the shares of -thread_budget once all decoders, encoders and
+ * filtergraphs are created, and reopen the decoders opened before with
+ * their final share.
+ */
+int thread_budget_finalise(void);
+
 const char *opt_match_per_type_str(const SpecifierOptList *sol,
                                    char mediatype);
 void opt_match_per_stream_str(void *logctx, const SpecifierOptList *sol,
@@ -102,6 +102,16 @@ typedef struct DecoderPriv {
         AVDictionary       *opts;
         const AVCodec      *codec;
     } standalone_init;
+
+    // what is needed to reopen the decoder with another share of
+    // -thread_budget, see dec_thread_budget_apply()
+    struct {
+        AVDictionary       *opts;
+        AVCodecParameters  *par;
+        char               *hwaccel_device;
+        AVRational          time_base;
+        int                 threads;
+    } budget;
 } DecoderPriv;
 
 static DecoderPriv *dp_from_dec(Decoder *d)
@@ -132,6 +142,10 @@ void dec_free(Decoder **pdec)
 
     av_dict_free(&dp->standalone_init.opts);
 
+    av_dict_free(&dp->budget.opts);
+    avcodec_parameters_free(&dp->budget.par);
+    av_freep(&dp->budget.hwaccel_device);
+
     for (int i = 0; i < FF_ARRAY_ELEMS(dp->sub_prev); i++)
         av_frame_free(&dp->sub_prev[i]);
     av_frame_free(&dp->sub_heartbeat);
@@ -1522,42 +1536,12 @@ static int hw_device_setup_for_decode(DecoderPriv *dp,
     return 0;
 }
 
-static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
-                    const DecoderOpts *o, AVFrame *param_out)
+static int dec_ctx_open(DecoderPriv *dp, AVDictionary **dec_opts,
+                        const DecoderOpts *o)
 {
     const AVCodec *codec = o->codec;
     int ret;
 
-    dp->flags      = o->flags;
-    dp->log_parent = o->log_parent;
-
-    dp->dec.type                = codec->type;
-    dp->framerate_in            = o->framerate;
-
-    dp->hwaccel_id              = o->hwaccel_id;
-    dp->hwaccel_device_type     = o->hwaccel_device_type;
-    dp->hwaccel_output_format   = o->hwaccel_output_format;
-
-    snprintf(dp->log_name, sizeof(dp->log_name), "dec:%s", codec->name);
-
-    dp->parent_name = av_strdup(o->name ? o->name : "");
-    if (!dp->parent_name)
-        return AVERROR(ENOMEM);
-
-    if (codec->type == AVMEDIA_TYPE_SUBTITLE &&
-        (dp->flags & DECODER_FLAG_FIX_SUB_DURATION)) {
-        for (int i = 0; i < FF_ARRAY_ELEMS(dp->sub_prev); i++) {
-            dp->sub_prev[i] = av_frame_alloc();
-            if (!dp->sub_prev[i])
-                return AVERROR(ENOMEM);
-        }
-        dp->sub_heartbeat = av_frame_alloc();
-        if (!dp->sub_heartbeat)
-            return AVERROR(ENOMEM);
-    }
-
-    dp->sar_override = o->par->sample_aspect_ratio;
-
     dp->dec_ctx = avcodec_alloc_context3(codec);
     if (!dp->dec_ctx)
         return AVERROR(ENOMEM);
@@ -1573,9 +1557,6 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
     dp->dec_ctx->get_buffer2           = get_buffer;
     dp->dec_ctx->pkt_timebase          = o->time_base;
 
-    if (!av_dict_get(*dec_opts, "threads", NULL, 0))
-        av_dict_set(dec_opts, "threads", "auto", 0);
-
     ret = hw_device_setup_for_decode(dp, codec, o->hwaccel_device);
     if (ret < 0) {
         av_log(dp, AV_LOG_ERROR,
@@ -1595,7 +1576,7 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
         return ret;
 
     dp->dec_ctx->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
-    if (o->flags & DECODER_FLAG_BITEXACT)
+    if (dp->flags & DECODER_FLAG_BITEXACT)
         dp->dec_ctx->flags |= AV_CODEC_FLAG_BITEXACT;
 
     // we apply cropping ourselves
@@ -1624,6 +1605,88 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
     dp->dec.subtitle_header      = dp->dec_ctx->subtitle_header;
     dp->dec.subtitle_header_size = dp->dec_ctx->subtitle_header_size;
 
+    return 0;
+}
+
+static int dec_budget_save(DecoderPriv *dp, const AVDictionary *dec_opts,
+                           const DecoderOpts *o, int threads)
+{
+    int ret;
+
+    ret = av_dict_copy(&dp->budget.opts, dec_opts, 0);
+    if (ret < 0)
+        return ret;
+
+    dp->budget.par = avcodec_parameters_alloc();
+    if (!dp->budget.par)
+        return AVERROR(ENOMEM);
+    ret = avcodec_parameters_copy(dp->budget.par, o->par);
+    if (ret < 0)
+        return ret;
+
+    if (o->hwaccel_device) {
+        dp->budget.hwaccel_device = av_strdup(o->hwaccel_device);
+        if (!dp->budget.hwaccel_device)
+            return AVERROR(ENOMEM);
+    }
+
+    dp->budget.time_base = o->time_base;
+    dp->budget.threads   = threads;
+
+    return 0;
+}
+
+static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
+                    const DecoderOpts *o, AVFrame *param_out)
+{
+    const AVCodec *codec = o->codec;
+    int ret;
+
+    dp->flags      = o->flags;
+    dp->log_parent = o->log_parent;
+
+    dp->dec.type                = codec->type;
+    dp->framerate_in            = o->framerate;
+
+    dp->hwaccel_id              = o->hwaccel_id;
+    dp->hwaccel_device_type     = o->hwaccel_device_type;
+    dp->hwaccel_output_format   = o->hwaccel_output_format;
+
+    snprintf(dp->log_name, sizeof(dp->log_name), "dec:%s", codec->name);
+
+    dp->parent_name = av_strdup(o->name ? o->name : "");
+    if (!dp->parent_name)
+        return AVERROR(ENOMEM);
+
+    if (codec->type == AVMEDIA_TYPE_SUBTITLE &&
+        (dp->flags & DECODER_FLAG_FIX_SUB_DURATION)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(dp->sub_prev); i++) {
+            dp->sub_prev[i] = av_frame_alloc();
+            if (!dp->sub_prev[i])
+                return AVERROR(ENOMEM);
+        }
+        dp->sub_heartbeat = av_frame_alloc();
+        if (!dp->sub_heartbeat)
+            return AVERROR(ENOMEM);
+    }
+
+    dp->sar_override = o->par->sample_aspect_ratio;
+
+    if (!av_dict_get(*dec_opts, "threads", NULL, 0)) {
+        int threads = thread_budget_share();
+        if (threads) {
+            av_dict_set_int(dec_opts, "threads", threads, 0);
+            ret = dec_budget_save(dp, *dec_opts, o, threads);
+            if (ret < 0)
+                return ret;
+        } else
+            av_dict_set(dec_opts, "threads", "auto", 0);
+    }
+
+    ret = dec_ctx_open(dp, dec_opts, o);
+    if (ret < 0)
+        return ret;
+
     if (param_out) {
         if (dp->dec_ctx->codec_type == AVMEDIA_TYPE_AUDIO) {
             param_out->format               = dp->dec_ctx->sample_fmt;
@@ -1680,6 +1743,31 @@ fail:
     return ret;
 }
 
+int dec_thread_budget_apply(Decoder *d)
+{
+    DecoderPriv *dp = dp_from_dec(d);
+    int threads = thread_budget_share();
+    DecoderOpts o = {
+        .codec          = dp->dec_ctx ? dp->dec_ctx->codec : NULL,
+        .par            = dp->budget.par,
+        .hwaccel_device = dp->budget.hwaccel_device,
+        .time_base      = dp->budget.time_base,
+    };
+    int ret;
+
+    if (!o.codec || !dp->budget.opts || dp->budget.threads == threads)
+        return 0;
+
+    /* nothing was decoded yet, so the decoder can simply be opened again */
+    avcodec_free_context(&dp->dec_ctx);
+    av_dict_set_int(&dp->budget.opts, "threads", threads, 0);
+    dp->budget.threads = threads;
+
+    ret = dec_ctx_open(dp, &dp->budget.opts, &o);
+    av_dict_free(&dp->budget.opts);
+    return ret;
+}
+
 int dec_create(const OptionsContext *o, const char *arg, Scheduler *sch)
 {
     DecoderPriv *dp;
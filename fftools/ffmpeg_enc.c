@@ -334,6 +334,10 @@ int enc_open(void *opaque, const AVFrame *frame)
 
     enc_ctx->flags |= AV_CODEC_FLAG_FRAME_DURATION;
 
+    // an automatic thread count gets its share of the global thread budget
+    if (!e->threads_manual && thread_budget > 0)
+        enc_ctx->thread_count = thread_budget_share();
+
     ret = hw_device_setup_for_encode(e, enc_ctx, frame ? frame->hw_frames_ctx : NULL);
     if (ret < 0) {
         av_log(e, AV_LOG_ERROR,
@@ -2086,6 +2086,10 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
             ret = av_opt_set_int(fgt->graph, "threads", fgp->nb_threads, 0);
             if (ret < 0)
                 return ret;
+        } else if (thread_budget > 0) {
+            ret = av_opt_set_int(fgt->graph, "threads", thread_budget_share(), 0);
+            if (ret < 0)
+                return ret;
         }
 
         if (av_dict_count(ofp->sws_opts)) {
@@ -2105,7 +2109,9 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
             av_free(args);
         }
     } else {
-        fgt->graph->nb_threads = filter_complex_nbthreads;
+        // a negative value means not set by the user
+        fgt->graph->nb_threads = filter_complex_nbthreads >= 0 ?
+                                 filter_complex_nbthreads : thread_budget_share();
     }
 
     if (filter_buffered_frames) {
@@ -2114,6 +2120,12 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
             return ret;
     }
 
+    if (filter_pipeline) {
+        ret = av_opt_set(fgt->graph, "thread_type", "slice+pipeline", 0);
+        if (ret < 0)
+            return ret;
+    }
+
     hw_device = hw_device_for_filter();
 
     ret = graph_parse(fg, fgt->graph, graph_desc, &inputs, &outputs, hw_device);
@@ -3221,8 +3233,10 @@ static int send_frame(FilterGraph *fg, FilterGraphThread *fgt,
         return AVERROR(ENOMEM);
     fd->wallclock[LATENCY_PROBE_FILTER_PRE] = av_gettime_relative();
 
+    /* with pipeline threading, let the filters work on the frame while the
+     * next one is decoded */
     ret = av_buffersrc_add_frame_flags(ifilter->filter, frame,
-                                       AV_BUFFERSRC_FLAG_PUSH);
+                                       filter_pipeline ? 0 : AV_BUFFERSRC_FLAG_PUSH);
     if (ret < 0) {
         av_frame_unref(frame);
         if (ret != AVERROR_EOF)
@@ -233,6 +233,18 @@ static int write_packet(Muxer *mux, OutputStream *ost, AVPacket *pkt)
     if (ms->stats.io)
         enc_stats_write(ost, &ms->stats, NULL, pkt, frame_num);
 
+    if (pkt->opaque_ref) {
+        const FrameData *fd = (FrameData*)pkt->opaque_ref->data;
+
+        for (int i = 0; i < FF_ARRAY_ELEMS(fd->wallclock); i++) {
+            if (fd->wallclock[i] != INT64_MIN) {
+                sch_mux_stream_latency(mux->sch, mux->sch_idx, ms->sch_idx,
+                                       av_gettime_relative() - fd->wallclock[i]);
+                break;
+            }
+        }
+    }
+
     ret = av_interleaved_write_frame(s, pkt);
     if (ret < 0) {
         av_log(ost, AV_LOG_ERROR,
@@ -32,6 +32,7 @@
 #include "libavcodec/packet.h"
 
 #include "libavutil/avassert.h"
+#include "libavutil/bprint.h"
 #include "libavutil/error.h"
 #include "libavutil/fifo.h"
 #include "libavutil/frame.h"
@@ -43,6 +44,8 @@
 // 100 ms
 // FIXME: some other value? make this dynamic?
 #define SCHEDULE_TOLERANCE (100 * 1000)
+// number of power-of-two millisecond buckets in the latency histograms
+#define SCH_LATENCY_BUCKETS 13
 
 enum QueueType {
     QUEUE_PACKETS,
@@ -54,6 +57,9 @@ typedef struct SchWaiter {
     pthread_cond_t      cond;
     atomic_int          choked;
 
+    // total time spent waiting while choked, in microseconds
+    atomic_int_least64_t choked_time;
+
     // the following are internal state of schedule_update_locked() and must not
     // be accessed outside of it
     int                 choked_prev;
@@ -69,6 +75,18 @@ typedef struct SchTask {
 
     pthread_t           thread;
     int                 thread_running;
+
+    // statistics, updated by the task thread and read by sch_print_stats()
+    atomic_int_least64_t start_time;
+    atomic_int_least64_t end_time;
+    // number of packets/frames received or, for demuxers, sent
+    atomic_uint_least64_t nb_items;
+    // total time spent waiting for input or blocked on output, in microseconds
+    atomic_int_least64_t input_time;
+    atomic_int_least64_t output_time;
+
+    // state of the previous sch_print_stats() call
+    uint64_t            stats_prev_items;
 } SchTask;
 
 typedef struct SchDecOutput {
@@ -207,6 +225,12 @@ typedef struct SchMuxStream {
     // this stream no longer accepts input
     int                 source_finished;
     ////////////////////////////////////////////////////////////
+
+    // end-to-end latency statistics, updated by the muxer task and read by
+    // sch_print_stats(); bucket i counts packets with latency below 2^i ms,
+    // the last bucket collects everything above
+    atomic_uint_least64_t latency_hist[SCH_LATENCY_BUCKETS + 1];
+    atomic_int_least64_t  latency_max;
 } SchMuxStream;
 
 typedef struct SchMux {
@@ -309,6 +333,8 @@ struct Scheduler {
     pthread_mutex_t     schedule_lock;
 
     atomic_int_least64_t last_dts;
+
+    int64_t             stats_prev_time;
 };
 
 /**
@@ -319,11 +345,14 @@ struct Scheduler {
  */
 static int waiter_wait(Scheduler *sch, SchWaiter *w)
 {
+    int64_t t;
     int terminate;
 
     if (!atomic_load(&w->choked))
         return 0;
 
+    t = av_gettime_relative();
+
     pthread_mutex_lock(&w->lock);
 
     while (atomic_load(&w->choked) && !atomic_load(&sch->terminate))
@@ -333,6 +362,8 @@ static int waiter_wait(Scheduler *sch, SchWaiter *w)
 
     pthread_mutex_unlock(&w->lock);
 
+    atomic_fetch_add(&w->choked_time, av_gettime_relative() - t);
+
     return terminate;
 }
 
@@ -351,6 +382,7 @@ static int waiter_init(SchWaiter *w)
     int ret;
 
     atomic_init(&w->choked, 0);
+    atomic_init(&w->choked_time, 0);
 
     ret = pthread_mutex_init(&w->lock, NULL);
     if (ret)
@@ -412,6 +444,8 @@ static int task_start(SchTask *task)
 
     av_assert0(!task->thread_running);
 
+    atomic_store(&task->start_time, av_gettime_relative());
+
     ret = pthread_create(&task->thread, NULL, task_wrapper, task);
     if (ret) {
         av_log(task->func_arg, AV_LOG_ERROR, "pthread_create() failed: %s\n",
@@ -433,6 +467,29 @@ static void task_init(Scheduler *sch, SchTask *task, enum SchedulerNodeType type
 
     task->func      = func;
     task->func_arg  = func_arg;
+
+    atomic_init(&task->start_time,  0);
+    atomic_init(&task->end_time,    0);
+    atomic_init(&task->nb_items,    0);
+    atomic_init(&task->input_time,  0);
+    atomic_init(&task->output_time, 0);
+}
+
+/**
+ * Receive from a task's input queue, accounting the time spent waiting.
+ */
+static int task_receive(SchTask *task, ThreadQueue *tq, int *stream_idx, void *data)
+{
+    int64_t t = av_gettime_relative();
+    int ret;
+
+    ret = tq_receive(tq, stream_idx, data);
+
+    atomic_fetch_add(&task->input_time, av_gettime_relative() - t);
+    if (ret >= 0)
+        atomic_fetch_add(&task->nb_items, 1);
+
+    return ret;
 }
 
 static int64_t trailing_dts(const Scheduler *sch, int count_finished)
@@ -686,6 +743,10 @@ int sch_add_mux_stream(Scheduler *sch, unsigned mux_idx)
 
     ms->last_dts = AV_NOPTS_VALUE;
 
+    for (int i = 0; i < FF_ARRAY_ELEMS(ms->latency_hist); i++)
+        atomic_init(&ms->latency_hist[i], 0);
+    atomic_init(&ms->latency_max, 0);
+
     return stream_idx;
 }
 
@@ -2138,7 +2199,8 @@ int sch_demux_send(Scheduler *sch, unsigned demux_idx, AVPacket *pkt,
                    unsigned flags)
 {
     SchDemux *d;
-    int terminate;
+    int64_t t;
+    int terminate, ret;
 
     av_assert0(demux_idx < sch->nb_demux);
     d = &sch->demux[demux_idx];
@@ -2153,7 +2215,12 @@ int sch_demux_send(Scheduler *sch, unsigned demux_idx, AVPacket *pkt,
 
     av_assert0(pkt->stream_index < d->nb_streams);
 
-    return demux_send_for_stream(sch, d, &d->streams[pkt->stream_index], pkt, flags);
+    t   = av_gettime_relative();
+    ret = demux_send_for_stream(sch, d, &d->streams[pkt->stream_index], pkt, flags);
+    atomic_fetch_add(&d->task.output_time, av_gettime_relative() - t);
+    atomic_fetch_add(&d->task.nb_items, 1);
+
+    return ret;
 }
 
 static int demux_done(Scheduler *sch, unsigned demux_idx)
@@ -2186,11 +2253,33 @@ int sch_mux_receive(Scheduler *sch, unsigned mux_idx, AVPacket *pkt)
     av_assert0(mux_idx < sch->nb_mux);
     mux = &sch->mux[mux_idx];
 
-    ret = tq_receive(mux->queue, &stream_idx, pkt);
+    ret = task_receive(&mux->task, mux->queue, &stream_idx, pkt);
     pkt->stream_index = stream_idx;
     return ret;
 }
 
+void sch_mux_stream_latency(Scheduler *sch, unsigned mux_idx, unsigned stream_idx,
+                            int64_t latency)
+{
+    SchMuxStream *ms;
+    int64_t latency_ms = latency / 1000;
+    int64_t max;
+    unsigned bucket = 0;
+
+    av_assert0(mux_idx < sch->nb_mux);
+    av_assert0(stream_idx < sch->mux[mux_idx].nb_streams);
+    ms = &sch->mux[mux_idx].streams[stream_idx];
+
+    while (bucket < SCH_LATENCY_BUCKETS && latency_ms >= (INT64_C(1) << bucket))
+        bucket++;
+    atomic_fetch_add(&ms->latency_hist[bucket], 1);
+
+    // only the muxer task writes this value
+    max = atomic_load(&ms->latency_max);
+    if (latency > max)
+        atomic_store(&ms->latency_max, latency);
+}
+
 void sch_mux_receive_finish(Scheduler *sch, unsigned mux_idx, unsigned stream_idx)
 {
     SchMux *mux;
@@ -2280,7 +2369,7 @@ int sch_dec_receive(Scheduler *sch, unsigned dec_idx, AVPacket *pkt)
         dec->expect_end_ts = 0;
     }
 
-    ret = tq_receive(dec->queue, &dummy, pkt);
+    ret = task_receive(&dec->task, dec->queue, &dummy, pkt);
     av_assert0(dummy <= 0);
 
     // got a flush packet, on the next call to this function the decoder
@@ -2344,17 +2433,13 @@ finish:
     return AVERROR_EOF;
 }
 
-int sch_dec_send(Scheduler *sch, unsigned dec_idx,
-                 unsigned out_idx, AVFrame *frame)
+static int dec_send(Scheduler *sch, SchDec *dec,
+                    unsigned out_idx, AVFrame *frame)
 {
-    SchDec *dec;
     SchDecOutput *o;
     int ret;
     unsigned nb_done = 0;
 
-    av_assert0(dec_idx < sch->nb_dec);
-    dec = &sch->dec[dec_idx];
-
     av_assert0(out_idx < dec->nb_outputs);
     o = &dec->outputs[out_idx];
 
@@ -2388,6 +2473,22 @@ int sch_dec_send(Scheduler *sch, unsigned dec_idx,
     return (nb_done == o->nb_dst) ? AVERROR_EOF : 0;
 }
 
+int sch_dec_send(Scheduler *sch, unsigned dec_idx,
+                 unsigned out_idx, AVFrame *frame)
+{
+    SchDec *dec;
+    int64_t t = av_gettime_relative();
+    int ret;
+
+    av_assert0(dec_idx < sch->nb_dec);
+    dec = &sch->dec[dec_idx];
+
+    ret = dec_send(sch, dec, out_idx, frame);
+    atomic_fetch_add(&dec->task.output_time, av_gettime_relative() - t);
+
+    return ret;
+}
+
 static int dec_done(Scheduler *sch, unsigned dec_idx)
 {
     SchDec *dec = &sch->dec[dec_idx];
@@ -2421,7 +2522,7 @@ int sch_enc_receive(Scheduler *sch, unsigned enc_idx, AVFrame *frame)
     av_assert0(enc_idx < sch->nb_enc);
     enc = &sch->enc[enc_idx];
 
-    ret = tq_receive(enc->queue, &dummy, frame);
+    ret = task_receive(&enc->task, enc->queue, &dummy, frame);
     av_assert0(dummy <= 0);
 
     return ret;
@@ -2457,14 +2558,10 @@ finish:
     return AVERROR_EOF;
 }
 
-int sch_enc_send(Scheduler *sch, unsigned enc_idx, AVPacket *pkt)
+static int enc_send(Scheduler *sch, SchEnc *enc, AVPacket *pkt)
 {
-    SchEnc *enc;
     int ret;
 
-    av_assert0(enc_idx < sch->nb_enc);
-    enc = &sch->enc[enc_idx];
-
     for (unsigned i = 0; i < enc->nb_dst; i++) {
         uint8_t *finished = &enc->dst_finished[i];
         AVPacket *to_send = pkt;
@@ -2490,6 +2587,21 @@ int sch_enc_send(Scheduler *sch, unsigned enc_idx, AVPacket *pkt)
     return 0;
 }
 
+int sch_enc_send(Scheduler *sch, unsigned enc_idx, AVPacket *pkt)
+{
+    SchEnc *enc;
+    int64_t t = av_gettime_relative();
+    int ret;
+
+    av_assert0(enc_idx < sch->nb_enc);
+    enc = &sch->enc[enc_idx];
+
+    ret = enc_send(sch, enc, pkt);
+    atomic_fetch_add(&enc->task.output_time, av_gettime_relative() - t);
+
+    return ret;
+}
+
 static int enc_done(Scheduler *sch, unsigned enc_idx)
 {
     SchEnc *enc = &sch->enc[enc_idx];
@@ -2537,7 +2649,7 @@ int sch_filter_receive(Scheduler *sch, unsigned fg_idx,
     while (1) {
         int ret, idx;
 
-        ret = tq_receive(fg->queue, &idx, frame);
+        ret = task_receive(&fg->task, fg->queue, &idx, frame);
         if (idx < 0)
             return AVERROR_EOF;
         else if (ret >= 0) {
@@ -2581,6 +2693,7 @@ int sch_filter_send(Scheduler *sch, unsigned fg_idx, unsigned out_idx, AVFrame *
 {
     SchFilterGraph *fg;
     SchedulerNode  dst;
+    int64_t t = av_gettime_relative();
     int ret;
 
     av_assert0(fg_idx < sch->nb_filters);
@@ -2598,6 +2711,7 @@ int sch_filter_send(Scheduler *sch, unsigned fg_idx, unsigned out_idx, AVFrame *
         if (ret == AVERROR_EOF)
             send_to_filter(sch, &sch->filters[dst.idx], dst.idx_stream, NULL);
     }
+    atomic_fetch_add(&fg->task.output_time, av_gettime_relative() - t);
     return ret;
 }
 
@@ -2679,6 +2793,8 @@ static void *task_wrapper(void *arg)
     err = task_cleanup(sch, task->node);
     ret = err_merge(ret, err);
 
+    atomic_store(&task->end_time, av_gettime_relative());
+
     // EOF is considered normal termination
     if (ret == AVERROR_EOF)
         ret = 0;
@@ -2774,3 +2890,175 @@ int sch_stop(Scheduler *sch, int64_t *finish_ts)
 
     return ret;
 }
+
+static ThreadQueue *node_queue(Scheduler *sch, const SchedulerNode *node)
+{
+    if (!node)
+        return NULL;
+
+    switch (node->type) {
+    case SCH_NODE_TYPE_MUX:       return sch->mux[node->idx].queue;
+    case SCH_NODE_TYPE_DEC:       return sch->dec[node->idx].queue;
+    case SCH_NODE_TYPE_ENC:       return sch->enc[node->idx].queue;
+    case SCH_NODE_TYPE_FILTER_IN: return sch->filters[node->idx].queue;
+    default:                      return NULL;
+    }
+}
+
+// n-th destination of the given task, or NULL if there are fewer
+static const SchedulerNode *task_dst(Scheduler *sch, const SchedulerNode *node,
+                                     unsigned n)
+{
+    if (node->type == SCH_NODE_TYPE_DEMUX) {
+        const SchDemux *d = &sch->demux[node->idx];
+
+        for (unsigned i = 0; i < d->nb_streams; i++) {
+            if (n < d->streams[i].nb_dst)
+                return &d->streams[i].dst[n];
+            n -= d->streams[i].nb_dst;
+        }
+    } else if (node->type == SCH_NODE_TYPE_DEC) {
+        const SchDec *dec = &sch->dec[node->idx];
+
+        for (unsigned i = 0; i < dec->nb_outputs; i++) {
+            if (n < dec->outputs[i].nb_dst)
+                return &dec->outputs[i].dst[n];
+            n -= dec->outputs[i].nb_dst;
+        }
+    } else if (node->type == SCH_NODE_TYPE_FILTER_IN) {
+        const SchFilterGraph *fg = &sch->filters[node->idx];
+
+        if (n < fg->nb_outputs)
+            return &fg->outputs[n].dst;
+    } else if (node->type == SCH_NODE_TYPE_ENC) {
+        const SchEnc *enc = &sch->enc[node->idx];
+
+        if (n < enc->nb_dst)
+            return &enc->dst[n];
+    }
+
+    return NULL;
+}
+
+/**
+ * Total number of items buffered in the distinct queues the task sends to,
+ * or -1 if it has none.
+ */
+static int64_t task_output_queued(Scheduler *sch, const SchTask *task)
+{
+    const SchedulerNode *dst;
+    int64_t queued = -1;
+
+    for (unsigned n = 0; (dst = task_dst(sch, &task->node, n)); n++) {
+        ThreadQueue *tq = node_queue(sch, dst);
+        unsigned m;
+
+        if (!tq)
+            continue;
+
+        // several destinations may share a queue, count it only once
+        for (m = 0; m < n; m++)
+            if (node_queue(sch, task_dst(sch, &task->node, m)) == tq)
+                break;
+        if (m < n)
+            continue;
+
+        queued = FFMAX(queued, 0) + tq_nb_items(tq);
+    }
+
+    return queued;
+}
+
+static void print_latency_stats(AVBPrint *bp, const SchMux *mux)
+{
+    av_bprintf(bp, ",\"streams\":[");
+    for (unsigned i = 0; i < mux->nb_streams; i++) {
+        const SchMuxStream *ms = &mux->streams[i];
+        uint64_t count = 0;
+
+        av_bprintf(bp, "%s{\"index\":%u,\"latency_hist\":[", i ? "," : "", i);
+        for (int j = 0; j < FF_ARRAY_ELEMS(ms->latency_hist); j++) {
+            uint64_t val = atomic_load(&ms->latency_hist[j]);
+            av_bprintf(bp, "%s%"PRIu64, j ? "," : "", val);
+            count += val;
+        }
+        av_bprintf(bp, "],\"latency_count\":%"PRIu64",\"latency_max_us\":%"PRId64"}",
+                   count, (int64_t)atomic_load(&ms->latency_max));
+    }
+    av_bprintf(bp, "]");
+}
+
+static void print_task_stats(Scheduler *sch, AVBPrint *bp, SchTask *task,
+                             const char *type, ThreadQueue *queue, SchWaiter *w,
+                             int64_t now, int64_t interval, int *nb_printed)
+{
+    int64_t start = atomic_load(&task->start_time);
+    int64_t end   = atomic_load(&task->end_time);
+    int64_t input_time, output_time, choked_time, busy_time, output_queued;
+    uint64_t nb_items;
+
+    // task not started or removed
+    if (!task->parent || !start)
+        return;
+
+    nb_items    = atomic_load(&task->nb_items);
+    input_time  = atomic_load(&task->input_time);
+    output_time = atomic_load(&task->output_time);
+    choked_time = w ? atomic_load(&w->choked_time) : 0;
+    busy_time   = FFMAX((end ? end : now) - start -
+                        input_time - output_time - choked_time, 0);
+
+    av_bprintf(bp, "%s{\"type\":\"%s\",\"index\":%u,\"finished\":%d,"
+               "\"items\":%"PRIu64",\"items_per_sec\":%.2f,"
+               "\"busy_us\":%"PRId64",\"input_wait_us\":%"PRId64","
+               "\"output_wait_us\":%"PRId64",\"choked_us\":%"PRId64,
+               (*nb_printed)++ ? "," : "", type, task->node.idx, !!end,
+               nb_items, interval > 0 ?
+               (nb_items - task->stats_prev_items) * 1e6 / interval : 0.0,
+               busy_time, input_time, output_time, choked_time);
+    if (queue)
+        av_bprintf(bp, ",\"queued\":%zu", tq_nb_items(queue));
+    output_queued = task_output_queued(sch, task);
+    if (output_queued >= 0)
+        av_bprintf(bp, ",\"output_queued\":%"PRId64, output_queued);
+    if (task->node.type == SCH_NODE_TYPE_MUX)
+        print_latency_stats(bp, &sch->mux[task->node.idx]);
+    av_bprintf(bp, "}");
+
+    task->stats_prev_items = nb_items;
+}
+
+void sch_print_stats(Scheduler *sch, AVBPrint *bp)
+{
+    int64_t now      = av_gettime_relative();
+    int64_t interval = sch->stats_prev_time ? now - sch->stats_prev_time : 0;
+    int64_t last_dts = atomic_load(&sch->last_dts);
+    int nb_printed   = 0;
+
+    av_bprintf(bp, "{\"time_us\":%"PRId64",\"last_dts_us\":", now);
+    if (last_dts == AV_NOPTS_VALUE)
+        av_bprintf(bp, "null");
+    else
+        av_bprintf(bp, "%"PRId64, last_dts);
+    av_bprintf(bp, ",\"nodes\":[");
+
+    for (unsigned i = 0; i < sch->nb_demux; i++)
+        print_task_stats(sch, bp, &sch->demux[i].task, "demux", NULL,
+                         &sch->demux[i].waiter, now, interval, &nb_printed);
+    for (unsigned i = 0; i < sch->nb_dec; i++)
+        print_task_stats(sch, bp, &sch->dec[i].task, "dec", sch->dec[i].queue,
+                         NULL, now, interval, &nb_printed);
+    for (unsigned i = 0; i < sch->nb_filters; i++)
+        print_task_stats(sch, bp, &sch->filters[i].task, "filter", sch->filters[i].queue,
+                         &sch->filters[i].waiter, now, interval, &nb_printed);
+    for (unsigned i = 0; i < sch->nb_enc; i++)
+        print_task_stats(sch, bp, &sch->enc[i].task, "enc", sch->enc[i].queue,
+                         NULL, now, interval, &nb_printed);
+    for (unsigned i = 0; i < sch->nb_mux; i++)
+        print_task_stats(sch, bp, &sch->mux[i].task, "mux", sch->mux[i].queue,
+                         NULL, now, interval, &nb_printed);
+
+    av_bprintf(bp, "]}\n");
+
+    sch->stats_prev_time = now;
+}
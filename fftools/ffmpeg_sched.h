@@ -85,6 +85,7 @@
  * knowledge about the whole transcoding pipeline.
  */
 
+struct AVBPrint;
 struct AVFrame;
 struct AVPacket;
 
@@ -149,6 +150,21 @@ int sch_stop(Scheduler *sch, int64_t *finish_ts);
  */
 int sch_wait(Scheduler *sch, uint64_t timeout_us, int64_t *transcode_ts);
 
+/**
+ * Print per-task statistics as a single line of JSON.
+ *
+ * For every running or finished task, this reports the number of packets or
+ * frames it processed, the rate since the previous call, and how its lifetime
+ * divides into being busy, waiting for input, being blocked on output and
+ * being choked by the scheduler. The number of items currently buffered in the
+ * task's input queue and in the queues it sends to is also included, where
+ * applicable. For muxers, a histogram of the end-to-end latency reported with
+ * sch_mux_stream_latency() is printed for each stream.
+ *
+ * Must only be called from a single thread.
+ */
+void sch_print_stats(Scheduler *sch, struct AVBPrint *bp);
+
 /**
  * Add a demuxer to the scheduler.
  *
@@ -505,6 +521,16 @@ int sch_mux_receive(Scheduler *sch, unsigned mux_idx, struct AVPacket *pkt);
  */
 void sch_mux_receive_finish(Scheduler *sch, unsigned mux_idx, unsigned stream_idx);
 
+/**
+ * Called by muxer tasks to report the end-to-end latency of a packet, i.e. the
+ * time since its earliest ancestor entered the pipeline, for sch_print_stats().
+ *
+ * @param stream_idx Stream index previously returned from sch_add_mux_stream().
+ * @param latency latency in microseconds
+ */
+void sch_mux_stream_latency(Scheduler *sch, unsigned mux_idx, unsigned stream_idx,
+                            int64_t latency);
+
 int sch_mux_sub_heartbeat_add(Scheduler *sch, unsigned mux_idx, unsigned stream_idx,
                               unsigned dec_idx);
 int sch_mux_sub_heartbeat(Scheduler *sch, unsigned mux_idx, unsigned stream_idx,
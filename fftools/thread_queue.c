@@ -224,6 +224,17 @@ int tq_receive(ThreadQueue *tq, int *stream_idx, void *data)
     return ret;
 }
 
+size_t tq_nb_items(ThreadQueue *tq)
+{
+    size_t nb_items;
+
+    pthread_mutex_lock(&tq->lock);
+    nb_items = av_container_fifo_can_read(tq->fifo);
+    pthread_mutex_unlock(&tq->lock);
+
+    return nb_items;
+}
+
 void tq_send_finish(ThreadQueue *tq, unsigned int stream_idx)
 {
     av_assert0(stream_idx < tq->nb_streams);
@@ -82,6 +82,11 @@ void tq_choke(ThreadQueue *tq, int choked);
  *   for each stream. When *stream_idx is -1, all streams are done.
  */
 int tq_receive(ThreadQueue *tq, int *stream_idx, void *data);
+
+/**
+ * @return the number of items currently stored in the queue
+ */
+size_t tq_nb_items(ThreadQueue *tq);
 /**
  * Mark the given stream finished from the receiving side.
  */
@@ -821,6 +821,110 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+/**
+ * Reset the coding state of a channel element and run the psychoacoustic
+ * analysis on it.
+ *
+ * @return number of bits psy wants to allocate to the element
+ */
+static int analyze_element(AVCodecContext *avctx, AACEncContext *s,
+                           ChannelElement *cpe, int chans, int start_ch,
+                           FFPsyWindowInfo *wi)
+{
+    const float *coeffs[2];
+    int ch, w, target_bits = 0;
+
+    cpe->common_window = 0;
+    memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
+    memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
+    for (ch = 0; ch < chans; ch++) {
+        SingleChannelElement *sce = &cpe->ch[ch];
+        coeffs[ch] = sce->coeffs;
+        memset(&sce->tns, 0, sizeof(TemporalNoiseShaping));
+        for (w = 0; w < 128; w++)
+            if (sce->band_type[w] > RESERVED_BT)
+                sce->band_type[w] = 0;
+    }
+    s->psy.bitres.alloc = -1;
+    s->psy.bitres.bits = s->last_frame_pb_count / s->channels;
+    s->psy.model->analyze(&s->psy, start_ch, coeffs, wi);
+    if (s->psy.bitres.alloc > 0) {
+        /* Lambda unused here on purpose, we need to take psy's unscaled allocation */
+        target_bits = s->psy.bitres.alloc
+            * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
+        s->psy.bitres.alloc /= chans;
+    }
+    return target_bits;
+}
+
+/**
+ * Search quantizers and TNS filters for one channel, using a per-thread
+ * context for all the scratch state of the coder.
+ */
+static int search_channel_thread(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    AACEncContext *s = arg;
+    AACEncContext *t = &s->slice_ctx[threadnr];
+    const AACEncChannelJob *job = &s->chan_jobs[jobnr];
+    SingleChannelElement *sce = job->sce;
+
+    t->psy.bitres.alloc = job->alloc;
+    t->cur_type    = job->type;
+    t->cur_channel = jobnr;
+    if (t->options.pns && t->coder->mark_pns)
+        t->coder->mark_pns(t, avctx, sce);
+    t->coder->search_for_quantizers(avctx, t, sce, t->lambda);
+    if (t->options.tns && t->coder->search_for_tns)
+        t->coder->search_for_tns(t, sce);
+    if (t->options.tns && t->coder->apply_tns_filt)
+        t->coder->apply_tns_filt(t, sce);
+    return 0;
+}
+
+/**
+ * Run the psy analysis of all channel elements, then search quantizers and
+ * TNS filters of all channels in parallel.
+ *
+ * The psy model and PNS keep state across channels, so they are run serially
+ * in channel order, which keeps the output identical to the serial path.
+ *
+ * @return number of bits psy wants to allocate to the frame
+ */
+static int search_channels_threaded(AVCodecContext *avctx, AACEncContext *s,
+                                    FFPsyWindowInfo *windows)
+{
+    int i, ch, start_ch = 0, target_bits = 0;
+
+    for (i = 0; i < s->chan_map[0]; i++) {
+        int tag   = s->chan_map[i+1];
+        int chans = tag == TYPE_CPE ? 2 : 1;
+        ChannelElement *cpe = &s->cpe[i];
+
+        target_bits += analyze_element(avctx, s, cpe, chans, start_ch,
+                                       windows + start_ch);
+        for (ch = 0; ch < chans; ch++) {
+            AACEncChannelJob *job = &s->chan_jobs[start_ch + ch];
+            job->sce   = &cpe->ch[ch];
+            job->type  = tag;
+            job->alloc = s->psy.bitres.alloc;
+        }
+        start_ch += chans;
+    }
+
+    for (i = 0; i < s->nb_slice_ctx; i++) {
+        s->slice_ctx[i].lambda     = s->lambda;
+        s->slice_ctx[i].psy.cutoff = s->psy.cutoff;
+    }
+    avctx->execute2(avctx, search_channel_thread, s, NULL, s->channels);
+    /* The coder may update the analysis bandwidth, which is the same for
+     * all channels. */
+    for (i = 0; i < s->nb_slice_ctx; i++)
+        if (s->slice_ctx[i].psy.cutoff != s->psy.cutoff)
+            s->psy.cutoff = s->slice_ctx[i].psy.cutoff;
+
+    return target_bits;
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
@@ -834,6 +938,10 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     int ms_mode = 0, is_mode = 0, tns_mode = 0, pred_mode = 0;
     int chan_el_counter[4];
     FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
+    /* The analysis bandwidth used by the psy model is only set by the coder
+     * during the first frame; afterwards it is constant, so the analysis of
+     * all channel elements can run ahead of the coefficient search. */
+    int threaded = s->nb_slice_ctx > 0 && s->lambda_count > 0;
 
     /* add current frame to queue */
     if (frame) {
@@ -949,40 +1057,24 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
         start_ch = 0;
         target_bits = 0;
         memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        if (threaded)
+            target_bits = search_channels_threaded(avctx, s, windows);
         for (i = 0; i < s->chan_map[0]; i++) {
             FFPsyWindowInfo* wi = windows + start_ch;
-            const float *coeffs[2];
             tag      = s->chan_map[i+1];
             chans    = tag == TYPE_CPE ? 2 : 1;
             cpe      = &s->cpe[i];
-            cpe->common_window = 0;
-            memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
-            memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
             put_bits(&s->pb, 3, tag);
             put_bits(&s->pb, 4, chan_el_counter[tag]++);
-            for (ch = 0; ch < chans; ch++) {
-                sce = &cpe->ch[ch];
-                coeffs[ch] = sce->coeffs;
-                memset(&sce->tns, 0, sizeof(TemporalNoiseShaping));
-                for (w = 0; w < 128; w++)
-                    if (sce->band_type[w] > RESERVED_BT)
-                        sce->band_type[w] = 0;
-            }
-            s->psy.bitres.alloc = -1;
-            s->psy.bitres.bits = s->last_frame_pb_count / s->channels;
-            s->psy.model->analyze(&s->psy, start_ch, coeffs, wi);
-            if (s->psy.bitres.alloc > 0) {
-                /* Lambda unused here on purpose, we need to take psy's unscaled allocation */
-                target_bits += s->psy.bitres.alloc
-                    * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
-                s->psy.bitres.alloc /= chans;
-            }
             s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+            if (!threaded) {
+                target_bits += analyze_element(avctx, s, cpe, chans, start_ch, wi);
+                for (ch = 0; ch < chans; ch++) {
+                    s->cur_channel = start_ch + ch;
+                    if (s->options.pns && s->coder->mark_pns)
+                        s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
+                    s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+                }
             }
             if (chans > 1
                 && wi[0].window_type[0] == wi[1].window_type[0]
@@ -999,9 +1091,9 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
                 sce = &cpe->ch[ch];
                 s->cur_channel = start_ch + ch;
-                if (s->options.tns && s->coder->search_for_tns)
+                if (!threaded && s->options.tns && s->coder->search_for_tns)
                     s->coder->search_for_tns(s, sce);
-                if (s->options.tns && s->coder->apply_tns_filt)
+                if (!threaded && s->options.tns && s->coder->apply_tns_filt)
                     s->coder->apply_tns_filt(s, sce);
                 if (sce->tns.present)
                     tns_mode = 1;
@@ -1139,6 +1231,9 @@ static av_cold int aac_encode_end(AVCodecContext *avctx)
     av_tx_uninit(&s->mdct128);
     ff_psy_end(&s->psy);
     ff_lpc_end(&s->lpc);
+    for (int i = 0; i < s->nb_slice_ctx; i++)
+        ff_lpc_end(&s->slice_ctx[i].lpc);
+    av_freep(&s->slice_ctx);
     av_freep(&s->buffer.samples);
     av_freep(&s->cpe);
     av_freep(&s->fdsp);
@@ -1178,6 +1273,32 @@ static av_cold int alloc_buffers(AVCodecContext *avctx, AACEncContext *s)
     return 0;
 }
 
+static av_cold int alloc_slice_contexts(AVCodecContext *avctx, AACEncContext *s)
+{
+    int ret;
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE) || s->channels < 2)
+        return 0;
+
+    s->slice_ctx = av_malloc_array(avctx->thread_count, sizeof(*s->slice_ctx));
+    if (!s->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < avctx->thread_count; i++) {
+        AACEncContext *t = &s->slice_ctx[i];
+
+        memcpy(t, s, sizeof(*t));
+        t->slice_ctx    = NULL;
+        t->nb_slice_ctx = 0;
+        if ((ret = ff_lpc_init(&t->lpc, 2*avctx->frame_size, TNS_MAX_ORDER,
+                               FF_LPC_TYPE_LEVINSON)) < 0)
+            return ret;
+        s->nb_slice_ctx++;
+    }
+
+    return 0;
+}
+
 static av_cold int aac_encode_init(AVCodecContext *avctx)
 {
     AACEncContext *s = avctx->priv_data;
@@ -1295,6 +1416,9 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
 
     ff_aacenc_dsp_init(&s->aacdsp);
 
+    if ((ret = alloc_slice_contexts(avctx, s)) < 0)
+        return ret;
+
     ff_af_queue_init(avctx, &s->afq);
 
     return 0;
@@ -1332,7 +1456,8 @@ const FFCodec ff_aac_encoder = {
     .p.type         = AVMEDIA_TYPE_AUDIO,
     .p.id           = AV_CODEC_ID_AAC,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
-                      AV_CODEC_CAP_SMALL_LAST_FRAME,
+                      AV_CODEC_CAP_SMALL_LAST_FRAME |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(AACEncContext),
     .init           = aac_encode_init,
     FF_CODEC_ENCODE_CB(aac_encode_frame),
@@ -174,6 +174,15 @@ typedef struct AACPCEInfo {
     uint8_t reorder_map[16];                     ///< maps channels from lavc to aac order
 } AACPCEInfo;
 
+/**
+ * Per-channel work item for the threaded coefficient search
+ */
+typedef struct AACEncChannelJob {
+    SingleChannelElement *sce;
+    enum RawDataBlockType type;                  ///< type of the channel element the channel belongs to
+    int alloc;                                   ///< psy bit allocation for the channel
+} AACEncChannelJob;
+
 /**
  * AAC encoder context
  */
@@ -220,6 +229,10 @@ typedef struct AACEncContext {
     struct {
         float *samples;
     } buffer;
+
+    struct AACEncContext *slice_ctx;             ///< per-thread contexts for the coefficient search
+    int nb_slice_ctx;
+    AACEncChannelJob chan_jobs[16];
 } AACEncContext;
 
 void ff_quantize_band_cost_cache_init(struct AACEncContext *s);
@@ -1942,6 +1942,42 @@ typedef struct AVCodecContext {
      * - decoding: Set by libavcodec
      */
     enum AVAlphaMode alpha_mode;
+
+    /**
+     * If non NULL, called by decoders supporting it (currently H.264) when
+     * more rows of the frame being decoded are final, i.e. reconstructed,
+     * deblocked and not going to be modified by the decoder anymore. This
+     * allows processing the top of a frame while its bottom is still being
+     * decoded.
+     *
+     * Unlike draw_horiz_band(), this works with direct rendering (the frame
+     * is backed by the buffers obtained from get_buffer2()) and with frame
+     * and slice threading. For each frame, calls are serialized and report
+     * an increasing number of rows, the last one covering the whole frame.
+     * Frames are reported in decoding order, which may differ from output
+     * order; they can be identified by their buffers or e.g. their pts.
+     *
+     * While error concealment may still be applied to a frame, the rows of a
+     * slice are only reported once the next slice has started. Damaged
+     * streams with overlapping slices can still modify rows already
+     * reported, like they can modify rows already used by other threads
+     * with frame threading.
+     *
+     * When frame threading is used, it may be called from several threads at
+     * the same time for different frames. It is not called for hardware
+     * accelerated decoding, nor for frames to which the decoder applies
+     * film grain.
+     *
+     * - encoding: unused
+     * - decoding: Set by user before avcodec_open2().
+     *
+     * @param frame the frame being decoded; it must not be modified nor
+     *              referenced after the callback returns
+     * @param rows  number of rows from the top of the frame (before cropping)
+     *              that are final, in luma samples
+     */
+    void (*frame_progress)(struct AVCodecContext *s, const AVFrame *frame,
+                           int rows);
 } AVCodecContext;
 
 /**
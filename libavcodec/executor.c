@@ -93,9 +93,10 @@ static int run_one_task(FFExecutor *e, void *lc)
 {
     FFTaskCallbacks *cb = &e->cb;
     FFTask *t = NULL;
+    const int first = cb->first_priority ? cb->first_priority(cb->user_data) : 0;
 
     for (int i = 0; i < e->cb.priorities && !t; i++)
-        t = remove_task(e->q + i);
+        t = remove_task(e->q + (first + i) % e->cb.priorities);
 
     if (t) {
         if (e->thread_count > 0)
@@ -45,6 +45,11 @@ typedef struct FFTaskCallbacks {
 
     // run the task
     int (*run)(FFTask *t, void *local_context, void *user_data);
+
+    // optional, the priority to start looking for a task from when dequeuing;
+    // the priorities are then scanned cyclically, so the order of groups of
+    // priorities can change without requeuing the tasks
+    int (*first_priority)(void *user_data);
 } FFTaskCallbacks;
 
 /**
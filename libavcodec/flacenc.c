@@ -94,15 +94,24 @@ typedef struct FlacSubframe {
 } FlacSubframe;
 
 typedef struct FlacFrame {
-    FlacSubframe subframes[FLAC_MAX_CHANNELS];
     int64_t samples_33bps[FLAC_MAX_BLOCKSIZE];
     int blocksize;
     int bs_code[2];
     uint8_t crc8;
     int ch_mode;
     int verbatim_only;
+    FlacSubframe subframes[];       ///< one per channel
 } FlacFrame;
 
+typedef struct FlacEncodeJob {
+    AVFrame *frame;                 ///< input frame, also provides the packet properties
+    uint32_t frame_count;           ///< coded frame number
+    int max_framesize;
+    uint8_t *buf;                   ///< coded frame
+    unsigned int buf_size;
+    int size;                       ///< size of the coded frame, or an error code
+} FlacEncodeJob;
+
 typedef struct FlacEncodeContext {
     AVClass *class;
     PutBitContext pb;
@@ -117,7 +126,7 @@ typedef struct FlacEncodeContext {
     uint32_t frame_count;
     uint64_t sample_count;
     uint8_t md5sum[16];
-    FlacFrame frame;
+    FlacFrame *frame;
     CompressionOptions options;
     AVCodecContext *avctx;
     LPCContext lpc_ctx;
@@ -129,6 +138,15 @@ typedef struct FlacEncodeContext {
 
     int flushed;
     int64_t next_pts;
+
+    /* frame-parallel encoding with slice threads */
+    struct FlacEncodeContext *slice_ctx;    ///< per-thread frame and LPC state
+    int nb_slice_ctx;
+    FlacEncodeJob *jobs;                    ///< ring of queued and coded frames
+    int nb_jobs;
+    int first_job;
+    int nb_pending;                         ///< number of queued frames not coded yet
+    int nb_coded;                           ///< number of coded frames not output yet
 } FlacEncodeContext;
 
 
@@ -267,6 +285,61 @@ static av_cold void dprint_compression_options(FlacEncodeContext *s)
 }
 
 
+/**
+ * Allocate the coding state of one frame, with subframes for the channels
+ * actually coded only.
+ */
+static FlacFrame *alloc_frame(int channels)
+{
+    return av_mallocz(sizeof(FlacFrame) + channels * sizeof(FlacSubframe));
+}
+
+
+/**
+ * Set up one context per thread for frame-parallel encoding. They share the
+ * settings of the main context but have their own frame and LPC state.
+ */
+static av_cold int init_slice_contexts(AVCodecContext *avctx)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    int ret;
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE))
+        return 0;
+
+    s->slice_ctx = av_malloc_array(avctx->thread_count, sizeof(*s->slice_ctx));
+    s->jobs      = av_calloc(avctx->thread_count, sizeof(*s->jobs));
+    if (!s->slice_ctx || !s->jobs)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < avctx->thread_count; i++) {
+        FlacEncodeContext *t = &s->slice_ctx[i];
+
+        memcpy(t, s, sizeof(*t));
+        t->slice_ctx  = NULL;
+        t->jobs       = NULL;
+        t->md5ctx     = NULL;
+        t->md5_buffer = NULL;
+        t->frame      = alloc_frame(s->channels);
+        if (!t->frame)
+            return AVERROR(ENOMEM);
+        s->nb_slice_ctx++;
+        ret = ff_lpc_init(&t->lpc_ctx, avctx->frame_size,
+                          s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+        if (ret < 0)
+            return ret;
+    }
+
+    for (int i = 0; i < avctx->thread_count; i++) {
+        s->jobs[i].frame = av_frame_alloc();
+        if (!s->jobs[i].frame)
+            return AVERROR(ENOMEM);
+        s->nb_jobs++;
+    }
+
+    return 0;
+}
+
 static av_cold int flac_encode_init(AVCodecContext *avctx)
 {
     int freq = avctx->sample_rate;
@@ -432,6 +505,10 @@ static av_cold int flac_encode_init(AVCodecContext *avctx)
         return AVERROR(ENOMEM);
     av_md5_init(s->md5ctx);
 
+    s->frame = alloc_frame(s->channels);
+    if (!s->frame)
+        return AVERROR(ENOMEM);
+
     streaminfo = av_malloc(FLAC_STREAMINFO_SIZE);
     if (!streaminfo)
         return AVERROR(ENOMEM);
@@ -466,13 +543,15 @@ static av_cold int flac_encode_init(AVCodecContext *avctx)
 
     ret = ff_lpc_init(&s->lpc_ctx, avctx->frame_size,
                       s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+    if (ret < 0)
+        return ret;
 
     ff_bswapdsp_init(&s->bdsp);
     ff_flacencdsp_init(&s->flac_dsp);
 
     dprint_compression_options(s);
 
-    return ret;
+    return init_slice_contexts(avctx);
 }
 
 
@@ -481,7 +560,7 @@ static void init_frame(FlacEncodeContext *s, int nb_samples)
     int i, ch;
     FlacFrame *frame;
 
-    frame = &s->frame;
+    frame = s->frame;
 
     for (i = 0; i < 16; i++) {
         if (nb_samples == ff_flac_blocksize_table[i]) {
@@ -529,7 +608,7 @@ static void copy_samples(FlacEncodeContext *s, const void *samples)
 #define COPY_SAMPLES(bits, shift0) do {                             \
     const int ## bits ## _t *samples0 = samples;                    \
     const int shift = shift0;                                       \
-    frame = &s->frame;                                              \
+    frame = s->frame;                                               \
     for (i = 0, j = 0; i < frame->blocksize; i++)                   \
         for (ch = 0; ch < s->channels; ch++, j++)                   \
             frame->subframes[ch].samples[i] = samples0[j] >> shift; \
@@ -572,7 +651,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
     if (sub->type == FLAC_SUBFRAME_CONSTANT) {
         count += sub->obits;
     } else if (sub->type == FLAC_SUBFRAME_VERBATIM) {
-        count += s->frame.blocksize * sub->obits;
+        count += s->frame->blocksize * sub->obits;
     } else {
         /* warm-up samples */
         count += pred_order * sub->obits;
@@ -586,7 +665,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
 
         /* partition order */
         porder = sub->rc.porder;
-        psize  = s->frame.blocksize >> porder;
+        psize  = s->frame->blocksize >> porder;
         count += 4;
 
         /* residual */
@@ -597,7 +676,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
             count += sub->rc.coding_mode;
             count += rice_count_exact(&sub->residual[i], part_end - i, k);
             i = part_end;
-            part_end = FFMIN(s->frame.blocksize, part_end + psize);
+            part_end = FFMIN(s->frame->blocksize, part_end + psize);
         }
     }
 
@@ -762,15 +841,15 @@ static uint64_t find_subframe_rice_params(FlacEncodeContext *s,
                                           FlacSubframe *sub, int pred_order)
 {
     int pmin = get_max_p_order(s->options.min_partition_order,
-                               s->frame.blocksize, pred_order);
+                               s->frame->blocksize, pred_order);
     int pmax = get_max_p_order(s->options.max_partition_order,
-                               s->frame.blocksize, pred_order);
+                               s->frame->blocksize, pred_order);
 
     uint64_t bits = 8 + pred_order * sub->obits + 2 + sub->rc.coding_mode;
     if (sub->type == FLAC_SUBFRAME_LPC)
         bits += 4 + 5 + pred_order * s->options.lpc_coeff_precision;
     bits += calc_rice_params(&sub->rc, sub->rc_udata, sub->rc_sums, pmin, pmax, sub->residual,
-                             s->frame.blocksize, pred_order, s->options.exact_rice_parameters);
+                             s->frame->blocksize, pred_order, s->options.exact_rice_parameters);
     return bits;
 }
 
@@ -961,7 +1040,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
     int32_t *res, *smp;
     int64_t *smp_33bps;
 
-    frame     = &s->frame;
+    frame     = s->frame;
     sub       = &frame->subframes[ch];
     res       = sub->residual;
     smp       = sub->samples;
@@ -1191,9 +1270,9 @@ static int count_frame_header(FlacEncodeContext *s)
     PUT_UTF8(s->frame_count, tmp, count += 8;)
 
     /* explicit block size */
-    if (s->frame.bs_code[0] == 6)
+    if (s->frame->bs_code[0] == 6)
         count += 8;
-    else if (s->frame.bs_code[0] == 7)
+    else if (s->frame->bs_code[0] == 7)
         count += 16;
 
     /* explicit sample rate */
@@ -1231,12 +1310,12 @@ static void remove_wasted_bits(FlacEncodeContext *s)
     int ch, i, wasted_bits;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &s->frame->subframes[ch];
 
         if (sub->obits > 32) {
             int64_t v = 0;
-            for (i = 0; i < s->frame.blocksize; i++) {
-                v |= s->frame.samples_33bps[i];
+            for (i = 0; i < s->frame->blocksize; i++) {
+                v |= s->frame->samples_33bps[i];
                 if (v & 1)
                     break;
             }
@@ -1248,12 +1327,12 @@ static void remove_wasted_bits(FlacEncodeContext *s)
 
             /* If any wasted bits are found, samples are moved
              * from frame.samples_33bps to frame.subframes[ch] */
-            for (i = 0; i < s->frame.blocksize; i++)
-                sub->samples[i] = s->frame.samples_33bps[i] >> v;
+            for (i = 0; i < s->frame->blocksize; i++)
+                sub->samples[i] = s->frame->samples_33bps[i] >> v;
             wasted_bits = v;
         } else {
             int32_t v = 0;
-            for (i = 0; i < s->frame.blocksize; i++) {
+            for (i = 0; i < s->frame->blocksize; i++) {
                 v |= sub->samples[i];
                 if (v & 1)
                     break;
@@ -1264,7 +1343,7 @@ static void remove_wasted_bits(FlacEncodeContext *s)
 
             v = ff_ctz(v);
 
-            for (i = 0; i < s->frame.blocksize; i++)
+            for (i = 0; i < s->frame->blocksize; i++)
                 sub->samples[i] >>= v;
             wasted_bits = v;
         }
@@ -1343,7 +1422,7 @@ static void channel_decorrelation(FlacEncodeContext *s)
     int64_t *side_33bps;
     int n;
 
-    frame      = &s->frame;
+    frame      = s->frame;
     n          = frame->blocksize;
     left       = frame->subframes[0].samples;
     right      = frame->subframes[1].samples;
@@ -1415,7 +1494,7 @@ static void write_frame_header(FlacEncodeContext *s)
     FlacFrame *frame;
     int crc;
 
-    frame = &s->frame;
+    frame = s->frame;
 
     put_bits(&s->pb, 16, 0xFFF8);
     put_bits(&s->pb, 4, frame->bs_code[0]);
@@ -1471,11 +1550,11 @@ static void write_subframes(FlacEncodeContext *s)
     int ch;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &s->frame->subframes[ch];
         int p, porder, psize;
         int32_t *part_end;
         int32_t *res       =  sub->residual;
-        int32_t *frame_end = &sub->residual[s->frame.blocksize];
+        int32_t *frame_end = &sub->residual[s->frame->blocksize];
 
         /* subframe header */
         put_bits(&s->pb, 1, 0);
@@ -1487,15 +1566,15 @@ static void write_subframes(FlacEncodeContext *s)
         /* subframe */
         if (sub->type == FLAC_SUBFRAME_CONSTANT) {
             if(sub->obits == 33)
-                put_sbits63(&s->pb, 33, s->frame.samples_33bps[0]);
+                put_sbits63(&s->pb, 33, s->frame->samples_33bps[0]);
             else if(sub->obits == 32)
                 put_bits32(&s->pb, res[0]);
             else
                 put_sbits(&s->pb, sub->obits, res[0]);
         } else if (sub->type == FLAC_SUBFRAME_VERBATIM) {
             if (sub->obits == 33) {
-                int64_t *res64 = s->frame.samples_33bps;
-                int64_t *frame_end64 = &s->frame.samples_33bps[s->frame.blocksize];
+                int64_t *res64 = s->frame->samples_33bps;
+                int64_t *frame_end64 = &s->frame->samples_33bps[s->frame->blocksize];
                 while (res64 < frame_end64)
                     put_sbits63(&s->pb, 33, (*res64++));
             } else if (sub->obits == 32) {
@@ -1509,7 +1588,7 @@ static void write_subframes(FlacEncodeContext *s)
             /* warm-up samples */
             if (sub->obits == 33) {
                 for (int i = 0; i < sub->order; i++)
-                    put_sbits63(&s->pb, 33, s->frame.samples_33bps[i]);
+                    put_sbits63(&s->pb, 33, s->frame->samples_33bps[i]);
                 res += sub->order;
             } else if (sub->obits == 32) {
                 for (int i = 0; i < sub->order; i++)
@@ -1533,7 +1612,7 @@ static void write_subframes(FlacEncodeContext *s)
 
             /* partition order */
             porder  = sub->rc.porder;
-            psize   = s->frame.blocksize >> porder;
+            psize   = s->frame->blocksize >> porder;
             put_bits(&s->pb, 4, porder);
 
             /* residual */
@@ -1561,9 +1640,9 @@ static void write_frame_footer(FlacEncodeContext *s)
 }
 
 
-static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
+static int write_frame(FlacEncodeContext *s, uint8_t *buf, int buf_size)
 {
-    init_put_bits(&s->pb, avpkt->data, avpkt->size);
+    init_put_bits(&s->pb, buf, buf_size);
     write_frame_header(s);
     write_subframes(s);
     write_frame_footer(s);
@@ -1574,7 +1653,7 @@ static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
 static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 {
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = s->frame->blocksize * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1595,7 +1674,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < s->frame->blocksize * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             AV_WL24(tmp + 3*i, v);
         }
@@ -1606,7 +1685,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++)
+        for (i = 0; i < s->frame->blocksize * s->channels; i++)
             AV_WL32(tmp + 4*i, samples0[i]);
         buf = s->md5_buffer;
     }
@@ -1616,6 +1695,176 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
+/**
+ * Encode the samples of a frame into s->frame.
+ *
+ * @return size in bytes of the coded frame, or a negative error code
+ */
+static int encode_samples(FlacEncodeContext *s, const AVFrame *frame)
+{
+    int frame_bytes;
+
+    init_frame(s, frame->nb_samples);
+
+    copy_samples(s, frame->data[0]);
+
+    channel_decorrelation(s);
+
+    remove_wasted_bits(s);
+
+    frame_bytes = encode_frame(s);
+
+    /* Fall back on verbatim mode if the compressed frame is larger than it
+       would be if encoded uncompressed. */
+    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
+        s->frame->verbatim_only = 1;
+        frame_bytes = encode_frame(s);
+        if (frame_bytes < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "Bad frame count\n");
+            return frame_bytes;
+        }
+    }
+
+    return frame_bytes;
+}
+
+
+static int set_packet_props(AVCodecContext *avctx, AVPacket *avpkt,
+                            const AVFrame *frame, int out_bytes)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+
+    if (out_bytes > s->max_encoded_framesize)
+        s->max_encoded_framesize = out_bytes;
+    if (out_bytes < s->min_framesize)
+        s->min_framesize = out_bytes;
+
+    avpkt->pts      = frame->pts;
+    avpkt->duration = frame->duration ? frame->duration :
+                      ff_samples_to_time_base(avctx, frame->nb_samples);
+
+    return ff_encode_reordered_opaque(avctx, avpkt, frame);
+}
+
+
+/**
+ * Add a frame to the queue of frames coded in parallel. Everything that
+ * depends on the previous frames is done here, in coding order.
+ */
+static int queue_frame(AVCodecContext *avctx, const AVFrame *frame)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeJob *job = &s->jobs[(s->first_job + s->nb_coded + s->nb_pending) % s->nb_jobs];
+    int ret;
+
+    /* change max_framesize for small final frame */
+    if (frame->nb_samples < s->frame->blocksize) {
+        s->max_framesize = flac_get_max_frame_size(frame->nb_samples,
+                                                   s->channels,
+                                                   avctx->bits_per_raw_sample);
+    }
+
+    init_frame(s, frame->nb_samples);
+
+    if ((ret = av_frame_ref(job->frame, frame)) < 0)
+        return ret;
+    job->frame_count   = s->frame_count;
+    job->max_framesize = s->max_framesize;
+    s->nb_pending++;
+
+    s->frame_count++;
+    s->sample_count += frame->nb_samples;
+    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
+        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+        return ret;
+    }
+
+    s->next_pts = frame->pts + ff_samples_to_time_base(avctx, frame->nb_samples);
+
+    return 0;
+}
+
+
+static int encode_frame_thread(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeContext *t = &s->slice_ctx[threadnr];
+    FlacEncodeJob *job = &s->jobs[(s->first_job + jobnr) % s->nb_jobs];
+    int frame_bytes;
+
+    t->frame_count   = job->frame_count;
+    t->max_framesize = job->max_framesize;
+
+    frame_bytes = encode_samples(t, job->frame);
+    if (frame_bytes < 0) {
+        job->size = frame_bytes;
+        return 0;
+    }
+
+    av_fast_malloc(&job->buf, &job->buf_size, frame_bytes);
+    if (!job->buf) {
+        job->size = AVERROR(ENOMEM);
+        return 0;
+    }
+
+    job->size = write_frame(t, job->buf, frame_bytes);
+    return 0;
+}
+
+
+static int output_job(AVCodecContext *avctx, AVPacket *avpkt, int *got_packet_ptr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeJob *job = &s->jobs[s->first_job];
+    int ret = job->size;
+
+    if (ret >= 0)
+        ret = ff_get_encode_buffer(avctx, avpkt, job->size, 0);
+    if (ret >= 0) {
+        memcpy(avpkt->data, job->buf, job->size);
+        ret = set_packet_props(avctx, avpkt, job->frame, job->size);
+    }
+
+    av_frame_unref(job->frame);
+    s->first_job = (s->first_job + 1) % s->nb_jobs;
+    s->nb_coded--;
+
+    if (ret < 0)
+        return ret;
+
+    *got_packet_ptr = 1;
+    return 0;
+}
+
+
+/**
+ * Frame-parallel encoding: FLAC frames are independent, so the queued frames
+ * are coded concurrently once there is one per thread, and output in order.
+ * This adds a delay of up to one frame per thread.
+ */
+static int encode_frame_parallel(AVCodecContext *avctx, AVPacket *avpkt,
+                                 const AVFrame *frame, int *got_packet_ptr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    int ret;
+
+    if (frame && (ret = queue_frame(avctx, frame)) < 0)
+        return ret;
+
+    if (!s->nb_coded && s->nb_pending &&
+        (s->nb_pending == s->nb_jobs || !frame)) {
+        avctx->execute2(avctx, encode_frame_thread, NULL, NULL, s->nb_pending);
+        s->nb_coded   = s->nb_pending;
+        s->nb_pending = 0;
+    }
+
+    if (s->nb_coded)
+        return output_job(avctx, avpkt, got_packet_ptr);
+
+    return 0;
+}
+
+
 static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                              const AVFrame *frame, int *got_packet_ptr)
 {
@@ -1624,6 +1873,12 @@ static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 
     s = avctx->priv_data;
 
+    if (s->nb_jobs) {
+        ret = encode_frame_parallel(avctx, avpkt, frame, got_packet_ptr);
+        if (ret < 0 || *got_packet_ptr || frame)
+            return ret;
+    }
+
     /* when the last block is reached, update the header in extradata */
     if (!frame) {
         s->max_framesize = s->max_encoded_framesize;
@@ -1647,37 +1902,20 @@ static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     }
 
     /* change max_framesize for small final frame */
-    if (frame->nb_samples < s->frame.blocksize) {
+    if (frame->nb_samples < s->frame->blocksize) {
         s->max_framesize = flac_get_max_frame_size(frame->nb_samples,
                                                    s->channels,
                                                    avctx->bits_per_raw_sample);
     }
 
-    init_frame(s, frame->nb_samples);
-
-    copy_samples(s, frame->data[0]);
-
-    channel_decorrelation(s);
-
-    remove_wasted_bits(s);
-
-    frame_bytes = encode_frame(s);
-
-    /* Fall back on verbatim mode if the compressed frame is larger than it
-       would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
-        if (frame_bytes < 0) {
-            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
-            return frame_bytes;
-        }
-    }
+    frame_bytes = encode_samples(s, frame);
+    if (frame_bytes < 0)
+        return frame_bytes;
 
     if ((ret = ff_get_encode_buffer(avctx, avpkt, frame_bytes, 0)) < 0)
         return ret;
 
-    out_bytes = write_frame(s, avpkt);
+    out_bytes = write_frame(s, avpkt->data, avpkt->size);
 
     s->frame_count++;
     s->sample_count += frame->nb_samples;
@@ -1685,10 +1923,8 @@ static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
         av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
         return ret;
     }
-    if (out_bytes > s->max_encoded_framesize)
-        s->max_encoded_framesize = out_bytes;
-    if (out_bytes < s->min_framesize)
-        s->min_framesize = out_bytes;
+    if ((ret = set_packet_props(avctx, avpkt, frame, out_bytes)) < 0)
+        return ret;
 
     s->next_pts = frame->pts + ff_samples_to_time_base(avctx, frame->nb_samples);
 
@@ -1703,8 +1939,20 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
 {
     FlacEncodeContext *s = avctx->priv_data;
 
+    for (int i = 0; i < s->nb_slice_ctx; i++) {
+        ff_lpc_end(&s->slice_ctx[i].lpc_ctx);
+        av_freep(&s->slice_ctx[i].frame);
+    }
+    av_freep(&s->slice_ctx);
+    for (int i = 0; i < s->nb_jobs; i++) {
+        av_frame_free(&s->jobs[i].frame);
+        av_freep(&s->jobs[i].buf);
+    }
+    av_freep(&s->jobs);
+
     av_freep(&s->md5ctx);
     av_freep(&s->md5_buffer);
+    av_freep(&s->frame);
     ff_lpc_end(&s->lpc_ctx);
     return 0;
 }
@@ -1755,6 +2003,7 @@ const FFCodec ff_flac_encoder = {
     .p.id           = AV_CODEC_ID_FLAC,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
                       AV_CODEC_CAP_SMALL_LAST_FRAME |
+                      AV_CODEC_CAP_SLICE_THREADS |
                       AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
     .priv_data_size = sizeof(FlacEncodeContext),
     .init           = flac_encode_init,
@@ -1762,5 +2011,5 @@ const FFCodec ff_flac_encoder = {
     .close          = flac_encode_close,
     CODEC_SAMPLEFMTS(AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_S32),
     .p.priv_class   = &flac_encoder_class,
-    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_EOF_FLUSH,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
 };
@@ -226,6 +226,8 @@ int ff_h264_field_end(H264Context *h, H264SliceContext *sl, int in_setup)
     if (!in_setup && !h->droppable)
         ff_thread_report_progress(&cur->tf, INT_MAX,
                                   h->picture_structure == PICT_BOTTOM_FIELD);
+    if (!FIELD_PICTURE(h) || !h->first_field)
+        ff_h264_progress_end(h);
     emms_c();
 
     h->current_slice = 0;
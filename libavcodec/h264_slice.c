@@ -1689,6 +1689,8 @@ static int h264_field_start(H264Context *h, const H264SliceContext *sl,
             return ret;
     }
 
+    ff_h264_progress_start(h);
+
     return 0;
 }
 
@@ -2509,6 +2511,55 @@ static void predict_field_decoding_flag(const H264Context *h, H264SliceContext *
     sl->mb_mbaff    = sl->mb_field_decoding_flag = IS_INTERLACED(mb_type) ? 1 : 0;
 }
 
+/**
+ * Number of macroblocks of row mb_y decoded by the slice, up to end_x.
+ */
+static int slice_mbs_in_row(const H264SliceContext *sl, int mb_y, int end_x)
+{
+    return end_x - (mb_y == sl->resync_mb_y ? sl->resync_mb_x : 0);
+}
+
+/**
+ * Update the frame_progress() state once the current MB row of the slice has
+ * been decoded and deblocked. Deblocking a row still modifies the bottom of
+ * the row above, so that one only becomes final now.
+ */
+static void progress_finish_row(const H264Context *h, const H264SliceContext *sl)
+{
+    const int step = 1 + FIELD_OR_MBAFF_PICTURE(h);
+    const int last = sl->mb_y + step >= h->mb_height;
+
+    if (h->nb_slice_ctx_queued <= 1) {
+        /* All macroblocks before this one have been decoded already. */
+        ff_h264_progress_rows_above(h, last ? h->mb_height : sl->mb_y);
+        return;
+    }
+
+    /* Slices decoded concurrently are never deblocked across each other
+     * (see postpone_filter), so each slice accounts for its own macroblocks;
+     * its last rows are accounted for in progress_finish_slice(). */
+    if (sl->mb_y - step >= sl->resync_mb_y)
+        ff_h264_progress_mbs(h, sl->mb_y - step,
+                             slice_mbs_in_row(sl, sl->mb_y - step, h->mb_width));
+    if (last)
+        ff_h264_progress_mbs(h, sl->mb_y,
+                             slice_mbs_in_row(sl, sl->mb_y, h->mb_width));
+}
+
+static void progress_finish_slice(const H264Context *h, const H264SliceContext *sl)
+{
+    const int step = 1 + FIELD_OR_MBAFF_PICTURE(h);
+
+    if (sl->mb_y >= h->mb_height)
+        return;
+    if (sl->mb_y - step >= sl->resync_mb_y)
+        ff_h264_progress_mbs(h, sl->mb_y - step,
+                             slice_mbs_in_row(sl, sl->mb_y - step, h->mb_width));
+    if (sl->mb_x > 0)
+        ff_h264_progress_mbs(h, sl->mb_y,
+                             slice_mbs_in_row(sl, sl->mb_y, sl->mb_x));
+}
+
 /**
  * Draw edges and report progress for the last MB row.
  */
@@ -2536,6 +2587,9 @@ static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
 
     ff_h264_draw_horiz_band(h, sl, top, height);
 
+    if (h->progress && !h->postpone_filter)
+        progress_finish_row(h, sl);
+
     if (h->droppable || h->er.error_occurred)
         return;
 
@@ -2759,6 +2813,8 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
 
 finish:
     sl->deblocking_filter = orig_deblock;
+    if (h->progress && !h->postpone_filter && h->nb_slice_ctx_queued > 1)
+        progress_finish_slice(h, sl);
     return 0;
 }
 
@@ -2787,7 +2843,11 @@ int ff_h264_execute_decode_slices(H264Context *h)
         h->slice_ctx[0].next_slice_idx = h->mb_width * h->mb_height;
         h->postpone_filter = 0;
 
+        if (h->progress)
+            ff_h264_progress_slice_start(h, &h->slice_ctx[0]);
         ret = decode_slice(avctx, &h->slice_ctx[0]);
+        if (h->progress)
+            ff_h264_progress_slice_end(h, &h->slice_ctx[0], ret);
         h->mb_y = h->slice_ctx[0].mb_y;
         if (ret < 0)
             goto finish;
@@ -2815,6 +2875,16 @@ int ff_h264_execute_decode_slices(H264Context *h)
         avctx->execute(avctx, decode_slice, h->slice_ctx,
                        NULL, context_count, sizeof(h->slice_ctx[0]));
 
+        /* Concurrent slices never report rows that another slice still has
+         * to complete, so their order only needs to be checked before the
+         * postponed rows below are reported. */
+        if (h->progress) {
+            for (i = 0; i < context_count; i++) {
+                ff_h264_progress_slice_start(h, &h->slice_ctx[i]);
+                ff_h264_progress_slice_end(h, &h->slice_ctx[i], 0);
+            }
+        }
+
         /* pull back stuff from slices to master context */
         sl                   = &h->slice_ctx[context_count - 1];
         h->mb_y              = sl->mb_y;
@@ -2835,6 +2905,12 @@ int ff_h264_execute_decode_slices(H264Context *h)
                                 j == y_end - 1 ? x_end : h->mb_width);
                 }
             }
+
+            /* The last decoded row is still to be deblocked against the
+             * next slices. */
+            if (h->progress)
+                ff_h264_progress_rows_above(h, h->mb_y >= h->mb_height ? h->mb_height :
+                                            h->mb_y - 1 - FIELD_OR_MBAFF_PICTURE(h));
         }
     }
 
@@ -139,6 +139,144 @@ void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl,
                            y, h->picture_structure, height);
 }
 
+static void progress_report(const H264Context *h, H264Progress *p, int rows)
+{
+    AVCodecContext *avctx = h->avctx;
+    const AVFrame  *f     = h->cur_pic_ptr->f;
+
+    rows = FFMIN(rows, f->height);
+    if (rows <= p->reported)
+        return;
+    p->reported = rows;
+
+    emms_c();
+
+    avctx->frame_progress(avctx, f, rows);
+}
+
+static int progress_active(const H264Context *h)
+{
+    return h->progress && h->cur_pic_ptr && !h->avctx->hwaccel &&
+           !h->cur_pic_ptr->needs_fg;
+}
+
+/**
+ * Advance past the rows of the current picture that are final and report
+ * them; rows of a first field are only reported along with the second one.
+ */
+static void progress_advance(const H264Context *h, H264Progress *p)
+{
+    const int step   = 1 + FIELD_PICTURE(h);
+    const int parity = h->picture_structure == PICT_BOTTOM_FIELD;
+
+    while (p->next_row < h->mb_height &&
+           p->mb_done[p->next_row] >= h->mb_width)
+        p->next_row += step;
+
+    if (h->er.error_occurred || p->broken || (FIELD_PICTURE(h) && h->first_field))
+        return;
+
+    /* k field rows of the second field complete 2 * k frame rows */
+    progress_report(h, p, 16 * (FFMIN(p->next_row, p->safe_row) - parity));
+}
+
+void ff_h264_progress_start(H264Context *h)
+{
+    H264Progress *p = h->progress;
+
+    if (!p)
+        return;
+
+    memset(p->mb_done, 0, h->mb_height * sizeof(*p->mb_done));
+    p->next_row = h->picture_structure == PICT_BOTTOM_FIELD;
+    p->end_mb    = 0;
+    p->slice_row = 0;
+    /* error concealment only runs on frames */
+    p->safe_row  = CONFIG_ERROR_RESILIENCE && h->enable_er && !FIELD_PICTURE(h) &&
+                   h->avctx->error_concealment ? 0 : INT_MAX;
+    if (!FIELD_PICTURE(h) || h->first_field) {
+        p->reported = 0;
+        p->broken   = 0;
+    }
+}
+
+void ff_h264_progress_slice_start(const H264Context *h, const H264SliceContext *sl)
+{
+    H264Progress *p = h->progress;
+
+    if (!progress_active(h))
+        return;
+
+    ff_mutex_lock(&p->mutex);
+    if (sl->first_mb_addr != p->end_mb) {
+        /* the macroblocks in between are missing and will be concealed */
+        p->broken = 1;
+    } else if (p->safe_row != INT_MAX) {
+        /* The previous slices are complete, but concealing this one would
+         * still filter the row above it, and the missing slice handling of
+         * AV_EF_EXPLODE marks the whole previous slice. */
+        int row = h->avctx->err_recognition & AV_EF_EXPLODE ? p->slice_row : sl->mb_y;
+        p->safe_row  = FFMAX(p->safe_row, row - 1);
+        p->slice_row = sl->mb_y;
+        progress_advance(h, p);
+    }
+    ff_mutex_unlock(&p->mutex);
+}
+
+void ff_h264_progress_slice_end(const H264Context *h, const H264SliceContext *sl,
+                                int ret)
+{
+    H264Progress *p = h->progress;
+
+    if (!progress_active(h))
+        return;
+
+    ff_mutex_lock(&p->mutex);
+    if (ret < 0)
+        p->broken = 1;
+    /* sl->mb_x/mb_y is the macroblock following the slice, or the one that
+     * failed to decode; convert it back to a first_mb_addr */
+    p->end_mb = (sl->mb_y >> FIELD_OR_MBAFF_PICTURE(h)) * h->mb_width + sl->mb_x;
+    ff_mutex_unlock(&p->mutex);
+}
+
+void ff_h264_progress_mbs(const H264Context *h, int mb_y, int nb_mbs)
+{
+    H264Progress *p = h->progress;
+
+    if (!progress_active(h) || nb_mbs <= 0)
+        return;
+
+    ff_mutex_lock(&p->mutex);
+    p->mb_done[mb_y] += nb_mbs;
+    if (FRAME_MBAFF(h) && mb_y + 1 < h->mb_height)
+        p->mb_done[mb_y + 1] += nb_mbs;
+    progress_advance(h, p);
+    ff_mutex_unlock(&p->mutex);
+}
+
+void ff_h264_progress_rows_above(const H264Context *h, int mb_y)
+{
+    H264Progress *p = h->progress;
+
+    if (!progress_active(h))
+        return;
+
+    ff_mutex_lock(&p->mutex);
+    for (int y = p->next_row; y < FFMIN(mb_y, h->mb_height); y++)
+        p->mb_done[y] = h->mb_width;
+    progress_advance(h, p);
+    ff_mutex_unlock(&p->mutex);
+}
+
+void ff_h264_progress_end(const H264Context *h)
+{
+    if (!progress_active(h))
+        return;
+
+    progress_report(h, h->progress, INT_MAX);
+}
+
 void ff_h264_free_tables(H264Context *h)
 {
     int i;
@@ -157,6 +295,12 @@ void ff_h264_free_tables(H264Context *h)
     av_freep(&h->mb2b_xy);
     av_freep(&h->mb2br_xy);
 
+    if (h->progress) {
+        ff_mutex_destroy(&h->progress->mutex);
+        av_freep(&h->progress->mb_done);
+        av_freep(&h->progress);
+    }
+
     av_refstruct_pool_uninit(&h->qscale_table_pool);
     av_refstruct_pool_uninit(&h->mb_type_pool);
     av_refstruct_pool_uninit(&h->motion_val_pool);
@@ -219,6 +363,18 @@ int ff_h264_alloc_tables(H264Context *h)
             h->mb2br_xy[mb_xy] = 8 * (FMO ? mb_xy : (mb_xy % (2 * h->mb_stride)));
         }
 
+    if (h->avctx->frame_progress) {
+        h->progress = av_mallocz(sizeof(*h->progress));
+        if (!h->progress)
+            return AVERROR(ENOMEM);
+        if (!FF_ALLOCZ_TYPED_ARRAY(h->progress->mb_done, h->mb_height) ||
+            ff_mutex_init(&h->progress->mutex, NULL)) {
+            av_freep(&h->progress->mb_done);
+            av_freep(&h->progress);
+            return AVERROR(ENOMEM);
+        }
+    }
+
     if (CONFIG_ERROR_RESILIENCE) {
         int y_size  = (2 * h->mb_width + 1) * (2 * h->mb_height + 1);
         int yc_size = y_size + 2 * big_mb_num;
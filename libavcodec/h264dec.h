@@ -29,6 +29,7 @@
 #define AVCODEC_H264DEC_H
 
 #include "libavutil/mem_internal.h"
+#include "libavutil/thread.h"
 
 #include "cabac.h"
 #include "error_resilience.h"
@@ -332,6 +333,29 @@ typedef struct H264SliceContext {
     int max_pic_num;
 } H264SliceContext;
 
+/**
+ * State of AVCodecContext.frame_progress() for the picture being decoded.
+ */
+typedef struct H264Progress {
+    AVMutex mutex;
+    int *mb_done;       ///< number of final macroblocks per macroblock row
+    int  next_row;      ///< first macroblock row of the picture that is not final
+    int  reported;      ///< last number of rows passed to frame_progress()
+    int  end_mb;        ///< first_mb_addr at which the next slice must start
+    int  slice_row;     ///< first macroblock row of the last slice
+    /**
+     * First macroblock row that error concealment may still modify, INT_MAX
+     * if it cannot run on the picture. Rows of a slice are thus only reported
+     * once the next one starts where it ended.
+     */
+    int  safe_row;
+    /**
+     * Set once a slice did not start where the previous one ended or failed
+     * to decode; the rows are then only reported after error concealment.
+     */
+    int  broken;
+} H264Progress;
+
 /**
  * H264Context
  */
@@ -577,6 +601,8 @@ typedef struct H264Context {
     int non_gray;                       ///< Did we encounter a intra frame after a gray gap frame
     int noref_gray;
     int skip_gray;
+
+    H264Progress *progress;             ///< only allocated if AVCodecContext.frame_progress is set
 } H264Context;
 
 extern const uint16_t ff_h264_mb_sizes[4];
@@ -684,6 +710,40 @@ void ff_h264_slice_context_init(H264Context *h, H264SliceContext *sl);
 
 void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl, int y, int height);
 
+/**
+ * Reset the frame_progress() state at the start of a field or frame.
+ */
+void ff_h264_progress_start(H264Context *h);
+
+/**
+ * Mark nb_mbs more macroblocks of row mb_y (of the macroblock pair starting
+ * there for MBAFF) as final and report the rows that became final.
+ */
+void ff_h264_progress_mbs(const H264Context *h, int mb_y, int nb_mbs);
+
+/**
+ * Mark all macroblock rows above mb_y as final and report them.
+ */
+void ff_h264_progress_rows_above(const H264Context *h, int mb_y);
+
+/**
+ * Check that the slice starts where the previous one in decoding order ended.
+ * Must be called before the slice is decoded, unless it is decoded
+ * concurrently with other slices.
+ */
+void ff_h264_progress_slice_start(const H264Context *h, const H264SliceContext *sl);
+
+/**
+ * Record where the slice ended, or that its decoding failed if ret < 0.
+ */
+void ff_h264_progress_slice_end(const H264Context *h, const H264SliceContext *sl,
+                                int ret);
+
+/**
+ * Report the whole frame as final once it has been completely decoded.
+ */
+void ff_h264_progress_end(const H264Context *h);
+
 /**
  * Submit a slice for decoding.
  *
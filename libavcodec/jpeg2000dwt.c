@@ -25,6 +25,8 @@
  * Discrete wavelet transform
  */
 
+#include <string.h>
+
 #include "libavutil/error.h"
 #include "libavutil/macros.h"
 #include "libavutil/mem.h"
@@ -74,72 +76,190 @@ static inline void extend97_int(int32_t *p, int i0, int i1)
     }
 }
 
-static void sd_1d53(int *p, int i0, int i1)
+/** Mirror the sample index i into [i0, i1), with i1 - i0 >= 2. */
+static inline int reflect(int i, int i0, int i1)
 {
-    int i;
+    while (i < i0 || i >= i1)
+        i = i < i0 ? 2 * i0 - i : 2 * (i1 - 1) - i;
+    return i;
+}
 
-    if (i1 <= i0 + 1) {
-        if (i0 == 1)
-            p[1] *= 2;
+/** Forward transform of a line made of a single sample at position i0. */
+static inline int32_t sd_single(int type, int i0, int32_t v)
+{
+    if (type == FF_DWT53)
+        return i0 == 1 ? v * 2 : v;
+    if (i0 == 1)
+        return (v * I_LFTG_X + (1<<14)) >> 15;
+    return (v * I_LFTG_K + (1<<15)) >> 16;
+}
+
+/**
+ * Forward lifting step over len samples: dst[i] is updated from the sum of
+ * its two neighbours src0[i] and src1[i].
+ */
+typedef void (*lift_func)(int32_t *dst, const int32_t *src0,
+                          const int32_t *src1, int len);
+
+/* forward DWT lifting steps */
+static void sd53_predict_c(int32_t *dst, const int32_t *src0,
+                           const int32_t *src1, int len)
+{
+    for (int i = 0; i < len; i++)
+        dst[i] -= (src0[i] + src1[i]) >> 1;
+}
+
+static void sd53_update_c(int32_t *dst, const int32_t *src0,
+                          const int32_t *src1, int len)
+{
+    for (int i = 0; i < len; i++)
+        dst[i] += (src0[i] + src1[i] + 2) >> 2;
+}
+
+static void sd97_int_alpha_c(int32_t *dst, const int32_t *src0,
+                             const int32_t *src1, int len)
+{
+    for (int i = 0; i < len; i++) {
+        const int64_t sum = src0[i] + src1[i];
+        dst[i] -= sum;
+        dst[i] -= (I_LFTG_ALPHA_PRIME * sum + (1 << 15)) >> 16;
+    }
+}
+
+static void sd97_int_beta_c(int32_t *dst, const int32_t *src0,
+                            const int32_t *src1, int len)
+{
+    for (int i = 0; i < len; i++)
+        dst[i] -= (I_LFTG_BETA  * (src0[i] + src1[i]) + (1 << 15)) >> 16;
+}
+
+static void sd97_int_gamma_c(int32_t *dst, const int32_t *src0,
+                             const int32_t *src1, int len)
+{
+    for (int i = 0; i < len; i++)
+        dst[i] += (I_LFTG_GAMMA * (src0[i] + src1[i]) + (1 << 15)) >> 16;
+}
+
+static void sd97_int_delta_c(int32_t *dst, const int32_t *src0,
+                             const int32_t *src1, int len)
+{
+    for (int i = 0; i < len; i++)
+        dst[i] += (I_LFTG_DELTA * (src0[i] + src1[i]) + (1 << 15)) >> 16;
+}
+
+static const lift_func sd53_steps[2] = {
+    sd53_predict_c, sd53_update_c,
+};
+
+static const lift_func sd97_int_steps[4] = {
+    sd97_int_alpha_c, sd97_int_beta_c, sd97_int_gamma_c, sd97_int_delta_c,
+};
+
+/**
+ * Vertical forward lifting of lv rows of lh samples. The steps update the
+ * odd and the even rows in turn from their two neighbours, in place, then
+ * the low-pass rows are gathered above the high-pass ones.
+ */
+static void sd_ver(DWTContext *s, int32_t *t, int w, int lh, int lv, int mv,
+                   const lift_func *steps, int nb_steps)
+{
+    int i0 = mv, i1 = mv + lv, nl = (i1 + 1 >> 1) - (i0 + 1 >> 1);
+    int step, i, j;
+
+    if (lv <= 1) {
+        for (i = 0; i < lh * lv; i++)
+            t[i] = sd_single(s->type, i0, t[i]);
         return;
     }
 
-    extend53(p, i0, i1);
+    for (step = 0; step < nb_steps; step++) {
+        for (i = (step & 1) ? i0 + (i0 & 1) : i0 | 1; i < i1; i += 2) {
+            const int32_t *src0 = t + w * (reflect(i - 1, i0, i1) - i0);
+            const int32_t *src1 = t + w * (reflect(i + 1, i0, i1) - i0);
+            steps[step](t + w * (i - i0), src0, src1, lh);
+        }
+    }
 
-    for (i = ((i0+1)>>1) - 1; i < (i1+1)>>1; i++)
-        p[2*i+1] -= (p[2*i] + p[2*i+2]) >> 1;
-    for (i = ((i0+1)>>1); i < (i1+1)>>1; i++)
-        p[2*i] += (p[2*i-1] + p[2*i+1] + 2) >> 2;
+    // deinterleave
+    for (i = i0 | 1, j = 0; i < i1; i += 2, j++)
+        memcpy(s->i_rowbuf + lh * j, t + w * (i - i0), lh * sizeof(*t));
+    for (i = i0 + (i0 & 1), j = 0; i < i1; i += 2, j++)
+        if (i - i0 != j)
+            memcpy(t + w * j, t + w * (i - i0), lh * sizeof(*t));
+    for (j = 0; j < lv - nl; j++)
+        memcpy(t + w * (nl + j), s->i_rowbuf + lh * j, lh * sizeof(*t));
+}
+
+/**
+ * Horizontal forward lifting of lv rows of lh samples. The even and odd
+ * samples of each row are split into l and h, padded by one mirrored sample
+ * on both sides for the steps, and written back low-pass first.
+ */
+static void sd_hor(DWTContext *s, int32_t *t, int w, int lh, int lv, int mh,
+                   const lift_func *steps, int nb_steps)
+{
+    int i0 = mh, i1 = mh + lh, e0 = i0 + (i0 & 1), o0 = i0 | 1, off = i0 & 1;
+    int nl = (i1 + 1 >> 1) - (i0 + 1 >> 1), nh = lh - nl;
+    int32_t *l = s->i_linebuf + 1, *h = l + nl + 2;
+    int lpad0, lpad1, hpad0, hpad1, lp, step, i;
+
+    if (lh <= 1) {
+        for (lp = 0; lp < lv * lh; lp++)
+            t[w * lp] = sd_single(s->type, i0, t[w * lp]);
+        return;
+    }
+
+    // positions in l and h of the samples mirrored into the padding
+    lpad0 = reflect(e0 - 2,      i0, i1) - e0 >> 1;
+    lpad1 = reflect(e0 + 2 * nl, i0, i1) - e0 >> 1;
+    hpad0 = reflect(o0 - 2,      i0, i1) - o0 >> 1;
+    hpad1 = reflect(o0 + 2 * nh, i0, i1) - o0 >> 1;
+
+    for (lp = 0; lp < lv; lp++) {
+        int32_t *row = t + w * lp;
+
+        for (i = 0; i < nl; i++)
+            l[i] = row[e0 - i0 + 2 * i];
+        for (i = 0; i < nh; i++)
+            h[i] = row[o0 - i0 + 2 * i];
+        l[-1] = l[lpad0];
+        l[nl] = l[lpad1];
+        h[-1] = h[hpad0];
+        h[nh] = h[hpad1];
+
+        for (step = 0; step < nb_steps; step++) {
+            if (step & 1) {
+                steps[step](l, h - 1 + off, h + off, nl);
+                l[-1] = l[lpad0];
+                l[nl] = l[lpad1];
+            } else {
+                steps[step](h, l - off, l + 1 - off, nh);
+                h[-1] = h[hpad0];
+                h[nh] = h[hpad1];
+            }
+        }
+
+        memcpy(row,      l, nl * sizeof(*row));
+        memcpy(row + nl, h, nh * sizeof(*row));
+    }
 }
 
 static void dwt_encode53(DWTContext *s, int *t)
 {
     int lev,
         w = s->linelen[s->ndeclevels-1][0];
-    int *line = s->i_linebuf;
-    line += 3;
 
     for (lev = s->ndeclevels-1; lev >= 0; lev--){
         int lh = s->linelen[lev][0],
             lv = s->linelen[lev][1],
             mh = s->mod[lev][0],
-            mv = s->mod[lev][1],
-            lp;
-        int *l;
+            mv = s->mod[lev][1];
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
-
-            for (i = 0; i < lv; i++)
-                l[i] = t[w*i + lp];
-
-            sd_1d53(line, mv, mv + lv);
-
-            // copy back and deinterleave
-            for (i =   mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
-            for (i = 1-mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
-        }
+        sd_ver(s, t, w, lh, lv, mv, sd53_steps, 2);
 
         // HOR_SD
-        l = line + mh;
-        for (lp = 0; lp < lv; lp++){
-            int i, j = 0;
-
-            for (i = 0; i < lh; i++)
-                l[i] = t[w*lp + i];
-
-            sd_1d53(line, mh, mh + lh);
-
-            // copy back and deinterleave
-            for (i =   mh; i < lh; i+=2, j++)
-                t[w*lp + j] = l[i];
-            for (i = 1-mh; i < lh; i+=2, j++)
-                t[w*lp + j] = l[i];
-        }
+        sd_hor(s, t, w, lh, lv, mh, sd53_steps, 2);
     }
 }
 static void sd_1d97_float(float *p, int i0, int i1)
@@ -218,42 +338,12 @@ static void dwt_encode97_float(DWTContext *s, float *t)
     }
 }
 
-static void sd_1d97_int(int *p, int i0, int i1)
-{
-    int i;
-
-    if (i1 <= i0 + 1) {
-        if (i0 == 1)
-            p[1] = (p[1] * I_LFTG_X + (1<<14)) >> 15;
-        else
-            p[0] = (p[0] * I_LFTG_K + (1<<15)) >> 16;
-        return;
-    }
-
-    extend97_int(p, i0, i1);
-    i0++; i1++;
-
-    for (i = (i0>>1) - 2; i < (i1>>1) + 1; i++) {
-        const int64_t sum = p[2 * i] + p[2 * i + 2];
-        p[2 * i + 1] -= sum;
-        p[2 * i + 1] -= (I_LFTG_ALPHA_PRIME * sum + (1 << 15)) >> 16;
-    }
-    for (i = (i0>>1) - 1; i < (i1>>1) + 1; i++)
-        p[2 * i]     -= (I_LFTG_BETA  * (p[2 * i - 1] + p[2 * i + 1]) + (1 << 15)) >> 16;
-    for (i = (i0>>1) - 1; i < (i1>>1); i++)
-        p[2 * i + 1] += (I_LFTG_GAMMA * (p[2 * i]     + p[2 * i + 2]) + (1 << 15)) >> 16;
-    for (i = (i0>>1); i < (i1>>1); i++)
-        p[2 * i]     += (I_LFTG_DELTA * (p[2 * i - 1] + p[2 * i + 1]) + (1 << 15)) >> 16;
-}
-
 static void dwt_encode97_int(DWTContext *s, int *t)
 {
     int lev;
     int w = s->linelen[s->ndeclevels-1][0];
     int h = s->linelen[s->ndeclevels-1][1];
     int i;
-    int *line = s->i_linebuf;
-    line += 5;
 
     for (i = 0; i < w * h; i++)
         t[i] *= 1 << I_PRESHIFT;
@@ -262,44 +352,13 @@ static void dwt_encode97_int(DWTContext *s, int *t)
         int lh = s->linelen[lev][0],
             lv = s->linelen[lev][1],
             mh = s->mod[lev][0],
-            mv = s->mod[lev][1],
-            lp;
-        int *l;
+            mv = s->mod[lev][1];
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
-
-            for (i = 0; i < lv; i++)
-                l[i] = t[w*i + lp];
-
-            sd_1d97_int(line, mv, mv + lv);
-
-            // copy back and deinterleave
-            for (i =   mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
-            for (i = 1-mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
-        }
+        sd_ver(s, t, w, lh, lv, mv, sd97_int_steps, 4);
 
         // HOR_SD
-        l = line + mh;
-        for (lp = 0; lp < lv; lp++){
-            int i, j = 0;
-
-            for (i = 0; i < lh; i++)
-                l[i] = t[w*lp + i];
-
-            sd_1d97_int(line, mh, mh + lh);
-
-            // copy back and deinterleave
-            for (i =   mh; i < lh; i+=2, j++)
-                t[w*lp + j] = l[i];
-            for (i = 1-mh; i < lh; i+=2, j++)
-                t[w*lp + j] = l[i];
-        }
-
+        sd_hor(s, t, w, lh, lv, mh, sd97_int_steps, 4);
     }
 
     for (i = 0; i < w * h; i++)
@@ -585,6 +644,14 @@ int ff_dwt_encode(DWTContext *s, void *t)
     if (s->ndeclevels == 0)
         return 0;
 
+    if (s->type != FF_DWT97 && !s->i_rowbuf) {
+        int w = s->linelen[s->ndeclevels - 1][0];
+        int h = s->linelen[s->ndeclevels - 1][1];
+        s->i_rowbuf = av_malloc_array(w, (h + 1 >> 1) * sizeof(*s->i_rowbuf));
+        if (!s->i_rowbuf)
+            return AVERROR(ENOMEM);
+    }
+
     switch(s->type){
         case FF_DWT97:
             dwt_encode97_float(s, t); break;
@@ -623,4 +690,5 @@ void ff_dwt_destroy(DWTContext *s)
 {
     av_freep(&s->f_linebuf);
     av_freep(&s->i_linebuf);
+    av_freep(&s->i_rowbuf);
 }
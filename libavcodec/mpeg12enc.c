@@ -1248,7 +1248,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
       OFFSET(scan_offset),         AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, VE }, \
     { "timecode_frame_start", "GOP timecode frame start number, in non-drop-frame format", \
       OFFSET(timecode_frame_start), AV_OPT_TYPE_INT64, {.i64 = -1 }, -1, INT64_MAX, VE}, \
-    FF_MPV_COMMON_BFRAME_OPTS
+    FF_MPV_COMMON_BFRAME_OPTS \
+    FF_MPV_COMMON_LOOKAHEAD_OPTS
 
 static const AVOption mpeg1_options[] = {
     COMMON_OPTS
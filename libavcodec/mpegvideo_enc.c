@@ -620,12 +620,19 @@ av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
     /* Fixed QSCALE */
     m->fixed_qscale = !!(avctx->flags & AV_CODEC_FLAG_QSCALE);
 
+    if (m->lookahead.depth && m->fixed_qscale) {
+        av_log(avctx, AV_LOG_WARNING,
+               "rc_lookahead has no effect with a fixed quantizer, disabling it\n");
+        m->lookahead.depth = 0;
+    }
+
     s->adaptive_quant = (avctx->lumi_masking ||
                          avctx->dark_masking ||
                          avctx->temporal_cplx_masking ||
                          avctx->spatial_cplx_masking  ||
                          avctx->p_masking      ||
                          m->border_masking ||
+                         m->lookahead.depth ||
                          (s->mpv_flags & FF_MPV_FLAG_QP_RD)) &&
                         !m->fixed_qscale;
 
@@ -1058,6 +1065,14 @@ av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
     if (ret < 0)
         return ret;
 
+    if (m->lookahead.depth) {
+        ret = ff_mpv_lookahead_init(&m->lookahead, avctx,
+                                    s->c.mb_width, s->c.mb_height);
+        if (ret < 0)
+            return ret;
+        avctx->delay += m->lookahead.depth;
+    }
+
     if (m->b_frame_strategy == 2) {
         for (int i = 0; i < m->max_b_frames + 2; i++) {
             m->tmp_frames[i] = av_frame_alloc();
@@ -1091,6 +1106,7 @@ av_cold int ff_mpv_encode_end(AVCodecContext *avctx)
     MPVEncContext    *const s = &m->s;
 
     ff_rate_control_uninit(&m->rc_context);
+    ff_mpv_lookahead_uninit(&m->lookahead);
 
     ff_mpv_common_end(&s->c);
     av_refstruct_pool_uninit(&s->c.picture_pool);
@@ -1899,8 +1915,8 @@ static void frame_start(MPVMainEncContext *const m)
     }
 }
 
-int ff_mpv_encode_picture(AVCodecContext *avctx, AVPacket *pkt,
-                          const AVFrame *pic_arg, int *got_packet)
+static int encode_input_picture(AVCodecContext *avctx, AVPacket *pkt,
+                                const AVFrame *pic_arg, int *got_packet)
 {
     MPVMainEncContext *const m = avctx->priv_data;
     MPVEncContext    *const s = &m->s;
@@ -2128,6 +2144,39 @@ vbv_retry:
     return 0;
 }
 
+int ff_mpv_encode_picture(AVCodecContext *avctx, AVPacket *pkt,
+                          const AVFrame *pic_arg, int *got_packet)
+{
+    MPVMainEncContext *const m = avctx->priv_data;
+    AVFrame *frame;
+    int ret;
+
+    if (!m->lookahead.depth)
+        return encode_input_picture(avctx, pkt, pic_arg, got_packet);
+
+    ret = ff_mpv_lookahead_send_frame(&m->lookahead, pic_arg);
+    if (ret < 0)
+        return ret;
+
+    *got_packet = 0;
+    do {
+        ret = ff_mpv_lookahead_receive_frame(&m->lookahead, &frame);
+        if (ret < 0)
+            return ret;
+        /* still filling the lookahead */
+        if (!frame && pic_arg)
+            return 0;
+
+        ret = encode_input_picture(avctx, pkt, frame, got_packet);
+        if (!frame)
+            break;
+        av_frame_free(&frame);
+        /* when draining, keep feeding the encoder until it returns a packet */
+    } while (ret >= 0 && !*got_packet && !pic_arg);
+
+    return ret;
+}
+
 static inline void dct_single_coeff_elimination(MPVEncContext *const s,
                                                 int n, int threshold)
 {
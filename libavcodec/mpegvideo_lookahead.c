@@ -0,0 +1,354 @@
+/*
+ * Frame lookahead for the mpegvideo encoders
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Frame lookahead and macroblock-tree analysis for the mpegvideo encoders.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/avassert.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+
+#include "mpegvideo_lookahead.h"
+
+#define LOWRES_PAD     32   ///< edge padding of the lowres planes, in lowres pixels
+#define INTRA_BIAS     32   ///< rough cost of coding a block header
+#define MV_PENALTY      4   ///< cost per lowres pixel of motion vector length
+#define MAX_ITERATIONS 16
+
+av_cold int ff_mpv_lookahead_init(MPVLookaheadContext *la, AVCodecContext *avctx,
+                                  int mb_width, int mb_height)
+{
+    MECmpContext mecc;
+    size_t lowres_size;
+
+    la->avctx         = avctx;
+    la->mb_width      = mb_width;
+    la->mb_height     = mb_height;
+    la->mb_num        = mb_width * mb_height;
+    la->width         = avctx->width;
+    la->height        = avctx->height;
+    la->lowres_width  = mb_width  * 8;
+    la->lowres_height = mb_height * 8;
+    la->lowres_stride = FFALIGN(la->lowres_width + 2 * LOWRES_PAD, 32);
+    lowres_size       = la->lowres_stride * (la->lowres_height + 2 * LOWRES_PAD);
+
+    ff_me_cmp_init(&mecc, avctx);
+    la->sad = mecc.sad[1];
+
+    la->frames = av_calloc(la->depth + 1, sizeof(*la->frames));
+    if (!la->frames)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i <= la->depth; i++) {
+        MPVLookaheadFrame *const frame = &la->frames[i];
+
+        frame->f           = av_frame_alloc();
+        frame->lowres_base = av_malloc(lowres_size);
+        frame->intra_cost  = av_malloc_array(la->mb_num, sizeof(*frame->intra_cost));
+        frame->inter_cost  = av_malloc_array(la->mb_num, sizeof(*frame->inter_cost));
+        frame->mv          = av_malloc_array(la->mb_num, sizeof(*frame->mv));
+        frame->propagate   = av_malloc_array(la->mb_num, sizeof(*frame->propagate));
+        if (!frame->f || !frame->lowres_base || !frame->intra_cost ||
+            !frame->inter_cost || !frame->mv || !frame->propagate)
+            return AVERROR(ENOMEM);
+        frame->lowres = frame->lowres_base + LOWRES_PAD * la->lowres_stride + LOWRES_PAD;
+    }
+
+    for (int i = 0; i < MPV_LOOKAHEAD_WEIGHTS; i++) {
+        la->weights[i] = av_malloc_array(la->mb_num, sizeof(*la->weights[i]));
+        if (!la->weights[i])
+            return AVERROR(ENOMEM);
+        la->weights_pic[i] = -1;
+    }
+
+    return 0;
+}
+
+av_cold void ff_mpv_lookahead_uninit(MPVLookaheadContext *la)
+{
+    if (la->frames) {
+        for (int i = 0; i <= la->depth; i++) {
+            MPVLookaheadFrame *const frame = &la->frames[i];
+
+            av_frame_free(&frame->f);
+            av_freep(&frame->lowres_base);
+            av_freep(&frame->intra_cost);
+            av_freep(&frame->inter_cost);
+            av_freep(&frame->mv);
+            av_freep(&frame->propagate);
+        }
+        av_freep(&la->frames);
+    }
+    for (int i = 0; i < MPV_LOOKAHEAD_WEIGHTS; i++)
+        av_freep(&la->weights[i]);
+}
+
+static void downscale_rows(const MPVLookaheadContext *la, uint8_t *dst,
+                           const AVFrame *src, int y0, int h)
+{
+    const ptrdiff_t stride = src->linesize[0];
+
+    for (int y = y0; y < y0 + h; y++) {
+        const uint8_t *src0 = src->data[0] + FFMIN(2 * y,     la->height - 1) * stride;
+        const uint8_t *src1 = src->data[0] + FFMIN(2 * y + 1, la->height - 1) * stride;
+        uint8_t *d = dst + y * la->lowres_stride;
+        int x = 0;
+
+        for (; 2 * x + 1 < la->width; x++)
+            d[x] = (src0[2 * x] + src0[2 * x + 1] +
+                    src1[2 * x] + src1[2 * x + 1] + 2) >> 2;
+        for (; x < la->lowres_width; x++) {
+            const int sx = FFMIN(2 * x, la->width - 1);
+            d[x] = (src0[sx] + src1[sx] + 1) >> 1;
+        }
+    }
+}
+
+static void pad_edges(const MPVLookaheadContext *la, uint8_t *plane)
+{
+    const ptrdiff_t stride = la->lowres_stride;
+    const int w = la->lowres_width, h = la->lowres_height;
+
+    for (int y = 0; y < h; y++) {
+        uint8_t *row = plane + y * stride;
+        memset(row - LOWRES_PAD, row[0],     LOWRES_PAD);
+        memset(row + w,          row[w - 1], LOWRES_PAD);
+    }
+    for (int y = 1; y <= LOWRES_PAD; y++) {
+        memcpy(plane - y * stride - LOWRES_PAD, plane - LOWRES_PAD,
+               w + 2 * LOWRES_PAD);
+        memcpy(plane + (h - 1 + y) * stride - LOWRES_PAD,
+               plane + (h - 1) * stride - LOWRES_PAD, w + 2 * LOWRES_PAD);
+    }
+}
+
+static int intra_cost(const uint8_t *block, ptrdiff_t stride)
+{
+    int sum = 0, mean, cost = INTRA_BIAS;
+
+    for (int y = 0; y < 8; y++)
+        for (int x = 0; x < 8; x++)
+            sum += block[x + y * stride];
+    mean = (sum + 32) >> 6;
+    for (int y = 0; y < 8; y++)
+        for (int x = 0; x < 8; x++)
+            cost += FFABS(block[x + y * stride] - mean);
+
+    return cost;
+}
+
+/* The motion search is done here rather than with motion_est.c, because
+ * the latter works on full resolution pictures and keeps its state in the
+ * MpegEncContext of the frame being coded: its candidates, penalties and
+ * search ranges depend on the f_code and on the picture type, which are not
+ * known yet when a frame enters the lookahead. A small diamond search on
+ * 8x8 blocks of the half resolution planes is enough for the cost estimates
+ * of the macroblock-tree. */
+static int analyse_row(AVCodecContext *avctx, void *arg, int mb_y, int threadnr)
+{
+    MPVLookaheadContext *const la = arg;
+    MPVLookaheadFrame *const cur  = la->cur;
+    const MPVLookaheadFrame *const prev = la->prev;
+    const ptrdiff_t stride = la->lowres_stride;
+
+    downscale_rows(la, cur->lowres, la->src, mb_y * 8, 8);
+
+    for (int mb_x = 0; mb_x < la->mb_width; mb_x++) {
+        const int mb_xy = mb_y * la->mb_width + mb_x;
+        const int x = mb_x * 8, y = mb_y * 8;
+        const uint8_t *block = cur->lowres + y * stride + x;
+        const int xmin = -LOWRES_PAD - x, xmax = la->lowres_width  + LOWRES_PAD - 8 - x;
+        const int ymin = -LOWRES_PAD - y, ymax = la->lowres_height + LOWRES_PAD - 8 - y;
+        int16_t cand[3][2] = { { 0 } };
+        int nb_cand = 1, best_cost = INT_MAX, bx = 0, by = 0;
+        int intra = intra_cost(block, stride);
+
+        cur->intra_cost[mb_xy] = intra;
+        if (!prev) {
+            cur->inter_cost[mb_xy] = intra;
+            cur->mv[mb_xy][0] = cur->mv[mb_xy][1] = 0;
+            continue;
+        }
+
+        if (mb_x > 0) {
+            cand[nb_cand][0] = cur->mv[mb_xy - 1][0];
+            cand[nb_cand][1] = cur->mv[mb_xy - 1][1];
+            nb_cand++;
+        }
+        cand[nb_cand][0] = prev->mv[mb_xy][0];
+        cand[nb_cand][1] = prev->mv[mb_xy][1];
+        nb_cand++;
+
+#define CHECK_MV(mx, my)                                                     \
+        if ((mx) >= xmin && (mx) <= xmax && (my) >= ymin && (my) <= ymax) {  \
+            const uint8_t *ref = prev->lowres + (y + (my)) * stride + x + (mx); \
+            int cost = la->sad(NULL, block, ref, stride, 8) +                \
+                       MV_PENALTY * (FFABS(mx) + FFABS(my));                  \
+            if (cost < best_cost) {                                          \
+                best_cost = cost;                                            \
+                bx = (mx);                                                   \
+                by = (my);                                                   \
+            }                                                                \
+        }
+
+        for (int i = 0; i < nb_cand; i++)
+            CHECK_MV(cand[i][0], cand[i][1]);
+
+        for (int i = 0; i < MAX_ITERATIONS; i++) {
+            const int cx = bx, cy = by;
+
+            CHECK_MV(cx - 1, cy);
+            CHECK_MV(cx + 1, cy);
+            CHECK_MV(cx, cy - 1);
+            CHECK_MV(cx, cy + 1);
+            if (bx == cx && by == cy)
+                break;
+        }
+#undef CHECK_MV
+
+        cur->inter_cost[mb_xy] = FFMIN(best_cost, intra);
+        cur->mv[mb_xy][0] = bx;
+        cur->mv[mb_xy][1] = by;
+    }
+
+    return 0;
+}
+
+int ff_mpv_lookahead_send_frame(MPVLookaheadContext *la, const AVFrame *frame)
+{
+    MPVLookaheadFrame *cur;
+    int ret;
+
+    if (!frame) {
+        la->eof = 1;
+        return 0;
+    }
+
+    av_assert0(la->nb_frames <= la->depth);
+    cur = &la->frames[la->nb_frames];
+
+    ret = av_frame_ref(cur->f, frame);
+    if (ret < 0)
+        return ret;
+
+    la->cur  = cur;
+    la->prev = la->nb_frames ? &la->frames[la->nb_frames - 1] : NULL;
+    la->src  = frame;
+    la->avctx->execute2(la->avctx, analyse_row, la, NULL, la->mb_height);
+    pad_edges(la, cur->lowres);
+
+    la->nb_frames++;
+
+    return 0;
+}
+
+static void propagate(const MPVLookaheadContext *la,
+                      const MPVLookaheadFrame *cur, MPVLookaheadFrame *ref)
+{
+    for (int mb_y = 0; mb_y < la->mb_height; mb_y++) {
+        for (int mb_x = 0; mb_x < la->mb_width; mb_x++) {
+            const int mb_xy = mb_y * la->mb_width + mb_x;
+            const int intra = cur->intra_cost[mb_xy];
+            const int inter = cur->inter_cost[mb_xy];
+            const int x = mb_x * 8 + cur->mv[mb_xy][0];
+            const int y = mb_y * 8 + cur->mv[mb_xy][1];
+            const int rx = x >> 3, fx = x & 7;
+            const int ry = y >> 3, fy = y & 7;
+            float amount;
+
+            if (inter >= intra)
+                continue;
+
+            /* the fraction of the information in this block that is
+             * inherited from the reference frame */
+            amount = (intra + cur->propagate[mb_xy]) * (intra - inter) /
+                     (intra * 64.0f);
+
+            for (int j = 0; j < 2; j++) {
+                const int yy = ry + j;
+                const int wy = j ? fy : 8 - fy;
+
+                if (yy < 0 || yy >= la->mb_height || !wy)
+                    continue;
+                for (int i = 0; i < 2; i++) {
+                    const int xx = rx + i;
+                    const int wx = i ? fx : 8 - fx;
+
+                    if (xx < 0 || xx >= la->mb_width || !wx)
+                        continue;
+                    ref->propagate[yy * la->mb_width + xx] += amount * wx * wy;
+                }
+            }
+        }
+    }
+}
+
+int ff_mpv_lookahead_receive_frame(MPVLookaheadContext *la, AVFrame **frame)
+{
+    MPVLookaheadFrame tmp;
+    const MPVLookaheadFrame *first = &la->frames[0];
+    const int slot = la->nb_output % MPV_LOOKAHEAD_WEIGHTS;
+    const float exponent = la->strength / 6.0f;
+    float *weights = la->weights[slot];
+
+    *frame = NULL;
+    if (!la->nb_frames || (!la->eof && la->nb_frames <= la->depth))
+        return 0;
+
+    *frame = av_frame_alloc();
+    if (!*frame)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < la->nb_frames; i++)
+        memset(la->frames[i].propagate, 0,
+               la->mb_num * sizeof(*la->frames[i].propagate));
+    for (int i = la->nb_frames - 1; i > 0; i--)
+        propagate(la, &la->frames[i], &la->frames[i - 1]);
+
+    /* lower the qscale of a macroblock by strength/6 octaves each time
+     * the amount of information the following frames take from it doubles */
+    for (int i = 0; i < la->mb_num; i++)
+        weights[i] = powf(1.0f + first->propagate[i] / first->intra_cost[i],
+                          exponent);
+    la->weights_pic[slot] = la->nb_output++;
+
+    av_frame_move_ref(*frame, la->frames[0].f);
+    tmp = la->frames[0];
+    memmove(&la->frames[0], &la->frames[1],
+            (la->nb_frames - 1) * sizeof(*la->frames));
+    la->frames[--la->nb_frames] = tmp;
+
+    return 0;
+}
+
+const float *ff_mpv_lookahead_weights(const MPVLookaheadContext *la, int n)
+{
+    const int slot = n % MPV_LOOKAHEAD_WEIGHTS;
+
+    if (!la->frames || n < 0 || la->weights_pic[slot] != n)
+        return NULL;
+    return la->weights[slot];
+}
@@ -0,0 +1,106 @@
+/*
+ * Frame lookahead for the mpegvideo encoders
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_MPEGVIDEO_LOOKAHEAD_H
+#define AVCODEC_MPEGVIDEO_LOOKAHEAD_H
+
+/**
+ * @file
+ * Frame lookahead and macroblock-tree analysis for the mpegvideo encoders.
+ *
+ * Input frames are delayed by up to depth frames. For each buffered frame
+ * a cheap motion search is run on a half resolution copy of the luma plane
+ * against its predecessor; before a frame leaves the lookahead, the share
+ * of each of its macroblocks that is referenced by the following frames is
+ * accumulated backwards (as in x264's macroblock-tree) and turned into a
+ * per-macroblock weight for adaptive quantization.
+ */
+
+#include <stdint.h>
+
+#include "libavutil/frame.h"
+#include "avcodec.h"
+#include "me_cmp.h"
+
+#define MPV_LOOKAHEAD_MAX_DEPTH 100
+/// number of returned but not yet encoded frames whose weights are kept
+#define MPV_LOOKAHEAD_WEIGHTS   40
+
+typedef struct MPVLookaheadFrame {
+    AVFrame *f;
+    uint8_t *lowres_base;
+    uint8_t *lowres;            ///< half resolution luma, edges padded
+    int     *intra_cost;
+    int     *inter_cost;        ///< min(intra, inter) cost against the previous frame
+    int16_t (*mv)[2];           ///< lowres motion vectors against the previous frame
+    float   *propagate;
+} MPVLookaheadFrame;
+
+typedef struct MPVLookaheadContext {
+    /* user options */
+    int   depth;
+    float strength;
+
+    AVCodecContext *avctx;
+    me_cmp_func sad;
+
+    int mb_width, mb_height, mb_num;
+    int width, height;          ///< dimensions of the source luma plane
+    int lowres_width, lowres_height;
+    ptrdiff_t lowres_stride;
+
+    MPVLookaheadFrame *frames;  ///< depth + 1 entries, oldest first
+    int nb_frames;
+    int eof;
+
+    int nb_output;              ///< number of frames returned so far
+    float *weights[MPV_LOOKAHEAD_WEIGHTS];
+    int weights_pic[MPV_LOOKAHEAD_WEIGHTS];
+
+    /* used by the row jobs */
+    MPVLookaheadFrame *cur, *prev;
+    const AVFrame *src;
+} MPVLookaheadContext;
+
+int ff_mpv_lookahead_init(MPVLookaheadContext *la, AVCodecContext *avctx,
+                          int mb_width, int mb_height);
+void ff_mpv_lookahead_uninit(MPVLookaheadContext *la);
+
+/**
+ * Add a frame to the lookahead, or start draining it if frame is NULL.
+ */
+int ff_mpv_lookahead_send_frame(MPVLookaheadContext *la, const AVFrame *frame);
+
+/**
+ * Take the oldest frame out of the lookahead once depth frames follow it
+ * (or when draining) and compute its macroblock weights.
+ * @param frame set to the frame, or to NULL if no frame is ready
+ */
+int ff_mpv_lookahead_receive_frame(MPVLookaheadContext *la, AVFrame **frame);
+
+/**
+ * Return the weights for the n-th frame returned by
+ * ff_mpv_lookahead_receive_frame() or NULL if they are no longer available.
+ * The weights are stored in macroblock raster order (mb_y * mb_width + mb_x)
+ * and scale the number of bits spent on each macroblock.
+ */
+const float *ff_mpv_lookahead_weights(const MPVLookaheadContext *la, int n);
+
+#endif /* AVCODEC_MPEGVIDEO_LOOKAHEAD_H */
@@ -36,6 +36,7 @@
 #include "fdctdsp.h"
 #include "motion_est.h"
 #include "mpegvideo.h"
+#include "mpegvideo_lookahead.h"
 #include "mpegvideoencdsp.h"
 #include "pixblockdsp.h"
 #include "put_bits.h"
@@ -262,6 +263,7 @@ typedef struct MPVMainEncContext {
     int last_pict_type;            //FIXME removes
     int last_non_b_pict_type;      ///< used for MPEG-4 gmc B-frames & ratecontrol
     RateControlContext rc_context; ///< contains stuff only accessed in ratecontrol.c
+    MPVLookaheadContext lookahead; ///< macroblock-tree lookahead
 
     int me_penalty_compensation;
     int me_pre;                          ///< prepass for motion estimation
@@ -377,6 +379,10 @@ FF_MPV_OPT_CMP_FUNC, \
 {"b_sensitivity", "Adjust sensitivity of b_frame_strategy 1",  FF_MPV_MAIN_OFFSET(b_sensitivity), AV_OPT_TYPE_INT, {.i64 = 40 }, 1, INT_MAX, FF_MPV_OPT_FLAGS }, \
 {"brd_scale", "Downscale frames for dynamic B-frame decision", FF_MPV_MAIN_OFFSET(brd_scale), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, 3, FF_MPV_OPT_FLAGS },
 
+#define FF_MPV_COMMON_LOOKAHEAD_OPTS \
+{"rc_lookahead", "Number of frames to look ahead for macroblock-tree adaptive quantization", FF_MPV_MAIN_OFFSET(lookahead.depth), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, MPV_LOOKAHEAD_MAX_DEPTH, FF_MPV_OPT_FLAGS }, \
+{"mbtree_strength", "Strength of macroblock-tree adaptive quantization", FF_MPV_MAIN_OFFSET(lookahead.strength), AV_OPT_TYPE_FLOAT, {.dbl = 2.0 }, 0, 10, FF_MPV_OPT_FLAGS },
+
 #define FF_MPV_COMMON_MOTION_EST_OPTS \
 { "mv0",            "always try a mb with mv=<0,0>",                     0, AV_OPT_TYPE_CONST, { .i64 = FF_MPV_FLAG_MV0 },    0, 0, FF_MPV_OPT_FLAGS, .unit = "mpv_flags" },\
 {"motion_est", "motion estimation algorithm",                       FF_MPV_OFFSET(me.motion_est), AV_OPT_TYPE_INT, {.i64 = FF_ME_EPZS }, FF_ME_ZERO, FF_ME_XONE, FF_MPV_OPT_FLAGS, .unit = "motion_est" },   \
@@ -43,6 +43,7 @@
 #include <zlib.h>
 
 #define IOBUF_SIZE 4096
+#define MIN_STRIP_ROWS 16
 
 typedef struct APNGFctlChunk {
     uint32_t sequence_number;
@@ -52,6 +53,22 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+/**
+ * A strip of rows deflated on its own, as a part of the zlib stream.
+ */
+typedef struct PNGEncStrip {
+    FFZStream zstream;           ///< raw deflate stream
+    uint8_t *crow_base;
+    unsigned crow_size;
+    uint8_t *dict;
+    unsigned dict_size;
+    uint8_t *buf;                ///< compressed data, after 2 reserved bytes
+    unsigned buf_size;
+    int len;                     ///< size of the compressed data
+    uLong adler;                 ///< Adler-32 of the uncompressed data
+    uLong size;                  ///< size of the uncompressed data
+} PNGEncStrip;
+
 typedef struct PNGEncContext {
     AVClass *class;
     LLVidEncDSPContext llvidencdsp;
@@ -64,6 +81,12 @@ typedef struct PNGEncContext {
 
     FFZStream zstream;
     uint8_t buf[IOBUF_SIZE];
+    int compression_level;
+
+    PNGEncStrip *strips;         ///< strips deflated in parallel by slice threads
+    int *strip_ret;
+    int nb_strips;
+    int nb_frame_strips;         ///< number of strips of the current frame
     int dpi;                     ///< Physical pixel density, in dots per inch, if set
     int dpm;                     ///< Physical pixel density, in dots per meter, if set
 
@@ -524,6 +547,122 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static int deflate_strip(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s       = avctx->priv_data;
+    const AVFrame *const p = arg;
+    PNGEncStrip *st        = &s->strips[jobnr];
+    z_stream *const zstream = &st->zstream.zstream;
+    int row_size = (p->width * s->bits_per_pixel + 7) >> 3;
+    int bpp      = s->bits_per_pixel >> 3;
+    int y0       = p->height *  jobnr      / s->nb_frame_strips;
+    int y1       = p->height * (jobnr + 1) / s->nb_frame_strips;
+    int last     = jobnr == s->nb_frame_strips - 1;
+    uint8_t *crow_buf, *crow;
+    int y, ret;
+
+    av_fast_malloc(&st->crow_base, &st->crow_size,
+                   (row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+    av_fast_malloc(&st->buf, &st->buf_size,
+                   deflateBound(zstream, (uLong)(y1 - y0) * (row_size + 1)) + 2 + 16 + 4);
+    if (!st->crow_base || !st->buf)
+        return AVERROR(ENOMEM);
+    // pixel data should be aligned, but there's a control byte before it
+    crow_buf = st->crow_base + 15;
+
+    deflateReset(zstream);
+    st->adler = adler32(0, NULL, 0);
+    st->size  = 0;
+
+    /* Prime the window with the end of the preceding filtered data, which
+     * the strip can then refer to as a part of the same zlib stream. */
+    if (y0 > 0) {
+        int dict_rows = FFMIN(y0, (32768 + row_size) / (row_size + 1));
+        int dict_len  = dict_rows * (row_size + 1);
+
+        av_fast_malloc(&st->dict, &st->dict_size, dict_len);
+        if (!st->dict)
+            return AVERROR(ENOMEM);
+        for (y = y0 - dict_rows; y < y0; y++) {
+            const uint8_t *ptr = p->data[0] +  y      * p->linesize[0];
+            const uint8_t *top = y ? ptr - p->linesize[0] : NULL;
+            crow = png_choose_filter(s, crow_buf, ptr, top, row_size, bpp);
+            memcpy(st->dict + (y - y0 + dict_rows) * (row_size + 1), crow, row_size + 1);
+        }
+        if (dict_len > 32768) {
+            deflateSetDictionary(zstream, st->dict + dict_len - 32768, 32768);
+        } else
+            deflateSetDictionary(zstream, st->dict, dict_len);
+    }
+
+    zstream->avail_out = st->buf_size - 2 - 4;
+    zstream->next_out  = st->buf + 2;
+    for (y = y0; y < y1; y++) {
+        const uint8_t *ptr = p->data[0] + y * p->linesize[0];
+        const uint8_t *top = y ? ptr - p->linesize[0] : NULL;
+        int flush = y < y1 - 1 ? Z_NO_FLUSH : last ? Z_FINISH : Z_SYNC_FLUSH;
+
+        crow = png_choose_filter(s, crow_buf, ptr, top, row_size, bpp);
+        st->adler = adler32(st->adler, crow, row_size + 1);
+        st->size += row_size + 1;
+
+        zstream->avail_in = row_size + 1;
+        zstream->next_in  = crow;
+        ret = deflate(zstream, flush);
+        if ((ret != Z_OK && ret != Z_STREAM_END) || zstream->avail_out == 0)
+            return AVERROR_EXTERNAL;
+    }
+    st->len = zstream->next_out - (st->buf + 2);
+
+    return 0;
+}
+
+/**
+ * Encode the image as strips of rows deflated in parallel. The strips are
+ * joined into a single zlib stream by ending all of them but the last on
+ * a byte boundary with a sync flush, and by combining their checksums.
+ */
+static int encode_frame_strips(AVCodecContext *avctx, const AVFrame *pict)
+{
+    PNGEncContext *s = avctx->priv_data;
+    int level = s->compression_level == Z_DEFAULT_COMPRESSION ? 6 : s->compression_level;
+    unsigned header;
+    uLong adler;
+    int i;
+
+    avctx->execute2(avctx, deflate_strip, (void *)pict, s->strip_ret, s->nb_frame_strips);
+    for (i = 0; i < s->nb_frame_strips; i++)
+        if (s->strip_ret[i] < 0)
+            return s->strip_ret[i];
+
+    header  = 0x7800 | (level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+    header += 31 - header % 31;
+    AV_WB16(s->strips[0].buf, header);
+
+    adler = s->strips[0].adler;
+    for (i = 1; i < s->nb_frame_strips; i++)
+        adler = adler32_combine(adler, s->strips[i].adler, s->strips[i].size);
+
+    for (i = 0; i < s->nb_frame_strips; i++) {
+        PNGEncStrip *st = &s->strips[i];
+        const uint8_t *data = st->buf + 2;
+        int len = st->len;
+
+        if (!i) {
+            data -= 2;
+            len  += 2;
+        }
+        if (i == s->nb_frame_strips - 1) {
+            AV_WB32(st->buf + 2 + st->len, adler);
+            len += 4;
+        }
+        if (s->bytestream_end - s->bytestream > len + 100)
+            png_write_image_data(avctx, data, len);
+    }
+
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -536,6 +675,10 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
     uint8_t *progressive_buf = NULL;
     uint8_t *top_buf         = NULL;
 
+    s->nb_frame_strips = FFMIN(s->nb_strips, pict->height / MIN_STRIP_ROWS);
+    if (!s->is_progressive && s->nb_frame_strips > 1)
+        return encode_frame_strips(avctx, pict);
+
     row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
 
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
@@ -1167,7 +1310,7 @@ static int encode_apng(AVCodecContext *avctx, AVPacket *pkt,
 static av_cold int png_enc_init(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
-    int compression_level;
+    int compression_level, ret;
 
     switch (avctx->pix_fmt) {
     case AV_PIX_FMT_RGBA:
@@ -1248,6 +1391,21 @@ static av_cold int png_enc_init(AVCodecContext *avctx)
     compression_level = avctx->compression_level == FF_COMPRESSION_DEFAULT
                       ? Z_DEFAULT_COMPRESSION
                       : av_clip(avctx->compression_level, 0, 9);
+    s->compression_level = compression_level;
+
+    if (avctx->active_thread_type & FF_THREAD_SLICE && avctx->thread_count > 1) {
+        s->strips    = av_calloc(avctx->thread_count, sizeof(*s->strips));
+        s->strip_ret = av_calloc(avctx->thread_count, sizeof(*s->strip_ret));
+        if (!s->strips || !s->strip_ret)
+            return AVERROR(ENOMEM);
+        for (; s->nb_strips < avctx->thread_count; s->nb_strips++) {
+            ret = ff_deflate_init_raw(&s->strips[s->nb_strips].zstream,
+                                      compression_level, avctx);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
     return ff_deflate_init(&s->zstream, compression_level, avctx);
 }
 
@@ -1256,6 +1414,15 @@ static av_cold int png_enc_close(AVCodecContext *avctx)
     PNGEncContext *s = avctx->priv_data;
 
     ff_deflate_end(&s->zstream);
+    for (int i = 0; i < s->nb_strips; i++) {
+        PNGEncStrip *st = &s->strips[i];
+        ff_deflate_end(&st->zstream);
+        av_freep(&st->crow_base);
+        av_freep(&st->dict);
+        av_freep(&st->buf);
+    }
+    av_freep(&s->strips);
+    av_freep(&s->strip_ret);
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
@@ -1292,6 +1459,7 @@ const FFCodec ff_png_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_PNG,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS |
                       AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
     .priv_data_size = sizeof(PNGEncContext),
     .init           = png_enc_init,
@@ -1305,7 +1473,7 @@ const FFCodec ff_png_encoder = {
                   AV_PIX_FMT_MONOBLACK),
     .alpha_modes    = AVALPHA_MODE_STRAIGHT,
     .p.priv_class   = &pngenc_class,
-    .caps_internal  = FF_CODEC_CAP_ICC_PROFILES,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_ICC_PROFILES,
 };
 
 const FFCodec ff_apng_encoder = {
@@ -1314,6 +1482,7 @@ const FFCodec ff_apng_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_APNG,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS |
                       AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
     .priv_data_size = sizeof(PNGEncContext),
     .init           = png_enc_init,
@@ -1326,5 +1495,5 @@ const FFCodec ff_apng_encoder = {
                   AV_PIX_FMT_GRAY16BE, AV_PIX_FMT_YA16BE),
     .alpha_modes    = AVALPHA_MODE_STRAIGHT,
     .p.priv_class   = &pngenc_class,
-    .caps_internal  = FF_CODEC_CAP_ICC_PROFILES,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_ICC_PROFILES,
 };
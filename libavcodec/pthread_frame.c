@@ -472,6 +472,7 @@ static int update_context_from_user(AVCodecContext *dst, const AVCodecContext *s
     dst->flags          = src->flags;
 
     dst->draw_horiz_band= src->draw_horiz_band;
+    dst->frame_progress = src->frame_progress;
     dst->get_buffer2    = src->get_buffer2;
 
     dst->opaque   = src->opaque;
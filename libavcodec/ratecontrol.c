@@ -794,6 +794,9 @@ static void adaptive_quantization(RateControlContext *const rcc,
     const int qmax                   = s->c.avctx->mb_lmax;
     const int mb_width               = s->c.mb_width;
     const int mb_height              = s->c.mb_height;
+    /* B-frames are not referenced, so the macroblock-tree leaves them as is */
+    const float *mbtree_weights      = s->c.pict_type == AV_PICTURE_TYPE_B ? NULL :
+        ff_mpv_lookahead_weights(&m->lookahead, s->picture_number);
 
     for (int i = 0; i < s->c.mb_num; i++) {
         const int mb_xy = s->c.mb_index2xy[i];
@@ -843,6 +846,9 @@ static void adaptive_quantization(RateControlContext *const rcc,
 
         factor *= 1.0 - border_masking * mb_factor;
 
+        if (mbtree_weights)
+            factor *= mbtree_weights[i];
+
         if (factor < 0.00001)
             factor = 0.00001;
 
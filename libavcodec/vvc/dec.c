@@ -1133,6 +1133,7 @@ static int wait_delayed_frame(VVCContext *s, AVFrame *output, int *got_output)
         }
     }
     s->nb_delayed--;
+    atomic_store(&s->oldest_decode_order, s->nb_frames - s->nb_delayed);
 
     return ret;
 }
@@ -1264,8 +1265,9 @@ static av_cold int vvc_decode_init(AVCodecContext *avctx)
     VVCContext *s                  = avctx->priv_data;
     static AVOnce init_static_once = AV_ONCE_INIT;
     const int cpu_count            = av_cpu_count();
-    const int delayed              = FFMIN(cpu_count, VVC_MAX_DELAYED_FRAMES);
-    int thread_count               = avctx->thread_count ? avctx->thread_count : delayed;
+    int thread_count               = avctx->thread_count ? avctx->thread_count :
+                                                               FFMIN(cpu_count, VVC_MAX_DELAYED_FRAMES);
+    const int delayed              = FFMIN(thread_count, VVC_MAX_DELAYED_FRAMES);
     int ret;
 
     s->avctx = avctx;
@@ -1280,7 +1282,9 @@ static av_cold int vvc_decode_init(AVCodecContext *avctx)
             return ret;
     }
 
+    // frames in flight beyond the number of threads only add latency
     s->nb_fcs = (avctx->flags & AV_CODEC_FLAG_LOW_DELAY) ? 1 : delayed;
+    atomic_init(&s->oldest_decode_order, 0);
     s->fcs = av_calloc(s->nb_fcs, sizeof(*s->fcs));
     if (!s->fcs)
         return AVERROR(ENOMEM);
@@ -24,6 +24,8 @@
 #ifndef AVCODEC_VVC_DEC_H
 #define AVCODEC_VVC_DEC_H
 
+#include <stdatomic.h>
+
 #include "libavcodec/videodsp.h"
 #include "libavcodec/vvc.h"
 #include "libavcodec/h274.h"
@@ -249,6 +251,12 @@ typedef struct VVCContext {
     uint64_t nb_frames;     ///< processed frames
     int nb_delayed;         ///< delayed frames
 
+    /**
+     * decode_order of the oldest frame still being decoded, used to run
+     * the tasks of older frames first
+     */
+    atomic_uint_least64_t oldest_decode_order;
+
     H274HashContext *hash_ctx;
 }  VVCContext ;
 
@@ -109,6 +109,9 @@ static void add_task(VVCContext *s, VVCTask *t)
 {
     VVCFrameThread *ft     = t->fc->ft;
     FFTask *task           = &t->u.task;
+    // Each frame context has its own tier of priorities. The tiers are
+    // ordered by frame age when dequeuing, see task_first_priority().
+    const int tier         = t->fc->decode_order % s->nb_fcs;
     const int priorities[] = {
         0,                  // VVC_TASK_STAGE_INIT,
         0,                  // VVC_TASK_STAGE_PARSE,
@@ -125,7 +128,7 @@ static void add_task(VVCContext *s, VVCTask *t)
     };
 
     atomic_fetch_add(&ft->nb_scheduled_tasks, 1);
-    task->priority = priorities[t->stage];
+    task->priority = tier * (PRIORITY_LOWEST + 1) + priorities[t->stage];
     ff_executor_execute(s->executor, task);
 }
 
@@ -684,13 +687,25 @@ static int task_run(FFTask *_t, void *local_context, void *user_data)
     return 0;
 }
 
+// Frames in flight are ordered by age: the tasks of a frame run before those
+// of any later frame, since later frames wait on its progress. The age is
+// evaluated here rather than when adding a task, as it changes whenever the
+// oldest frame completes.
+static int task_first_priority(void *user_data)
+{
+    VVCContext *s = user_data;
+
+    return atomic_load(&s->oldest_decode_order) % s->nb_fcs * (PRIORITY_LOWEST + 1);
+}
+
 av_cold FFExecutor* ff_vvc_executor_alloc(VVCContext *s, const int thread_count)
 {
     FFTaskCallbacks callbacks = {
         s,
         sizeof(VVCLocalContext),
-        PRIORITY_LOWEST + 1,
+        (PRIORITY_LOWEST + 1) * s->nb_fcs,
         task_run,
+        task_first_priority,
     };
     return ff_executor_alloc(&callbacks, thread_count);
 }
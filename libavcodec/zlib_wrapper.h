@@ -53,6 +53,12 @@ void ff_inflate_end(FFZStream *zstream);
  */
 int ff_deflate_init(FFZStream *zstream, int level, void *logctx);
 
+/**
+ * Same as ff_deflate_init(), but for a raw deflate stream without
+ * the zlib header and trailer.
+ */
+int ff_deflate_init_raw(FFZStream *zstream, int level, void *logctx);
+
 /**
  * Wrapper around deflateEnd(). It works analogously to ff_inflate_end().
  */
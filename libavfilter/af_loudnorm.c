@@ -64,6 +64,7 @@ typedef struct LoudNormContext {
     double offset;
     int linear;
     int dual_mono;
+    int measure_only;
     /* enum PrintFormat */
     int print_format;
     char *stats_file_str;
@@ -120,6 +121,7 @@ static const AVOption loudnorm_options[] = {
     { "offset",           "set offset gain",                   OFFSET(offset),           AV_OPT_TYPE_DOUBLE,  {.dbl =  0.},    -99.,       99.,  FLAGS },
     { "linear",           "normalize linearly if possible",    OFFSET(linear),           AV_OPT_TYPE_BOOL,    {.i64 =  1},        0,         1,  FLAGS },
     { "dual_mono",        "treat mono input as dual-mono",     OFFSET(dual_mono),        AV_OPT_TYPE_BOOL,    {.i64 =  0},        0,         1,  FLAGS },
+    { "measure_only",     "only measure the input, pass the audio through unchanged", OFFSET(measure_only), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
     { "print_format",     "set print format for stats",        OFFSET(print_format),     AV_OPT_TYPE_INT,     {.i64 =  NONE},  NONE,  PF_NB -1,  FLAGS, .unit = "print_format" },
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, .unit = "print_format" },
     {     "json",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  JSON},     0,         0,  FLAGS, .unit = "print_format" },
@@ -690,6 +692,21 @@ static int activate(AVFilterContext *ctx)
 
     FF_FILTER_FORWARD_STATUS_BACK(outlink, inlink);
 
+    if (s->measure_only) {
+        ret = ff_inlink_consume_frame(inlink, &in);
+        if (ret < 0)
+            return ret;
+        if (ret > 0) {
+            ff_ebur128_add_frames_double(s->r128_in, (const double *)in->data[0], in->nb_samples);
+            return ff_filter_frame(outlink, in);
+        }
+
+        FF_FILTER_FORWARD_STATUS(inlink, outlink);
+        FF_FILTER_FORWARD_WANTED(outlink, inlink);
+
+        return FFERROR_NOT_READY;
+    }
+
     if (s->frame_type != LINEAR_MODE) {
         int nb_samples;
 
@@ -748,7 +765,9 @@ static int query_formats(const AVFilterContext *ctx,
     if (ret < 0)
         return ret;
 
-    if (s->frame_type != LINEAR_MODE) {
+    /* only the true peak limiter needs the oversampled input, the meter
+     * works at any rate */
+    if (s->frame_type != LINEAR_MODE && !s->measure_only) {
         return ff_set_common_samplerates_from_list2(ctx, cfg_in, cfg_out, input_srate);
     }
     return 0;
@@ -763,9 +782,20 @@ static int config_input(AVFilterLink *inlink)
     if (!s->r128_in)
         return AVERROR(ENOMEM);
 
+    s->channels = inlink->ch_layout.nb_channels;
+    ff_ebur128_set_filter_context(s->r128_in, ctx);
+
+    /* nothing but the input statistics are needed */
+    if (s->measure_only) {
+        if (inlink->ch_layout.nb_channels == 1 && s->dual_mono)
+            ff_ebur128_set_channel(s->r128_in, 0, FF_EBUR128_DUAL_MONO);
+        return 0;
+    }
+
     s->r128_out = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
     if (!s->r128_out)
         return AVERROR(ENOMEM);
+    ff_ebur128_set_filter_context(s->r128_out, ctx);
 
     if (inlink->ch_layout.nb_channels == 1 && s->dual_mono) {
         ff_ebur128_set_channel(s->r128_in,  0, FF_EBUR128_DUAL_MONO);
@@ -791,7 +821,6 @@ static int config_input(AVFilterLink *inlink)
     s->buf_index =
     s->prev_buf_index =
     s->limiter_buf_index = 0;
-    s->channels = inlink->ch_layout.nb_channels;
     s->index = 1;
     s->limiter_state = OUT;
     s->offset = pow(10., s->offset / 20.);
@@ -812,7 +841,7 @@ static av_cold int init(AVFilterContext *ctx)
         return AVERROR(EINVAL);
     }
 
-    if (s->linear) {
+    if (s->linear && !s->measure_only) {
         double offset, offset_tp;
         offset    = s->target_i - s->measured_i;
         offset_tp = s->measured_tp + offset;
@@ -835,7 +864,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     int c;
     FILE *stats_file = NULL;
 
-    if (!s->r128_in || !s->r128_out)
+    if (!s->r128_in || (!s->r128_out && !s->measure_only))
         goto end;
 
     ff_ebur128_loudness_range(s->r128_in, &lra_in);
@@ -848,14 +877,21 @@ static av_cold void uninit(AVFilterContext *ctx)
             tp_in = tmp;
     }
 
-    ff_ebur128_loudness_range(s->r128_out, &lra_out);
-    ff_ebur128_loudness_global(s->r128_out, &i_out);
-    ff_ebur128_relative_threshold(s->r128_out, &thresh_out);
-    for (c = 0; c < s->channels; c++) {
-        double tmp;
-        ff_ebur128_sample_peak(s->r128_out, c, &tmp);
-        if ((c == 0) || (tmp > tp_out))
-            tp_out = tmp;
+    if (s->measure_only) {
+        lra_out    = lra_in;
+        i_out      = i_in;
+        thresh_out = thresh_in;
+        tp_out     = tp_in;
+    } else {
+        ff_ebur128_loudness_range(s->r128_out, &lra_out);
+        ff_ebur128_loudness_global(s->r128_out, &i_out);
+        ff_ebur128_relative_threshold(s->r128_out, &thresh_out);
+        for (c = 0; c < s->channels; c++) {
+            double tmp;
+            ff_ebur128_sample_peak(s->r128_out, c, &tmp);
+            if ((c == 0) || (tmp > tp_out))
+                tp_out = tmp;
+        }
     }
 
 
@@ -915,8 +951,9 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? (s->print_format == JSON ? "linear"  : "Linear")
-                                         : (s->print_format == JSON ? "dynamic" : "Dynamic"),
+            s->measure_only              ? (s->print_format == JSON ? "none"    : "None")   :
+            s->frame_type == LINEAR_MODE ? (s->print_format == JSON ? "linear"  : "Linear") :
+                                           (s->print_format == JSON ? "dynamic" : "Dynamic"),
             s->target_i - i_out
         );
         av_log(ctx, AV_LOG_INFO, "\n%s", stats);
@@ -950,6 +987,7 @@ const FFFilter ff_af_loudnorm = {
     .p.name        = "loudnorm",
     .p.description = NULL_IF_CONFIG_SMALL("EBU R128 loudness normalization"),
     .p.priv_class  = &loudnorm_class,
+    .p.flags       = AVFILTER_FLAG_SLICE_THREADS,
     .priv_size     = sizeof(LoudNormContext),
     .init          = init,
     .activate      = activate,
@@ -43,10 +43,9 @@ AVFrame *ff_null_get_audio_buffer(AVFilterLink *link, int nb_samples)
     return ff_get_audio_buffer(link->dst->outputs[0], nb_samples);
 }
 
-AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
+static AVFrame *pool_get_audio(FilterLinkInternal *li, int nb_samples)
 {
-    AVFrame *frame = NULL;
-    FilterLinkInternal *const li = ff_link_internal(link);
+    AVFilterLink *const link = &li->l.pub;
     int channels = link->ch_layout.nb_channels;
     int align = av_cpu_max_align();
 
@@ -78,7 +77,24 @@ AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
         }
     }
 
-    frame = ff_frame_pool_get(li->frame_pool);
+    return ff_frame_pool_get(li->frame_pool);
+}
+
+AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
+{
+    AVFrame *frame = NULL;
+    FilterLinkInternal *const li = ff_link_internal(link);
+    int channels = link->ch_layout.nb_channels;
+
+    /* with pipeline threading, buffers requested through pass-through
+     * filters may come from different threads */
+    if (li->l.graph && fffiltergraph(li->l.graph)->pipeline) {
+        ff_graph_pipeline_lock(fffiltergraph(li->l.graph));
+        frame = pool_get_audio(li, nb_samples);
+        ff_graph_pipeline_unlock(fffiltergraph(li->l.graph));
+    } else {
+        frame = pool_get_audio(li, nb_samples);
+    }
     if (!frame)
         return NULL;
 
@@ -222,13 +222,25 @@ static void update_link_current_pts(FilterLinkInternal *li, int64_t pts)
     li->l.current_pts = pts;
     li->l.current_pts_us = av_rescale_q(pts, link->time_base, AV_TIME_BASE_Q);
     /* TODO use duration */
-    if (li->l.graph && li->age_index >= 0)
+    if (li->l.graph && fffiltergraph(li->l.graph)->pipeline) {
+        FFFilterGraph *graphi = fffiltergraph(li->l.graph);
+        ff_graph_pipeline_lock(graphi);
+        if (li->age_index >= 0)
+            ff_avfilter_graph_update_heap(li->l.graph, li);
+        ff_graph_pipeline_unlock(graphi);
+    } else if (li->l.graph && li->age_index >= 0) {
         ff_avfilter_graph_update_heap(li->l.graph, li);
+    }
 }
 
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
     FFFilterContext *ctxi = fffilterctx(filter);
+
+    if (filter->graph && fffiltergraph(filter->graph)->pipeline) {
+        ff_graph_pipeline_set_ready(fffiltergraph(filter->graph), ctxi, priority);
+        return;
+    }
     ctxi->ready = FFMAX(ctxi->ready, priority);
 }
 
@@ -246,6 +258,23 @@ static void filter_unblock(AVFilterContext *filter)
     }
 }
 
+/**
+ * Unblock the destination of a link from its source. With pipeline
+ * threading, the filters downstream of the destination may be running.
+ */
+static void link_unblock_dst(AVFilterLink *link)
+{
+    FFFilterGraph *graphi = link->dst->graph ? fffiltergraph(link->dst->graph) : NULL;
+
+    if (graphi && graphi->pipeline) {
+        ff_graph_pipeline_lock(graphi);
+        filter_unblock(link->dst);
+        ff_graph_pipeline_unlock(graphi);
+    } else {
+        filter_unblock(link->dst);
+    }
+}
+
 
 void ff_avfilter_link_set_in_status(AVFilterLink *link, int status, int64_t pts)
 {
@@ -258,10 +287,31 @@ void ff_avfilter_link_set_in_status(AVFilterLink *link, int status, int64_t pts)
     li->status_in_pts = pts;
     li->frame_wanted_out = 0;
     li->frame_blocked_in = 0;
-    filter_unblock(link->dst);
+    link_unblock_dst(link);
     ff_filter_set_ready(link->dst, 200);
 }
 
+/**
+ * Check if the source of a link may produce frames before they are requested,
+ * i.e. if the graph runs with pipeline threading and the link queue is not full.
+ */
+static int link_can_read_ahead(FilterLinkInternal *li)
+{
+    AVFilterLink *const link = &li->l.pub;
+    AVFilterGraph *graph = link->dst->graph;
+
+    return graph && fffiltergraph(graph)->pipeline &&
+           (link->src->thread_type & AVFILTER_THREAD_PIPELINE) &&
+           !li->status_in && !li->status_out &&
+           ff_framequeue_queued_frames(&li->fifo) < graph->pipeline_queue_size;
+}
+
+static void link_read_ahead(FilterLinkInternal *li)
+{
+    li->frame_wanted_out = 1;
+    ff_filter_set_ready(li->l.pub.src, 100);
+}
+
 /**
  * Set the status field of a link from the destination filter.
  * The pts should probably be left unset (AV_NOPTS_VALUE).
@@ -663,14 +713,18 @@ static const AVClass *filter_child_class_iterate(void **iter)
 #define TFLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_RUNTIME_PARAM
 static const AVOption avfilter_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
-        { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, .unit = "thread_type" },
+        { .i64 = AVFILTER_THREAD_SLICE | AVFILTER_THREAD_PIPELINE }, 0, INT_MAX, FLAGS, .unit = "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "pipeline", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_PIPELINE }, .flags = FLAGS, .unit = "thread_type" },
     { "enable", "set enable expression", OFFSET(enable_str), AV_OPT_TYPE_STRING, {.str=NULL}, .flags = TFLAGS },
     { "threads", "Allowed number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, FLAGS, .unit = "threads" },
         {"auto", "autodetect a suitable number of threads to use", 0, AV_OPT_TYPE_CONST, {.i64 = 0 }, .flags = FLAGS, .unit = "threads"},
     { "extra_hw_frames", "Number of extra hardware frames to allocate for the user",
         OFFSET(extra_hw_frames), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, INT_MAX, FLAGS },
+    { "frame_copies", "Number of input frames copied to make them writable",
+        offsetof(FFFilterContext, nb_frame_copies), AV_OPT_TYPE_UINT64, { .i64 = 0 }, 0, UINT64_MAX,
+        FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { NULL },
 };
 
@@ -808,6 +862,10 @@ void avfilter_free(AVFilterContext *filter)
     if (filter->graph)
         ff_filter_graph_remove_filter(filter->graph, filter);
 
+    if (ctxi->nb_frame_copies)
+        av_log(filter, AV_LOG_VERBOSE, "%"PRIu64" input frames were shared "
+               "and had to be copied to be made writable\n", ctxi->nb_frame_copies);
+
     if (fffilter(filter->filter)->uninit)
         fffilter(filter->filter)->uninit(filter);
 
@@ -918,7 +976,7 @@ int ff_filter_process_command(AVFilterContext *ctx, const char *cmd,
 int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
 {
     FFFilterContext *ctxi = fffilterctx(ctx);
-    int ret = 0;
+    int ret = 0, pipeline;
 
     if (ctxi->state_flags & AV_CLASS_STATE_INITIALIZED) {
         av_log(ctx, AV_LOG_ERROR, "Filter already initialized\n");
@@ -931,6 +989,8 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         return ret;
     }
 
+    pipeline = ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_PIPELINE &&
+               !(fffilter(ctx->filter)->flags_internal & FF_FILTER_FLAG_GRAPH_EXCLUSIVE);
     if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
         ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_SLICE &&
         fffiltergraph(ctx->graph)->thread_execute) {
@@ -939,6 +999,8 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
     } else {
         ctx->thread_type = 0;
     }
+    if (pipeline)
+        ctx->thread_type |= AVFILTER_THREAD_PIPELINE;
 
     if (fffilter(ctx->filter)->init)
         ret = fffilter(ctx->filter)->init(ctx);
@@ -1067,7 +1129,7 @@ fail:
 int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    int ret;
+    int ret, wanted;
     FF_TPRINTF_START(NULL, filter_frame); ff_tlog_link(NULL, link, 1); ff_tlog(NULL, " "); tlog_ref(NULL, frame, 1);
 
     /* Consistency checks */
@@ -1102,16 +1164,21 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
                                        link->time_base);
     }
 
+    wanted = li->frame_wanted_out;
     li->frame_blocked_in = li->frame_wanted_out = 0;
     li->l.frame_count_in++;
     li->l.sample_count_in += frame->nb_samples;
-    filter_unblock(link->dst);
+    link_unblock_dst(link);
     ret = ff_framequeue_add(&li->fifo, frame);
     if (ret < 0) {
         av_frame_free(&frame);
         return ret;
     }
     ff_filter_set_ready(link->dst, 300);
+    /* with pipeline threading, keep the source working on the next frames
+     * while the destination processes this one */
+    if (wanted && link_can_read_ahead(li))
+        link_read_ahead(li);
     return 0;
 
 error:
@@ -1211,6 +1278,8 @@ static int filter_frame_to_filter(AVFilterLink *link)
     li->l.frame_count_out--;
     ret = filter_frame_framed(link, frame);
     if (ret < 0 && ret != li->status_out) {
+        /* may have been set by a read-ahead when consuming the frame */
+        li->frame_wanted_out = 0;
         link_set_out_status(link, ret, AV_NOPTS_VALUE);
     } else {
         /* Run once again, to see if several frames were available, or if
@@ -1445,14 +1514,12 @@ static int filter_activate_default(AVFilterContext *filter)
 
 int ff_filter_activate(AVFilterContext *filter)
 {
-    FFFilterContext *ctxi = fffilterctx(filter);
     const FFFilter *const fi = fffilter(filter->filter);
     int ret;
 
     /* Generic timeline support is not yet implemented but should be easy */
     av_assert1(!(fi->p.flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  fi->activate));
-    ctxi->ready = 0;
     ret = fi->activate ? fi->activate(filter) : filter_activate_default(filter);
     if (ret == FFERROR_NOT_READY)
         ret = 0;
@@ -1510,6 +1577,15 @@ static void consume_update(FilterLinkInternal *li, const AVFrame *frame)
         link->dst->is_disabled = !evaluate_timeline_at_frame(link, frame);
     li->l.frame_count_out++;
     li->l.sample_count_out += frame->nb_samples;
+    if (!li->frame_wanted_out && link_can_read_ahead(li)) {
+        AVFilterContext *dst = link->dst;
+
+        for (unsigned i = 0; i < dst->nb_outputs; i++)
+            if (ff_framequeue_queued_frames(&ff_link_internal(dst->outputs[i])->fifo) >=
+                dst->graph->pipeline_queue_size)
+                return;
+        link_read_ahead(li);
+    }
 }
 
 int ff_inlink_consume_frame(AVFilterLink *link, AVFrame **rframe)
@@ -1569,6 +1645,16 @@ int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
         return 0;
     av_log(link->dst, AV_LOG_DEBUG, "Copying data in avfilter.\n");
 
+    fffilterctx(link->dst)->nb_frame_copies++;
+    if (link->dst->graph) {
+        FFFilterGraph *graphi = fffiltergraph(link->dst->graph);
+        if (graphi->pipeline)
+            ff_graph_pipeline_lock(graphi);
+        graphi->nb_frame_copies++;
+        if (graphi->pipeline)
+            ff_graph_pipeline_unlock(graphi);
+    }
+
     switch (link->type) {
     case AVMEDIA_TYPE_VIDEO:
         out = ff_get_video_buffer(link, link->w, link->h);
@@ -1630,7 +1716,14 @@ void ff_inlink_set_status(AVFilterLink *link, int status)
     if (li->status_out)
         return;
     li->frame_wanted_out = 0;
-    li->frame_blocked_in = 0;
+    if (link->dst->graph && fffiltergraph(link->dst->graph)->pipeline) {
+        FFFilterGraph *graphi = fffiltergraph(link->dst->graph);
+        ff_graph_pipeline_lock(graphi);
+        li->frame_blocked_in = 0;
+        ff_graph_pipeline_unlock(graphi);
+    } else {
+        li->frame_blocked_in = 0;
+    }
     link_set_out_status(link, status, AV_NOPTS_VALUE);
     while (ff_framequeue_queued_frames(&li->fifo)) {
            AVFrame *frame = ff_framequeue_take(&li->fifo);
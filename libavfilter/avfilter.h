@@ -269,6 +269,15 @@ unsigned avfilter_filter_pad_count(const AVFilter *filter, int is_output);
  * Process multiple parts of the frame concurrently.
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
+/**
+ * Activate several filters of the graph concurrently, so that consecutive
+ * filters process different frames at the same time.
+ *
+ * A filter is never activated concurrently with itself or with the filters
+ * it is directly linked to, and filters not allowing this threading type are
+ * only activated while no other filter is.
+ */
+#define AVFILTER_THREAD_PIPELINE (1 << 1)
 
 /** An instance of a filter */
 typedef struct AVFilterContext {
@@ -598,7 +607,15 @@ typedef struct AVFilterGraph {
      * of AVFILTER_THREAD_* flags.
      *
      * May be set by the caller at any point, the setting will apply to all
-     * filters initialized after that. The default is allowing everything.
+     * filters initialized after that. The default is AVFILTER_THREAD_SLICE.
+     *
+     * With AVFILTER_THREAD_PIPELINE, the filters are activated by a pool of
+     * threads started by avfilter_graph_config(), and frames added to the
+     * buffer sources without AV_BUFFERSRC_FLAG_PUSH keep being processed in
+     * the background until the next call to the graph API; the graph API must
+     * still be called from a single thread at a time. Graphs containing
+     * filters sending commands to the graph or inspecting it, such as sendcmd,
+     * zmq or graphmonitor, are run without the pipeline threads.
      *
      * When a filter in this graph is initialized, this field is combined using
      * bit AND with AVFilterContext.thread_type to get the final mask used for
@@ -632,6 +649,9 @@ typedef struct AVFilterGraph {
      * If this field is left unset, libavfilter will use its internal
      * implementation, which may or may not be multithreaded depending on the
      * platform and build options.
+     *
+     * With AVFILTER_THREAD_PIPELINE, this callback may be called concurrently
+     * by different filters.
      */
     avfilter_execute_func *execute;
 
@@ -644,6 +664,13 @@ typedef struct AVFilterGraph {
      * avfilter_graph_config().
      */
     unsigned max_buffered_frames;
+
+    /**
+     * With AVFILTER_THREAD_PIPELINE, number of frames a filter may produce
+     * ahead of its destination on each of its outputs. This field must be set
+     * before calling avfilter_graph_config().
+     */
+    unsigned pipeline_queue_size;
 } AVFilterGraph;
 
 /**
@@ -110,12 +110,22 @@ typedef struct FFFilterContext {
      */
     unsigned ready;
 
+    /**
+     * With pipeline threading, set while the filter is being activated by a
+     * pipeline thread or used by the caller of the graph API.
+     * Protected by the pipeline lock.
+     */
+    int busy;
+
     /// parsed expression
     struct AVExpr *enable;
     /// variable values for the enable expression
     double *var_values;
 
     struct AVFilterCommand *command_queue;
+
+    /// number of input frames that had to be copied to make them writable
+    uint64_t nb_frame_copies;
 } FFFilterContext;
 
 static inline FFFilterContext *fffilterctx(AVFilterContext *ctx)
@@ -145,6 +155,12 @@ typedef struct FFFilterGraph {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    /// pipeline threads, non-NULL while they are running
+    struct FFGraphPipeline *pipeline;
+
+    /// total number of frames copied by ff_inlink_make_frame_writable()
+    uint64_t nb_frame_copies;
 } FFFilterGraph;
 
 static inline FFFilterGraph *fffiltergraph(AVFilterGraph *graph)
@@ -192,6 +208,52 @@ int ff_graph_thread_init(FFFilterGraph *graph);
 
 void ff_graph_thread_free(FFFilterGraph *graph);
 
+/**
+ * Start the threads activating the filters of a configured graph, if
+ * AVFILTER_THREAD_PIPELINE is enabled.
+ */
+int ff_graph_pipeline_start(FFFilterGraph *graph);
+
+/**
+ * Wait for the current activations to finish and stop the pipeline threads.
+ * The graph is run by its caller again afterwards.
+ */
+void ff_graph_pipeline_stop(FFFilterGraph *graph);
+
+/**
+ * Lock the state shared between filters running concurrently: the status
+ * fields of the links touched from both ends, the age heap and the graph
+ * statistics. Must only be called while graph->pipeline is set.
+ */
+void ff_graph_pipeline_lock(FFFilterGraph *graph);
+void ff_graph_pipeline_unlock(FFFilterGraph *graph);
+
+/**
+ * Wait until the filter and the filters linked to it are not being
+ * activated, and keep the pipeline threads from activating them until
+ * ff_graph_pipeline_release() is called. If filter is NULL, wait until no
+ * filter is being activated and keep the whole graph.
+ *
+ * To be called by the functions of the public API accessing a filter.
+ * Does nothing if the pipeline is not running.
+ */
+void ff_graph_pipeline_claim(FFFilterGraph *graph, AVFilterContext *filter);
+void ff_graph_pipeline_release(FFFilterGraph *graph);
+
+/**
+ * Raise the ready status of a filter and wake a pipeline thread.
+ */
+void ff_graph_pipeline_set_ready(FFFilterGraph *graph, FFFilterContext *ctxi,
+                                 unsigned priority);
+
+/**
+ * Wait for the pipeline threads to make progress.
+ *
+ * @return 0 after an activation, AVERROR(EAGAIN) if no filter is ready,
+ *         FFERROR_BUFFERSRC_EMPTY or the error returned by an activation
+ */
+int ff_graph_pipeline_run_once(FFFilterGraph *graph);
+
 /**
  * Negotiate the media format, dimensions, etc of all inputs to a filter.
  *
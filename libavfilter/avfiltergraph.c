@@ -49,6 +49,7 @@ static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, F|V|A, .unit = "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = F|V|A, .unit = "thread_type" },
+        { "pipeline", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_PIPELINE }, .flags = F|V|A, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, F|V|A, .unit = "threads"},
         {"auto", "autodetect a suitable number of threads to use", 0, AV_OPT_TYPE_CONST, {.i64 = 0 }, .flags = F|V|A, .unit = "threads"},
@@ -58,6 +59,11 @@ static const AVOption filtergraph_options[] = {
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|A },
     {"max_buffered_frames"  , "maximum number of buffered frames allowed", OFFSET(max_buffered_frames),
         AV_OPT_TYPE_UINT,   {.i64 = 0}, 0, UINT_MAX, F|V|A },
+    {"pipeline_queue_size"  , "maximum number of frames produced ahead on each link with pipeline threading",
+        OFFSET(pipeline_queue_size), AV_OPT_TYPE_UINT, {.i64 = 2}, 1, UINT_MAX, F|V|A },
+    {"frame_copies"         , "number of shared frames copied to make them writable",
+        offsetof(FFFilterGraph, nb_frame_copies), AV_OPT_TYPE_UINT64, {.i64 = 0}, 0, UINT64_MAX,
+        F|V|A|AV_OPT_FLAG_EXPORT|AV_OPT_FLAG_READONLY },
     { NULL },
 };
 
@@ -80,6 +86,41 @@ int ff_graph_thread_init(FFFilterGraph *graph)
     graph->p.nb_threads  = 1;
     return 0;
 }
+
+int ff_graph_pipeline_start(FFFilterGraph *graph)
+{
+    return 0;
+}
+
+void ff_graph_pipeline_stop(FFFilterGraph *graph)
+{
+}
+
+void ff_graph_pipeline_lock(FFFilterGraph *graph)
+{
+}
+
+void ff_graph_pipeline_unlock(FFFilterGraph *graph)
+{
+}
+
+void ff_graph_pipeline_claim(FFFilterGraph *graph, AVFilterContext *filter)
+{
+}
+
+void ff_graph_pipeline_release(FFFilterGraph *graph)
+{
+}
+
+void ff_graph_pipeline_set_ready(FFFilterGraph *graph, FFFilterContext *ctxi,
+                                 unsigned priority)
+{
+}
+
+int ff_graph_pipeline_run_once(FFFilterGraph *graph)
+{
+    return AVERROR(ENOSYS);
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -101,6 +142,8 @@ AVFilterGraph *avfilter_graph_alloc(void)
 void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter)
 {
     int i, j;
+
+    ff_graph_pipeline_stop(fffiltergraph(graph));
     for (i = 0; i < graph->nb_filters; i++) {
         if (graph->filters[i] == filter) {
             FFSWAP(AVFilterContext*, graph->filters[i],
@@ -124,9 +167,14 @@ void avfilter_graph_free(AVFilterGraph **graphp)
     if (!graph)
         return;
 
+    ff_graph_pipeline_stop(graphi);
     while (graph->nb_filters)
         avfilter_free(graph->filters[0]);
 
+    if (graphi->nb_frame_copies)
+        av_log(graph, AV_LOG_VERBOSE, "%"PRIu64" frames copied in total to make "
+               "them writable\n", graphi->nb_frame_copies);
+
     ff_graph_thread_free(graphi);
 
     av_freep(&graphi->sink_links);
@@ -171,7 +219,7 @@ AVFilterContext *avfilter_graph_alloc_filter(AVFilterGraph *graph,
     AVFilterContext **filters, *s;
     FFFilterGraph *graphi = fffiltergraph(graph);
 
-    if (graph->thread_type && !graphi->thread_execute) {
+    if (graph->thread_type & AVFILTER_THREAD_SLICE && !graphi->thread_execute) {
         if (graph->execute) {
             graphi->thread_execute = graph->execute;
         } else {
@@ -1435,6 +1483,7 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
 {
     int ret;
 
+    ff_graph_pipeline_stop(fffiltergraph(graphctx));
     if (graphctx->max_buffered_frames)
         fffiltergraph(graphctx)->frame_queues.max_queued = graphctx->max_buffered_frames;
     if ((ret = graph_check_validity(graphctx, log_ctx)))
@@ -1447,19 +1496,21 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
+    if ((ret = ff_graph_pipeline_start(fffiltergraph(graphctx))) < 0) {
+        av_log(log_ctx, AV_LOG_ERROR, "Error starting the pipeline threads: %s\n",
+               av_err2str(ret));
+        return ret;
+    }
 
     return 0;
 }
 
-int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const char *cmd, const char *arg, char *res, int res_len, int flags)
+int ff_filter_graph_send_command(AVFilterGraph *graph, const char *target, const char *cmd, const char *arg, char *res, int res_len, int flags)
 {
     int i, r = AVERROR(ENOSYS);
 
-    if (!graph)
-        return r;
-
     if ((flags & AVFILTER_CMD_FLAG_ONE) && !(flags & AVFILTER_CMD_FLAG_FAST)) {
-        r = avfilter_graph_send_command(graph, target, cmd, arg, res, res_len, flags | AVFILTER_CMD_FLAG_FAST);
+        r = ff_filter_graph_send_command(graph, target, cmd, arg, res, res_len, flags | AVFILTER_CMD_FLAG_FAST);
         if (r != AVERROR(ENOSYS))
             return r;
     }
@@ -1481,12 +1532,22 @@ int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const
     return r;
 }
 
-int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const char *command, const char *arg, int flags, double ts)
+int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const char *cmd, const char *arg, char *res, int res_len, int flags)
 {
-    int i;
+    int ret;
 
-    if(!graph)
-        return 0;
+    if (!graph)
+        return AVERROR(ENOSYS);
+
+    ff_graph_pipeline_claim(fffiltergraph(graph), NULL);
+    ret = ff_filter_graph_send_command(graph, target, cmd, arg, res, res_len, flags);
+    ff_graph_pipeline_release(fffiltergraph(graph));
+    return ret;
+}
+
+static int queue_command(AVFilterGraph *graph, const char *target, const char *command, const char *arg, int flags, double ts)
+{
+    int i;
 
     for (i = 0; i < graph->nb_filters; i++) {
         AVFilterContext *filter = graph->filters[i];
@@ -1513,6 +1574,19 @@ int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const
     return 0;
 }
 
+int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const char *command, const char *arg, int flags, double ts)
+{
+    int ret;
+
+    if(!graph)
+        return 0;
+
+    ff_graph_pipeline_claim(fffiltergraph(graph), NULL);
+    ret = queue_command(graph, target, command, arg, flags, ts);
+    ff_graph_pipeline_release(fffiltergraph(graph));
+    return ret;
+}
+
 static void heap_bubble_up(FFFilterGraph *graph,
                            FilterLinkInternal *li, int index)
 {
@@ -1564,7 +1638,7 @@ void ff_avfilter_graph_update_heap(AVFilterGraph *graph, FilterLinkInternal *li)
     heap_bubble_down(graphi, li, li->age_index);
 }
 
-int avfilter_graph_request_oldest(AVFilterGraph *graph)
+static int request_oldest(AVFilterGraph *graph)
 {
     FFFilterGraph *graphi = fffiltergraph(graph);
     FilterLinkInternal *oldesti = graphi->sink_links[0];
@@ -1613,11 +1687,27 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
     return 0;
 }
 
+int avfilter_graph_request_oldest(AVFilterGraph *graph)
+{
+    FFFilterGraph *graphi = fffiltergraph(graph);
+    int ret;
+
+    /* the age heap and the sink links are only accessed with the whole graph
+     * claimed, ff_filter_graph_run_once() lets the pipeline threads run */
+    ff_graph_pipeline_claim(graphi, NULL);
+    ret = request_oldest(graph);
+    ff_graph_pipeline_release(graphi);
+    return ret;
+}
+
 int ff_filter_graph_run_once(AVFilterGraph *graph)
 {
     FFFilterContext *ctxi;
     unsigned i;
 
+    if (fffiltergraph(graph)->pipeline)
+        return ff_graph_pipeline_run_once(fffiltergraph(graph));
+
     av_assert0(graph->nb_filters);
     ctxi = fffilterctx(graph->filters[0]);
     for (i = 1; i < graph->nb_filters; i++) {
@@ -1629,5 +1719,6 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
 
     if (!ctxi->ready)
         return AVERROR(EAGAIN);
+    ctxi->ready = 0;
     return ff_filter_activate(&ctxi->p);
 }
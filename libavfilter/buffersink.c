@@ -110,7 +110,7 @@ static int return_or_keep_frame(BufferSinkContext *buf, AVFrame *out, AVFrame *i
     }
 }
 
-static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, int samples)
+static int get_frame_claimed(AVFilterContext *ctx, AVFrame *frame, int flags, int samples)
 {
     BufferSinkContext *buf = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
@@ -138,6 +138,10 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
         } else if (li->frame_wanted_out) {
             ret = ff_filter_graph_run_once(ctx->graph);
             if (ret == FFERROR_BUFFERSRC_EMPTY) {
+                /* with pipeline threading, let the caller add frames while
+                 * the pipeline threads process the previous ones */
+                if (fffiltergraph(ctx->graph)->pipeline)
+                    return AVERROR(EAGAIN);
                 buffersrc_empty = 1;
             } else if (ret == AVERROR(EAGAIN)) {
                 if (buffersrc_empty)
@@ -152,6 +156,18 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
     }
 }
 
+static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, int samples)
+{
+    FFFilterGraph *graphi = fffiltergraph(ctx->graph);
+    int ret;
+
+    /* keep the pipeline threads off the input link while using it */
+    ff_graph_pipeline_claim(graphi, ctx);
+    ret = get_frame_claimed(ctx, frame, flags, samples);
+    ff_graph_pipeline_release(graphi);
+    return ret;
+}
+
 int attribute_align_arg av_buffersink_get_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
 {
     return get_frame_internal(ctx, frame, flags,
@@ -196,6 +196,8 @@ static int push_frame(AVFilterGraph *graph)
 {
     int ret;
 
+    /* with pipeline threading, wait for the pipeline threads to be done with
+     * the frame, like the caller would have done without them */
     while (1) {
         ret = ff_filter_graph_run_once(graph);
         if (ret == AVERROR(EAGAIN))
@@ -206,7 +208,16 @@ static int push_frame(AVFilterGraph *graph)
     return 0;
 }
 
-int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
+static int close_source(AVFilterContext *ctx, int64_t pts, unsigned flags)
+{
+    BufferSourceContext *s = ctx->priv;
+
+    s->eof = 1;
+    ff_avfilter_link_set_in_status(ctx->outputs[0], AVERROR_EOF, pts);
+    return (flags & AV_BUFFERSRC_FLAG_PUSH) ? push_frame(ctx->graph) : 0;
+}
+
+static int add_frame(AVFilterContext *ctx, AVFrame *frame, int flags)
 {
     BufferSourceContext *s = ctx->priv;
     AVFrame *copy;
@@ -215,7 +226,7 @@ int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFra
     s->nb_failed_requests = 0;
 
     if (!frame)
-        return av_buffersrc_close(ctx, s->last_pts, flags);
+        return close_source(ctx, s->last_pts, flags);
     if (s->eof)
         return AVERROR_EOF;
 
@@ -277,21 +288,37 @@ int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFra
     return 0;
 }
 
+int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
+{
+    FFFilterGraph *graphi = fffiltergraph(ctx->graph);
+    int ret;
+
+    ff_graph_pipeline_claim(graphi, ctx);
+    ret = add_frame(ctx, frame, flags);
+    ff_graph_pipeline_release(graphi);
+    return ret;
+}
+
 int av_buffersrc_close(AVFilterContext *ctx, int64_t pts, unsigned flags)
 {
-    BufferSourceContext *s = ctx->priv;
+    FFFilterGraph *graphi = fffiltergraph(ctx->graph);
+    int ret;
 
-    s->eof = 1;
-    ff_avfilter_link_set_in_status(ctx->outputs[0], AVERROR_EOF, pts);
-    return (flags & AV_BUFFERSRC_FLAG_PUSH) ? push_frame(ctx->graph) : 0;
+    ff_graph_pipeline_claim(graphi, ctx);
+    ret = close_source(ctx, pts, flags);
+    ff_graph_pipeline_release(graphi);
+    return ret;
 }
 
 int av_buffersrc_get_status(AVFilterContext *ctx)
 {
     BufferSourceContext *s = ctx->priv;
+    FFFilterGraph *graphi = fffiltergraph(ctx->graph);
 
+    ff_graph_pipeline_claim(graphi, ctx);
     if (!s->eof && ff_outlink_get_status(ctx->outputs[0]))
         s->eof = 1;
+    ff_graph_pipeline_release(graphi);
 
     return s->eof ? AVERROR(EOF) : 0;
 }
@@ -332,7 +359,13 @@ static av_cold int init_video(AVFilterContext *ctx)
 
 unsigned av_buffersrc_get_nb_failed_requests(AVFilterContext *buffer_src)
 {
-    return ((BufferSourceContext *)buffer_src->priv)->nb_failed_requests;
+    FFFilterGraph *graphi = fffiltergraph(buffer_src->graph);
+    unsigned ret;
+
+    ff_graph_pipeline_claim(graphi, buffer_src);
+    ret = ((BufferSourceContext *)buffer_src->priv)->nb_failed_requests;
+    ff_graph_pipeline_release(graphi);
+    return ret;
 }
 
 #define OFFSET(x) offsetof(BufferSourceContext, x)
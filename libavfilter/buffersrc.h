@@ -42,6 +42,10 @@ enum {
 
     /**
      * Immediately push the frame to the output.
+     *
+     * With AVFILTER_THREAD_PIPELINE, wait until the graph has processed the
+     * frame as far as it can; without this flag, it is processed in the
+     * background by the pipeline threads.
      */
     AV_BUFFERSRC_FLAG_PUSH = 4,
 
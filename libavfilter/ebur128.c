@@ -53,6 +53,9 @@
 #include "libavutil/mem_internal.h"
 #include "libavutil/thread.h"
 
+#include "avfilter.h"
+#include "filters.h"
+
 #define CHECK_ERROR(condition, errorcode, goto_point)                          \
     if ((condition)) {                                                         \
         errcode = (errorcode);                                                 \
@@ -97,8 +100,18 @@ struct FFEBUR128StateInternal {
     unsigned long window;
     /** Data pointer array for interleaved data */
     void **data_ptrs;
+    /** Filter whose slice threads filter the channels, may be NULL. */
+    AVFilterContext *ctx;
 };
 
+typedef struct FilterThreadData {
+    FFEBUR128State *st;
+    const void **srcs;
+    size_t src_index;
+    size_t frames;
+    int stride;
+} FilterThreadData;
+
 static AVOnce histogram_init = AV_ONCE_INIT;
 static DECLARE_ALIGNED(32, double, histogram_energies)[1000];
 static DECLARE_ALIGNED(32, double, histogram_energy_boundaries)[1001];
@@ -226,7 +239,7 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
     st = (FFEBUR128State *) av_malloc(sizeof(*st));
     CHECK_ERROR(!st, 0, exit)
     st->d = (struct FFEBUR128StateInternal *)
-        av_malloc(sizeof(*st->d));
+        av_mallocz(sizeof(*st->d));
     CHECK_ERROR(!st->d, 0, free_state)
     st->channels = channels;
     errcode = ebur128_init_channel_map(st);
@@ -315,14 +328,14 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
 }
 
 #define EBUR128_FILTER(type, scaling_factor)                                       \
-static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
+static void ebur128_filter_channels_##type(FFEBUR128State* st, const type** srcs,  \
                                   size_t src_index, size_t frames,                 \
-                                  int stride) {                                    \
+                                  int stride, size_t c_start, size_t c_end) {      \
     double* audio_data = st->d->audio_data + st->d->audio_data_index;              \
     size_t i, c;                                                                   \
                                                                                    \
     if ((st->mode & FF_EBUR128_MODE_SAMPLE_PEAK) == FF_EBUR128_MODE_SAMPLE_PEAK) { \
-        for (c = 0; c < st->channels; ++c) {                                       \
+        for (c = c_start; c < c_end; ++c) {                                        \
             double max = 0.0;                                                      \
             for (i = 0; i < frames; ++i) {                                         \
                 type v = srcs[c][src_index + i * stride];                          \
@@ -336,7 +349,7 @@ static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,
             if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;          \
         }                                                                          \
     }                                                                              \
-    for (c = 0; c < st->channels; ++c) {                                           \
+    for (c = c_start; c < c_end; ++c) {                                            \
         int ci = st->d->channel_map[c] - 1;                                        \
         if (ci < 0) continue;                                                      \
         else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */            \
@@ -362,6 +375,38 @@ static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,
         st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
         st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1]; \
     }                                                                              \
+}                                                                                  \
+                                                                                   \
+static int ebur128_filter_slice_##type(AVFilterContext *ctx, void *arg,            \
+                                       int jobnr, int nb_jobs) {                   \
+    FilterThreadData *td = arg;                                                    \
+    size_t channels = td->st->channels;                                            \
+                                                                                   \
+    ebur128_filter_channels_##type(td->st, (const type **)td->srcs, td->src_index, \
+                                   td->frames, td->stride,                         \
+                                   channels * jobnr / nb_jobs,                     \
+                                   channels * (jobnr + 1) / nb_jobs);              \
+    return 0;                                                                      \
+}                                                                                  \
+                                                                                   \
+static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
+                                  size_t src_index, size_t frames,                 \
+                                  int stride) {                                    \
+    /* each channel has its own filter state, sample peak and samples in      */ \
+    /* audio_data, so the channels can be filtered concurrently               */ \
+    int nb_jobs = st->d->ctx ? FFMIN(st->channels,                                 \
+                                     ff_filter_get_nb_threads(st->d->ctx)) : 1;    \
+                                                                                   \
+    if (nb_jobs > 1) {                                                             \
+        FilterThreadData td = {                                                    \
+            .st = st, .srcs = (const void **)srcs, .src_index = src_index,         \
+            .frames = frames, .stride = stride,                                    \
+        };                                                                         \
+        ff_filter_execute(st->d->ctx, ebur128_filter_slice_##type, &td, NULL,      \
+                          nb_jobs);                                                \
+    } else                                                                         \
+        ebur128_filter_channels_##type(st, srcs, src_index, frames, stride,        \
+                                       0, st->channels);                           \
 }
 EBUR128_FILTER(double, 1.0)
 
@@ -442,6 +487,11 @@ static void ebur128_calc_gating_block(FFEBUR128State * st,
     }
 }
 
+void ff_ebur128_set_filter_context(FFEBUR128State * st, AVFilterContext *ctx)
+{
+    st->d->ctx = ctx;
+}
+
 int ff_ebur128_set_channel(FFEBUR128State * st,
                            unsigned int channel_number, int value)
 {
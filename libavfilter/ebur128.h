@@ -95,6 +95,7 @@ enum mode {
 
 /** forward declaration of FFEBUR128StateInternal */
 struct FFEBUR128StateInternal;
+struct AVFilterContext;
 
 /** \brief Contains information about the state of a loudness measurement.
  *
@@ -125,6 +126,18 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
  */
 void ff_ebur128_destroy(FFEBUR128State ** st);
 
+/** \brief Filter the channels with the slice threads of a filter.
+ *
+ *  The channels are split into as many ranges as the filter has threads; the
+ *  result does not depend on the number of threads.
+ *
+ *  @param st library state.
+ *  @param ctx filter whose ff_filter_execute() is used, NULL to filter all
+ *             the channels on the calling thread.
+ */
+void ff_ebur128_set_filter_context(FFEBUR128State * st,
+                                   struct AVFilterContext *ctx);
+
 /** \brief Set channel type.
  *
  *  The default is:
@@ -77,6 +77,30 @@ struct integrator {
 
 struct rect { int x, y, w, h; };
 
+/**
+ * Range of channels filtered by one job.
+ */
+typedef struct EBUR128Slice {
+    int ch_start;                   ///< first channel of the slice
+    int nb_channels;                ///< number of channels in the slice
+    EBUR128DSPContext dsp;          ///< DSP context pointing to the filter state of the slice channels
+    double peak;                    ///< maximum true peak of the slice in the current frame
+    int ret;                        ///< result of the true peak computation of the slice
+#if CONFIG_SWRESAMPLE
+    SwrContext *swr_ctx;            ///< over-sampling context for the slice channels
+    double *swr_in;                 ///< slice channels of the input, unused with a single slice
+    unsigned int swr_in_size;
+    double *swr_buf;                ///< resampled audio data of the slice channels
+#endif
+} EBUR128Slice;
+
+typedef struct ThreadData {
+    const double *samples;
+    int nb_samples;
+    int cache_pos_400;
+    int cache_pos_3000;
+} ThreadData;
+
 typedef struct EBUR128Context {
     const AVClass *class;           ///< AVClass context for log and options purpose
     EBUR128DSPContext dsp;
@@ -88,11 +112,8 @@ typedef struct EBUR128Context {
     double sample_peak;             ///< global sample peak
     double *sample_peaks;           ///< sample peaks per channel
     double *true_peaks_per_frame;   ///< true peaks in a frame per channel
-#if CONFIG_SWRESAMPLE
-    SwrContext *swr_ctx;            ///< over-sampling context for true peak metering
-    double *swr_buf;                ///< resampled audio data for true peak metering
-    int swr_linesize;
-#endif
+    EBUR128Slice *slices;           ///< channel ranges processed in parallel
+    int nb_slices;
 
     /* video  */
     int do_video;                   ///< 1 if video output enabled, 0 otherwise
@@ -470,29 +491,62 @@ static int config_audio_output(AVFilterLink *outlink)
         }
     }
 
+    /* the channels are split in pairs, which the SIMD filter processes
+     * together */
+    ebur128->nb_slices = av_clip(ff_filter_get_nb_threads(ctx), 1, (nb_channels + 1) / 2);
+    ebur128->slices = av_calloc(ebur128->nb_slices, sizeof(*ebur128->slices));
+    if (!ebur128->slices)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < ebur128->nb_slices; i++) {
+        EBUR128Slice *slice = &ebur128->slices[i];
+        const int nb_pairs = (nb_channels + 1) / 2;
+        const int ch_end = FFMIN(nb_pairs * (i + 1) / ebur128->nb_slices * 2, nb_channels);
+
+        slice->ch_start    = nb_pairs * i / ebur128->nb_slices * 2;
+        slice->nb_channels = ch_end - slice->ch_start;
+        slice->dsp         = ebur128->dsp;
+        slice->dsp.y      += 3 * slice->ch_start;
+        slice->dsp.z      += 3 * slice->ch_start;
+#if ARCH_X86 && HAVE_X86ASM
+        ff_ebur128_init_x86(&slice->dsp, slice->nb_channels);
+#endif
+    }
+
 #if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS) {
-        int ret;
-
-        ebur128->swr_buf    = av_malloc_array(nb_channels, 19200 * sizeof(double));
         ebur128->true_peaks = av_calloc(nb_channels, sizeof(*ebur128->true_peaks));
         ebur128->true_peaks_per_frame = av_calloc(nb_channels, sizeof(*ebur128->true_peaks_per_frame));
-        ebur128->swr_ctx    = swr_alloc();
-        if (!ebur128->swr_buf || !ebur128->true_peaks ||
-            !ebur128->true_peaks_per_frame || !ebur128->swr_ctx)
+        if (!ebur128->true_peaks || !ebur128->true_peaks_per_frame)
             return AVERROR(ENOMEM);
 
-        av_opt_set_chlayout(ebur128->swr_ctx, "in_chlayout",    &outlink->ch_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "in_sample_rate",       outlink->sample_rate, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "in_sample_fmt", outlink->format, 0);
+        for (i = 0; i < ebur128->nb_slices; i++) {
+            EBUR128Slice *slice = &ebur128->slices[i];
+            AVChannelLayout ch_layout;
+            int ret;
 
-        av_opt_set_chlayout(ebur128->swr_ctx, "out_chlayout",    &outlink->ch_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "out_sample_rate",       192000, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "out_sample_fmt", outlink->format, 0);
+            if (ebur128->nb_slices > 1)
+                av_channel_layout_default(&ch_layout, slice->nb_channels);
+            else
+                ch_layout = outlink->ch_layout;
 
-        ret = swr_init(ebur128->swr_ctx);
-        if (ret < 0)
-            return ret;
+            slice->swr_buf = av_malloc_array(slice->nb_channels, 19200 * sizeof(double));
+            slice->swr_ctx = swr_alloc();
+            if (!slice->swr_buf || !slice->swr_ctx)
+                return AVERROR(ENOMEM);
+
+            av_opt_set_chlayout(slice->swr_ctx, "in_chlayout",    &ch_layout, 0);
+            av_opt_set_int(slice->swr_ctx, "in_sample_rate",       outlink->sample_rate, 0);
+            av_opt_set_sample_fmt(slice->swr_ctx, "in_sample_fmt", outlink->format, 0);
+
+            av_opt_set_chlayout(slice->swr_ctx, "out_chlayout",    &ch_layout, 0);
+            av_opt_set_int(slice->swr_ctx, "out_sample_rate",       192000, 0);
+            av_opt_set_sample_fmt(slice->swr_ctx, "out_sample_fmt", outlink->format, 0);
+
+            ret = swr_init(slice->swr_ctx);
+            if (ret < 0)
+                return ret;
+        }
     }
 #endif
 
@@ -654,19 +708,119 @@ double ff_ebur128_find_peak_c(double *restrict ch_peaks, const int nb_channels,
                               const double *samples, const int nb_samples)
 {
     double maxpeak = 0.0;
-    for (int ch = 0; ch < nb_channels; ch++) {
-        double ch_peak = ch_peaks[ch];
-        for (int i = 0; i < nb_samples; i++) {
-            const double sample = fabs(samples[i * nb_channels + ch]);
-            ch_peak = FFMAX(ch_peak, sample);
+
+    /* walk the samples in memory order, the inner loop can be vectorized */
+    for (int i = 0; i < nb_samples; i++) {
+        for (int ch = 0; ch < nb_channels; ch++) {
+            const double sample = fabs(samples[ch]);
+            ch_peaks[ch] = FFMAX(ch_peaks[ch], sample);
         }
-        maxpeak = FFMAX(maxpeak, ch_peak);
-        ch_peaks[ch] = ch_peak;
+        samples += nb_channels;
     }
 
+    for (int ch = 0; ch < nb_channels; ch++)
+        maxpeak = FFMAX(maxpeak, ch_peaks[ch]);
+
     return maxpeak;
 }
 
+#if CONFIG_SWRESAMPLE
+static int true_peak_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    EBUR128Context *ebur128 = ctx->priv;
+    const ThreadData *td = arg;
+    EBUR128Slice *slice = &ebur128->slices[jobnr];
+    const double *samples = td->samples;
+    int ret;
+
+    if (ebur128->nb_slices > 1) {
+        const double *src = td->samples + slice->ch_start;
+        double *dst;
+
+        av_fast_malloc(&slice->swr_in, &slice->swr_in_size,
+                       td->nb_samples * slice->nb_channels * sizeof(*slice->swr_in));
+        if (!slice->swr_in)
+            return slice->ret = AVERROR(ENOMEM);
+        dst = slice->swr_in;
+
+        for (int i = 0; i < td->nb_samples; i++) {
+            for (int ch = 0; ch < slice->nb_channels; ch++)
+                dst[ch] = src[ch];
+            src += ebur128->nb_channels;
+            dst += slice->nb_channels;
+        }
+        samples = slice->swr_in;
+    }
+
+    ret = swr_convert(slice->swr_ctx, (uint8_t **)&slice->swr_buf, 19200,
+                      (const uint8_t **)&samples, td->nb_samples);
+    if (ret < 0)
+        return slice->ret = ret;
+
+    memset(ebur128->true_peaks_per_frame + slice->ch_start, 0,
+           slice->nb_channels * sizeof(*ebur128->true_peaks_per_frame));
+
+    slice->peak = slice->dsp.find_peak(ebur128->true_peaks_per_frame + slice->ch_start,
+                                       slice->nb_channels, slice->swr_buf, ret);
+    return slice->ret = 0;
+}
+#endif
+
+static int filter_channels_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    EBUR128Context *ebur128 = ctx->priv;
+    const ThreadData *td = arg;
+    const EBUR128Slice *slice = &ebur128->slices[jobnr];
+    const int nb_channels = ebur128->nb_channels;
+    const int ch = slice->ch_start;
+    int pos_400  = td->cache_pos_400;
+    int pos_3000 = td->cache_pos_3000;
+
+    for (int i = 0; i < td->nb_samples; i++) {
+        slice->dsp.filter_channels(&slice->dsp, &td->samples[i * nb_channels + ch],
+                                   &ebur128->i400.cache[pos_400 * nb_channels + ch],
+                                   &ebur128->i3000.cache[pos_3000 * nb_channels + ch],
+                                   ebur128->i400.sum + ch, ebur128->i3000.sum + ch,
+                                   slice->nb_channels);
+
+        if (++pos_400 == ebur128->i400.cache_size)
+            pos_400 = 0;
+        if (++pos_3000 == ebur128->i3000.cache_size)
+            pos_3000 = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * K-filter nb_samples samples of all the channels and add them to the
+ * 400ms and 3s windows.
+ */
+static void filter_samples(AVFilterContext *ctx, const double *samples, int nb_samples)
+{
+    EBUR128Context *ebur128 = ctx->priv;
+    ThreadData td = {
+        .samples        = samples,
+        .nb_samples     = nb_samples,
+        .cache_pos_400  = ebur128->i400.cache_pos,
+        .cache_pos_3000 = ebur128->i3000.cache_pos,
+    };
+
+    ff_filter_execute(ctx, filter_channels_slice, &td, NULL, ebur128->nb_slices);
+
+    ebur128->i400.cache_pos += nb_samples;
+    if (ebur128->i400.cache_pos >= ebur128->i400.cache_size) {
+        ebur128->i400.filled     = 1;
+        ebur128->i400.cache_pos %= ebur128->i400.cache_size;
+    }
+
+    ebur128->i3000.cache_pos += nb_samples;
+    if (ebur128->i3000.cache_pos >= ebur128->i3000.cache_size) {
+        ebur128->i3000.filled     = 1;
+        ebur128->i3000.cache_pos %= ebur128->i3000.cache_size;
+    }
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
 {
     int ret;
@@ -676,21 +830,21 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     const int nb_channels = ebur128->nb_channels;
     const int nb_samples  = insamples->nb_samples;
     const double *samples = (double *)insamples->data[0];
+    const int period = inlink->sample_rate / 10;
+    int filtered_end = ebur128->idx_insample;
     AVFrame *pic;
 
 #if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS && ebur128->idx_insample == 0) {
-        const double *swr_samples = ebur128->swr_buf;
-        int ret = swr_convert(ebur128->swr_ctx, (uint8_t**)&ebur128->swr_buf, 19200,
-                              (const uint8_t **)insamples->data, nb_samples);
-        if (ret < 0)
-            return ret;
-
-        memset(ebur128->true_peaks_per_frame, 0,
-               nb_channels * sizeof(*ebur128->true_peaks_per_frame));
-
-        double peak = dsp->find_peak(ebur128->true_peaks_per_frame, nb_channels,
-                                     swr_samples, ret);
+        ThreadData td = { .samples = samples, .nb_samples = nb_samples };
+        double peak = 0.0;
+
+        ff_filter_execute(ctx, true_peak_slice, &td, NULL, ebur128->nb_slices);
+        for (int i = 0; i < ebur128->nb_slices; i++) {
+            if (ebur128->slices[i].ret < 0)
+                return ebur128->slices[i].ret;
+            peak = FFMAX(peak, ebur128->slices[i].peak);
+        }
 
         for (int ch = 0; ch < nb_channels; ch++) {
             peak = FFMAX(peak, ebur128->true_peaks[ch]);
@@ -709,29 +863,20 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     }
 
     for (int idx_insample = ebur128->idx_insample; idx_insample < nb_samples; idx_insample++) {
-        const int bin_id_400  = ebur128->i400.cache_pos++;
-        const int bin_id_3000 = ebur128->i3000.cache_pos++;
-
-        if (ebur128->i400.cache_pos == ebur128->i400.cache_size) {
-            ebur128->i400.filled    = 1;
-            ebur128->i400.cache_pos = 0;
+        /* filter the samples up to the next gating block at once */
+        if (idx_insample == filtered_end) {
+            int nb = nb_samples - idx_insample;
+
+            if (period > 0)
+                nb = FFMIN(nb, period - ebur128->sample_count);
+            filter_samples(ctx, &samples[idx_insample * nb_channels], nb);
+            filtered_end = idx_insample + nb;
         }
 
-        if (ebur128->i3000.cache_pos == ebur128->i3000.cache_size) {
-            ebur128->i3000.filled    = 1;
-            ebur128->i3000.cache_pos = 0;
-        }
-
-        dsp->filter_channels(dsp, &samples[idx_insample * nb_channels],
-                             &ebur128->i400.cache[bin_id_400 * nb_channels],
-                             &ebur128->i3000.cache[bin_id_3000 * nb_channels],
-                             ebur128->i400.sum, ebur128->i3000.sum,
-                             nb_channels);
-
         /* For integrated loudness, gating blocks are 400ms long with 75%
          * overlap (see BS.1770-2 p5), so a re-computation is needed each 100ms
          * (4800 samples at 48kHz). */
-        if (++ebur128->sample_count == inlink->sample_rate / 10) {
+        if (++ebur128->sample_count == period) {
             double loudness_400, loudness_3000;
             double power_400 = 1e-12, power_3000 = 1e-12;
             AVFilterLink *outlink = ctx->outputs[0];
@@ -1091,10 +1236,14 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&ebur128->i400.cache);
     av_freep(&ebur128->i3000.cache);
     av_frame_free(&ebur128->outpicref);
+    for (int i = 0; i < ebur128->nb_slices; i++) {
 #if CONFIG_SWRESAMPLE
-    av_freep(&ebur128->swr_buf);
-    swr_free(&ebur128->swr_ctx);
+        swr_free(&ebur128->slices[i].swr_ctx);
+        av_freep(&ebur128->slices[i].swr_in);
+        av_freep(&ebur128->slices[i].swr_buf);
 #endif
+    }
+    av_freep(&ebur128->slices);
 }
 
 static const AVFilterPad ebur128_inputs[] = {
@@ -1110,7 +1259,8 @@ const FFFilter ff_af_ebur128 = {
     .p.description = NULL_IF_CONFIG_SMALL("EBU R128 scanner."),
     .p.outputs     = NULL,
     .p.priv_class  = &ebur128_class,
-    .p.flags       = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+    .p.flags       = AVFILTER_FLAG_DYNAMIC_OUTPUTS |
+                     AVFILTER_FLAG_SLICE_THREADS,
     .priv_size     = sizeof(EBUR128Context),
     .init          = init,
     .uninit        = uninit,
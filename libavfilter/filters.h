@@ -207,6 +207,15 @@ static inline FilterLink* ff_filter_link(AVFilterLink *link)
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter accesses other filters of the graph than the ones it is linked
+ * to, and must not run concurrently with any of them with pipeline threading.
+ * The pipeline threads are not started for graphs containing such a filter,
+ * so that the filters it reaches see it at the same point of the stream as
+ * without them.
+ */
+#define FF_FILTER_FLAG_GRAPH_EXCLUSIVE (1 << 1)
+
 /**
  * Find the index of a link.
  *
@@ -744,6 +753,14 @@ int ff_filter_init_hw_frames(AVFilterContext *avctx, AVFilterLink *link,
 int ff_filter_process_command(AVFilterContext *ctx, const char *cmd,
                               const char *arg, char *res, int res_len, int flags);
 
+/**
+ * Same as avfilter_graph_send_command(), for filters sending commands to the
+ * graph they belong to; such filters must have FF_FILTER_FLAG_GRAPH_EXCLUSIVE.
+ */
+int ff_filter_graph_send_command(AVFilterGraph *graph, const char *target,
+                                 const char *cmd, const char *arg,
+                                 char *res, int res_len, int flags);
+
 /**
  * Get number of threads for current filter instance.
  * This number is always same or less than graph->nb_threads.
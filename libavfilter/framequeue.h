@@ -29,6 +29,8 @@
  * must be protected by a mutex or any synchronization mechanism.
  */
 
+#include <stdatomic.h>
+
 #include "libavutil/frame.h"
 
 typedef struct FFFrameBucket {
@@ -50,8 +52,10 @@ typedef struct FFFrameQueueGlobal {
 
     /**
      * Total number of queued frames in the queues combined.
+     * Atomic because the queues of a graph with pipeline threading are
+     * accessed by several threads.
      */
-    size_t queued;
+    atomic_size_t queued;
 } FFFrameQueueGlobal;
 
 /**
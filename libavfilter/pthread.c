@@ -23,13 +23,17 @@
 
 #include <stddef.h>
 
+#include "libavutil/avassert.h"
+#include "libavutil/cpu.h"
 #include "libavutil/error.h"
 #include "libavutil/macros.h"
 #include "libavutil/mem.h"
 #include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
 
 #include "avfilter.h"
 #include "avfilter_internal.h"
+#include "filters.h"
 
 typedef struct ThreadContext {
     AVFilterGraph *graph;
@@ -40,6 +44,11 @@ typedef struct ThreadContext {
     AVFilterContext *ctx;
     void *arg;
     int   *rets;
+
+    /* with pipeline threading, several filters may want the slice threads
+     * at the same time; only one of them gets them */
+    AVMutex lock;
+    int     busy;
 } ThreadContext;
 
 static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
@@ -53,30 +62,62 @@ static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb
 static void slice_thread_uninit(ThreadContext *c)
 {
     avpriv_slicethread_free(&c->thread);
+    ff_mutex_destroy(&c->lock);
 }
 
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
                           void *arg, int *ret, int nb_jobs)
 {
     ThreadContext *c = fffiltergraph(ctx->graph)->thread;
+    int pipeline = !!fffiltergraph(ctx->graph)->pipeline;
 
     if (nb_jobs <= 0)
         return 0;
+
+    if (pipeline) {
+        int busy;
+
+        ff_mutex_lock(&c->lock);
+        busy    = c->busy;
+        c->busy = 1;
+        ff_mutex_unlock(&c->lock);
+        if (busy) {
+            for (int i = 0; i < nb_jobs; i++) {
+                int r = func(ctx, arg, i, nb_jobs);
+                if (ret)
+                    ret[i] = r;
+            }
+            return 0;
+        }
+    }
+
     c->ctx         = ctx;
     c->arg         = arg;
     c->func        = func;
     c->rets        = ret;
 
     avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+
+    if (pipeline) {
+        ff_mutex_lock(&c->lock);
+        c->busy = 0;
+        ff_mutex_unlock(&c->lock);
+    }
     return 0;
 }
 
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
     nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
-    if (nb_threads <= 1)
+    if (nb_threads <= 1) {
         avpriv_slicethread_free(&c->thread);
-    return FFMAX(nb_threads, 1);
+        return FFMAX(nb_threads, 1);
+    }
+    if (ff_mutex_init(&c->lock, NULL)) {
+        avpriv_slicethread_free(&c->thread);
+        return AVERROR(ENOMEM);
+    }
+    return nb_threads;
 }
 
 int ff_graph_thread_init(FFFilterGraph *graphi)
@@ -85,7 +126,7 @@ int ff_graph_thread_init(FFFilterGraph *graphi)
     int ret;
 
     if (graph->nb_threads == 1) {
-        graph->thread_type = 0;
+        graph->thread_type &= ~AVFILTER_THREAD_SLICE;
         return 0;
     }
 
@@ -96,7 +137,7 @@ int ff_graph_thread_init(FFFilterGraph *graphi)
     ret = thread_init_internal(graphi->thread, graph->nb_threads);
     if (ret <= 1) {
         av_freep(&graphi->thread);
-        graph->thread_type = 0;
+        graph->thread_type &= ~AVFILTER_THREAD_SLICE;
         graph->nb_threads  = 1;
         return (ret < 0) ? ret : 0;
     }
@@ -113,3 +154,347 @@ void ff_graph_thread_free(FFFilterGraph *graph)
         slice_thread_uninit(graph->thread);
     av_freep(&graph->thread);
 }
+
+typedef struct FFGraphPipeline {
+    FFFilterGraph *graph;
+
+    pthread_t *workers;
+    int     nb_workers;
+
+    AVMutex lock;
+    /// signaled when a filter may have become ready to be activated
+    AVCond  work_cond;
+    /// signaled when an activation or a claim is over
+    AVCond  progress_cond;
+
+    int stop;
+    /// number of filters being activated or claimed by the caller
+    int nb_busy;
+    /// set while a filter without pipeline threading runs or while the
+    /// caller has claimed the whole graph
+    int exclusive;
+    /// number of activations done, to detect progress
+    uint64_t nb_activations;
+
+    /// filter the caller is waiting to claim, kept from the pipeline threads
+    AVFilterContext *pending_claim;
+    int pending_graph_claim;
+    /// nesting depth of the claim of the caller; a claim of the whole graph
+    /// covers the claims of its filters
+    int claimed;
+    AVFilterContext *claimed_filter;
+
+    /// status returned by the activations, for ff_graph_pipeline_run_once()
+    int error;
+    int buffersrc_empty;
+} FFGraphPipeline;
+
+static int is_neighbour(const AVFilterContext *a, const AVFilterContext *b)
+{
+    if (a == b)
+        return 1;
+    for (unsigned i = 0; i < a->nb_inputs; i++)
+        if (a->inputs[i] && a->inputs[i]->src == b)
+            return 1;
+    for (unsigned i = 0; i < a->nb_outputs; i++)
+        if (a->outputs[i] && a->outputs[i]->dst == b)
+            return 1;
+    return 0;
+}
+
+/**
+ * Check that neither the filter nor the filters linked to it are busy, i.e.
+ * that no other thread can access the links of the filter.
+ */
+static int is_free(AVFilterContext *f)
+{
+    if (fffilterctx(f)->busy)
+        return 0;
+    for (unsigned i = 0; i < f->nb_inputs; i++)
+        if (f->inputs[i] && fffilterctx(f->inputs[i]->src)->busy)
+            return 0;
+    for (unsigned i = 0; i < f->nb_outputs; i++)
+        if (f->outputs[i] && fffilterctx(f->outputs[i]->dst)->busy)
+            return 0;
+    return 1;
+}
+
+static FFFilterContext *pick_filter(FFGraphPipeline *p)
+{
+    AVFilterGraph *graph = &p->graph->p;
+    FFFilterContext *best = NULL;
+
+    if (p->exclusive || p->pending_graph_claim)
+        return NULL;
+
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f  = graph->filters[i];
+        FFFilterContext *fi = fffilterctx(f);
+
+        if (!fi->ready || (best && fi->ready <= best->ready))
+            continue;
+        if (!(f->thread_type & AVFILTER_THREAD_PIPELINE) && p->nb_busy)
+            continue;
+        if (!is_free(f) || (p->pending_claim && is_neighbour(f, p->pending_claim)))
+            continue;
+        best = fi;
+    }
+    return best;
+}
+
+static int any_ready(FFGraphPipeline *p)
+{
+    AVFilterGraph *graph = &p->graph->p;
+
+    for (unsigned i = 0; i < graph->nb_filters; i++)
+        if (fffilterctx(graph->filters[i])->ready)
+            return 1;
+    return 0;
+}
+
+static void *attribute_align_arg pipeline_worker(void *arg)
+{
+    FFGraphPipeline *p = arg;
+
+    ff_mutex_lock(&p->lock);
+    while (!p->stop) {
+        FFFilterContext *fi = pick_filter(p);
+        int exclusive, ret;
+
+        if (!fi) {
+            ff_cond_wait(&p->work_cond, &p->lock);
+            continue;
+        }
+
+        exclusive = !(fi->p.thread_type & AVFILTER_THREAD_PIPELINE);
+        fi->ready = 0;
+        fi->busy  = 1;
+        p->nb_busy++;
+        p->exclusive = exclusive;
+        ff_mutex_unlock(&p->lock);
+
+        ret = ff_filter_activate(&fi->p);
+
+        ff_mutex_lock(&p->lock);
+        fi->busy = 0;
+        p->nb_busy--;
+        if (exclusive)
+            p->exclusive = 0;
+        p->nb_activations++;
+        if (ret == FFERROR_BUFFERSRC_EMPTY)
+            p->buffersrc_empty = 1;
+        else if (ret < 0 && !p->error)
+            p->error = ret;
+        ff_cond_broadcast(&p->work_cond);
+        ff_cond_broadcast(&p->progress_cond);
+    }
+    ff_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+int ff_graph_pipeline_start(FFFilterGraph *graphi)
+{
+    AVFilterGraph *graph = &graphi->p;
+    FFGraphPipeline *p;
+    int nb_workers, ret;
+
+    if (!(graph->thread_type & AVFILTER_THREAD_PIPELINE) || graphi->pipeline)
+        return 0;
+
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        const AVFilterContext *f = graph->filters[i];
+        if (fffilter(f->filter)->flags_internal & FF_FILTER_FLAG_GRAPH_EXCLUSIVE) {
+            av_log(graph, AV_LOG_VERBOSE, "Not using pipeline threading with the "
+                   "%s filter\n", f->filter->name);
+            return 0;
+        }
+    }
+
+    nb_workers = graph->nb_threads > 0 ? graph->nb_threads : av_cpu_count();
+    nb_workers = FFMIN(nb_workers, graph->nb_filters);
+    if (nb_workers < 1)
+        return 0;
+
+    p = av_mallocz(sizeof(*p));
+    if (!p)
+        return AVERROR(ENOMEM);
+    p->graph   = graphi;
+    p->workers = av_calloc(nb_workers, sizeof(*p->workers));
+    if (!p->workers) {
+        av_free(p);
+        return AVERROR(ENOMEM);
+    }
+    if ((ret = ff_mutex_init(&p->lock, NULL))) {
+        av_free(p->workers);
+        av_free(p);
+        return AVERROR(ret);
+    }
+    ff_cond_init(&p->work_cond, NULL);
+    ff_cond_init(&p->progress_cond, NULL);
+
+    /* the activations started by the threads see the pipeline */
+    graphi->pipeline = p;
+    for (; p->nb_workers < nb_workers; p->nb_workers++) {
+        ret = pthread_create(&p->workers[p->nb_workers], NULL, pipeline_worker, p);
+        if (ret) {
+            ff_graph_pipeline_stop(graphi);
+            return AVERROR(ret);
+        }
+    }
+    av_log(graph, AV_LOG_VERBOSE, "Running the graph with %d pipeline threads\n",
+           nb_workers);
+    return 0;
+}
+
+void ff_graph_pipeline_stop(FFFilterGraph *graph)
+{
+    FFGraphPipeline *p = graph->pipeline;
+
+    if (!p)
+        return;
+
+    ff_mutex_lock(&p->lock);
+    p->stop = 1;
+    ff_cond_broadcast(&p->work_cond);
+    ff_mutex_unlock(&p->lock);
+    for (int i = 0; i < p->nb_workers; i++)
+        pthread_join(p->workers[i], NULL);
+
+    graph->pipeline = NULL;
+    ff_cond_destroy(&p->work_cond);
+    ff_cond_destroy(&p->progress_cond);
+    ff_mutex_destroy(&p->lock);
+    av_free(p->workers);
+    av_free(p);
+}
+
+void ff_graph_pipeline_lock(FFFilterGraph *graph)
+{
+    ff_mutex_lock(&graph->pipeline->lock);
+}
+
+void ff_graph_pipeline_unlock(FFFilterGraph *graph)
+{
+    ff_mutex_unlock(&graph->pipeline->lock);
+}
+
+static void claim_locked(FFGraphPipeline *p, AVFilterContext *filter)
+{
+    if (p->claimed) {
+        av_assert0(!p->claimed_filter || p->claimed_filter == filter);
+        p->claimed++;
+        return;
+    }
+
+    if (filter) {
+        p->pending_claim = filter;
+        while (p->exclusive || !is_free(filter))
+            ff_cond_wait(&p->progress_cond, &p->lock);
+        p->pending_claim = NULL;
+        fffilterctx(filter)->busy = 1;
+    } else {
+        p->pending_graph_claim = 1;
+        while (p->nb_busy)
+            ff_cond_wait(&p->progress_cond, &p->lock);
+        p->pending_graph_claim = 0;
+        p->exclusive = 1;
+    }
+    p->nb_busy++;
+    p->claimed        = 1;
+    p->claimed_filter = filter;
+}
+
+static void release_locked(FFGraphPipeline *p)
+{
+    if (!p->claimed || --p->claimed)
+        return;
+    if (p->claimed_filter)
+        fffilterctx(p->claimed_filter)->busy = 0;
+    else
+        p->exclusive = 0;
+    p->nb_busy--;
+    p->claimed = 0;
+    ff_cond_broadcast(&p->work_cond);
+}
+
+void ff_graph_pipeline_claim(FFFilterGraph *graph, AVFilterContext *filter)
+{
+    FFGraphPipeline *p = graph->pipeline;
+
+    if (!p)
+        return;
+    ff_mutex_lock(&p->lock);
+    claim_locked(p, filter);
+    ff_mutex_unlock(&p->lock);
+}
+
+void ff_graph_pipeline_release(FFFilterGraph *graph)
+{
+    FFGraphPipeline *p = graph->pipeline;
+
+    if (!p)
+        return;
+    ff_mutex_lock(&p->lock);
+    release_locked(p);
+    ff_mutex_unlock(&p->lock);
+}
+
+void ff_graph_pipeline_set_ready(FFFilterGraph *graph, FFFilterContext *ctxi,
+                                 unsigned priority)
+{
+    FFGraphPipeline *p = graph->pipeline;
+
+    ff_mutex_lock(&p->lock);
+    if (priority > ctxi->ready) {
+        ctxi->ready = priority;
+        if (!ctxi->busy)
+            ff_cond_signal(&p->work_cond);
+    }
+    ff_mutex_unlock(&p->lock);
+}
+
+int ff_graph_pipeline_run_once(FFFilterGraph *graph)
+{
+    FFGraphPipeline *p = graph->pipeline;
+    AVFilterContext *claimed_filter;
+    int claimed, ret;
+    uint64_t nb_activations;
+
+    ff_mutex_lock(&p->lock);
+    claimed        = p->claimed;
+    claimed_filter = p->claimed_filter;
+    if (claimed) {
+        p->claimed = 1;
+        release_locked(p);
+    }
+
+    nb_activations = p->nb_activations;
+    while (1) {
+        if (p->error) {
+            ret = p->error;
+            p->error = 0;
+            break;
+        }
+        if (p->buffersrc_empty) {
+            p->buffersrc_empty = 0;
+            ret = FFERROR_BUFFERSRC_EMPTY;
+            break;
+        }
+        if (p->nb_activations != nb_activations) {
+            ret = 0;
+            break;
+        }
+        if (!p->nb_busy && !any_ready(p)) {
+            ret = AVERROR(EAGAIN);
+            break;
+        }
+        ff_cond_wait(&p->progress_cond, &p->lock);
+    }
+
+    if (claimed) {
+        claim_locked(p, claimed_filter);
+        p->claimed = claimed;
+    }
+    ff_mutex_unlock(&p->lock);
+    return ret;
+}
@@ -79,15 +79,28 @@ static int activate(AVFilterContext *ctx)
     if (ret < 0)
         return ret;
     if (ret > 0) {
+        int last = 0;
+
+        for (int i = 0; i < ctx->nb_outputs; i++)
+            if (!ff_outlink_get_status(ctx->outputs[i]))
+                last = i;
+
         for (int i = 0; i < ctx->nb_outputs; i++) {
             AVFrame *buf_out;
 
             if (ff_outlink_get_status(ctx->outputs[i]))
                 continue;
-            buf_out = av_frame_clone(in);
-            if (!buf_out) {
-                ret = AVERROR(ENOMEM);
-                break;
+
+            // hand over the input reference itself, saving one clone
+            if (i == last) {
+                buf_out = in;
+                in      = NULL;
+            } else {
+                buf_out = av_frame_clone(in);
+                if (!buf_out) {
+                    ret = AVERROR(ENOMEM);
+                    break;
+                }
             }
 
             ret = ff_filter_frame(ctx->outputs[i], buf_out);
@@ -182,6 +182,7 @@ typedef struct GlyphInfo {
     int y;                          ///< the y position of the glyph
     int shift_x64;                  ///< the horizontal shift of the glyph in 26.6 units
     int shift_y64;                  ///< the vertical shift of the glyph in 26.6 units
+    struct Glyph *glyph;            ///< the rendered glyph, resolved before drawing
 } GlyphInfo;
 
 /** Information about a single line of text */
@@ -194,6 +195,10 @@ typedef struct TextLine {
     HarfbuzzData hb_data;           ///< libharfbuzz data of this text line
     GlyphInfo* glyphs;              ///< array of glyphs in this text line
     int cluster_offset;             ///< the offset at which this line begins
+    char *text;                     ///< the text the line was shaped from
+    int text_len;                   ///< length of text in bytes
+    int min_x64, max_x64;           ///< horizontal extent of the glyph bboxes
+    int min_y64, max_y64;           ///< vertical extent of the glyph bboxes
 } TextLine;
 
 /** A glyph as loaded and rendered using libfreetype */
@@ -315,8 +320,22 @@ typedef struct DrawTextContext {
     int tab_count;                  ///< the number of tab characters
     int blank_advance64;            ///< the size of the space character
     int tab_warning_printed;        ///< ensure the tab warning to be printed only once
+
+    char *layout_text;              ///< text the cached lines were shaped for
+    unsigned int layout_fontsize;   ///< font size the cached lines were shaped for
+    TextMetrics layout_metrics;     ///< metrics of the cached lines
 } DrawTextContext;
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    TextMetrics *metrics;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+    int top, bottom;                ///< rows covered by the box and the glyphs
+} ThreadData;
+
 #define OFFSET(x) offsetof(DrawTextContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 #define TFLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_RUNTIME_PARAM
@@ -1114,6 +1133,35 @@ static int glyph_enu_free(void *opaque, void *elem)
     return 0;
 }
 
+static void hb_destroy(HarfbuzzData *hb)
+{
+    hb_font_destroy(hb->font);
+    hb_buffer_destroy(hb->buf);
+    hb->buf = NULL;
+    hb->font = NULL;
+    hb->glyph_info = NULL;
+    hb->glyph_pos = NULL;
+}
+
+static void free_lines(TextLine **lines, int line_count)
+{
+    for (int l = 0; l < line_count; ++l) {
+        TextLine *line = &(*lines)[l];
+        av_freep(&line->glyphs);
+        av_freep(&line->text);
+        hb_destroy(&line->hb_data);
+    }
+    av_freep(lines);
+}
+
+static void free_layout(DrawTextContext *s)
+{
+    free_lines(&s->lines, s->line_count);
+    av_freep(&s->tab_clusters);
+    av_freep(&s->layout_text);
+    s->line_count = 0;
+}
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
@@ -1125,6 +1173,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     s->x_pexpr = s->y_pexpr = s->a_pexpr = s->fontsize_pexpr = NULL;
 
+    free_layout(s);
+
     av_tree_enumerate(s->glyphs, NULL, NULL, glyph_enu_free);
     av_tree_destroy(s->glyphs);
     s->glyphs = NULL;
@@ -1238,6 +1288,7 @@ static int command(AVFilterContext *ctx, const char *cmd, const char *arg, char
             old->fontsize_pexpr = NULL;
             old->blank_advance64 = 0;
         }
+        free_layout(old);
         return config_input(ctx->inputs[0]);
     }
 
@@ -1269,21 +1320,24 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_glyphs(AVFilterContext *ctx, AVFrame *frame,
-                       FFDrawColor *color,
-                       TextMetrics *metrics,
-                       int x, int y, int borderw)
+/**
+ * Draw the glyphs clipped to the rows [slice_start, slice_end).
+ */
+static void draw_glyphs(AVFilterContext *ctx, AVFrame *frame,
+                        FFDrawColor *color,
+                        TextMetrics *metrics,
+                        int x, int y, int borderw,
+                        int slice_start, int slice_end)
 {
     DrawTextContext *s = ctx->priv;
     int g, l, x1, y1, w1, h1, idx;
     int dx = 0, dy = 0, pdx = 0;
     GlyphInfo *info;
-    Glyph dummy = { 0 }, *glyph;
     FT_Bitmap bitmap;
     FT_BitmapGlyph b_glyph;
     uint8_t j_left = 0, j_right = 0, j_top = 0, j_bottom = 0;
     int line_w, offset_y = 0;
-    int clip_x = 0, clip_y = 0;
+    int clip_x = 0, clip_y = 0, top;
 
     j_left = !!(s->text_align & TA_LEFT);
     j_right = !!(s->text_align & TA_RIGHT);
@@ -1296,28 +1350,17 @@ static int draw_glyphs(AVFilterContext *ctx, AVFrame *frame,
         offset_y = s->box_height - metrics->height;
     }
 
-    if ((!j_left || j_right) && !s->tab_warning_printed && s->tab_count > 0) {
-        s->tab_warning_printed = 1;
-        av_log(ctx, AV_LOG_WARNING, "Tab characters are only supported with left horizontal alignment\n");
-    }
-
+    top    = FFMAX(metrics->rect_y - s->bb_top, slice_start);
     clip_x = FFMIN(metrics->rect_x + s->box_width + s->bb_right, frame->width);
-    clip_y = FFMIN(metrics->rect_y + s->box_height + s->bb_bottom, frame->height);
+    clip_y = FFMIN3(metrics->rect_y + s->box_height + s->bb_bottom, frame->height, slice_end);
 
     for (l = 0; l < s->line_count; ++l) {
         TextLine *line = &s->lines[l];
         line_w = POS_CEIL(line->width64, 64);
         for (g = 0; g < line->hb_data.glyph_count; ++g) {
             info = &line->glyphs[g];
-            dummy.fontsize = s->fontsize;
-            dummy.code = info->code;
-            glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
-            if (!glyph) {
-                return AVERROR(EINVAL);
-            }
-
             idx = get_subpixel_idx(info->shift_x64, info->shift_y64);
-            b_glyph = borderw ? glyph->border_bglyph[idx] : glyph->bglyph[idx];
+            b_glyph = borderw ? info->glyph->border_bglyph[idx] : info->glyph->bglyph[idx];
             bitmap = b_glyph->bitmap;
             x1 = x + info->x + b_glyph->left;
             y1 = y + info->y - b_glyph->top + offset_y;
@@ -1336,9 +1379,9 @@ static int draw_glyphs(AVFilterContext *ctx, AVFrame *frame,
                 dx = metrics->rect_x - s->bb_left - x1;
                 x1 = metrics->rect_x - s->bb_left;
             }
-            if (y1 < metrics->rect_y - s->bb_top) {
-                dy = metrics->rect_y - s->bb_top - y1;
-                y1 = metrics->rect_y - s->bb_top;
+            if (y1 < top) {
+                dy = top - y1;
+                y1 = top;
             }
 
             // check if the glyph is empty or out of the clipping region
@@ -1354,6 +1397,46 @@ static int draw_glyphs(AVFilterContext *ctx, AVFrame *frame,
                 bitmap.buffer + pdx, bitmap.pitch, w1, h1, 3, 0, x1, y1);
         }
     }
+}
+
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    TextMetrics *metrics = td->metrics;
+    AVFrame *frame = td->frame;
+    /* keep the chroma rows of a slice within the slice */
+    const int align = 1 << s->dc.vsub_max;
+    const int rows = td->bottom - td->top;
+    const int slice_start = td->top + ((rows * jobnr / nb_jobs) & ~(align - 1));
+    const int slice_end   = jobnr == nb_jobs - 1 ? td->bottom :
+                            td->top + ((rows * (jobnr + 1) / nb_jobs) & ~(align - 1));
+
+    if (slice_start >= slice_end)
+        return 0;
+
+    /* draw box */
+    if (s->draw_box) {
+        int rec_y0 = FFMAX(metrics->rect_y - s->bb_top, slice_start);
+        int rec_y1 = FFMIN(metrics->rect_y + s->box_height + s->bb_bottom, slice_end);
+
+        if (rec_y1 > rec_y0)
+            ff_blend_rectangle(&s->dc, &td->boxcolor,
+                frame->data, frame->linesize, frame->width, frame->height,
+                metrics->rect_x - s->bb_left, rec_y0,
+                s->box_width + s->bb_right + s->bb_left, rec_y1 - rec_y0);
+    }
+
+    if (s->shadowx || s->shadowy)
+        draw_glyphs(ctx, frame, &td->shadowcolor, metrics,
+                    s->shadowx, s->shadowy, s->borderw, slice_start, slice_end);
+
+    if (s->borderw)
+        draw_glyphs(ctx, frame, &td->bordercolor, metrics,
+                    0, 0, s->borderw, slice_start, slice_end);
+
+    draw_glyphs(ctx, frame, &td->fontcolor, metrics,
+                0, 0, 0, slice_start, slice_end);
 
     return 0;
 }
@@ -1381,14 +1464,82 @@ static int shape_text_hb(DrawTextContext *s, HarfbuzzData* hb, const char* text,
     return 0;
 }
 
-static void hb_destroy(HarfbuzzData *hb)
+/**
+ * Measure a shaped line of text.
+ *
+ * @param tab_idx index in s->tab_clusters of the first tab of the line
+ */
+static int measure_line(AVFilterContext *ctx, TextLine *line, int tab_idx)
 {
-    hb_font_destroy(hb->font);
-    hb_buffer_destroy(hb->buf);
-    hb->buf = NULL;
-    hb->font = NULL;
-    hb->glyph_info = NULL;
-    hb->glyph_pos = NULL;
+    DrawTextContext *s = ctx->priv;
+    HarfbuzzData *hb = &line->hb_data;
+    Glyph *glyph = NULL;
+    int w64 = 0;
+    int ret;
+
+    line->min_x64 = line->min_y64 = 32000;
+    line->max_x64 = line->max_y64 = -32000;
+
+    for (int t = 0; t < hb->glyph_count; ++t) {
+        uint8_t is_tab = tab_idx < s->tab_count &&
+            hb->glyph_info[t].cluster == s->tab_clusters[tab_idx] - line->cluster_offset;
+        if (is_tab) {
+            ++tab_idx;
+        }
+        ret = load_glyph(ctx, &glyph, hb->glyph_info[t].codepoint, -1, -1);
+        if (ret != 0) {
+            return ret;
+        }
+        if (t == 0) {
+            line->offset_left64 = glyph->bbox.xMin;
+        }
+        if (t == hb->glyph_count - 1) {
+            // The following code measures the width of the line up to the last
+            // character's horizontal advance
+            int last_char_width = hb->glyph_pos[t].x_advance;
+
+            // The following code measures the width of the line up to the rightmost
+            // visible pixel of the last character
+            // int last_char_width = glyph->bbox.xMax;
+
+            w64 += last_char_width;
+            line->offset_right64 = last_char_width;
+        } else {
+            if (is_tab) {
+                int size = s->blank_advance64 * s->tabsize;
+                w64 = (w64 / size + 1) * size;
+            } else {
+                w64 += hb->glyph_pos[t].x_advance;
+            }
+        }
+        line->min_y64 = FFMIN(glyph->bbox.yMin, line->min_y64);
+        line->max_y64 = FFMAX(glyph->bbox.yMax, line->max_y64);
+        line->min_x64 = FFMIN(glyph->bbox.xMin, line->min_x64);
+        line->max_x64 = FFMAX(glyph->bbox.xMax, line->max_x64);
+    }
+
+    line->width64 = w64;
+
+    return 0;
+}
+
+/**
+ * Take over the shaping of an unchanged line of the previous text.
+ */
+static int reuse_line(TextLine *old_lines, int old_line_count,
+                      TextLine *line, const char *text, int len)
+{
+    for (int l = 0; l < old_line_count; ++l) {
+        TextLine *old = &old_lines[l];
+        if (old->text && old->text_len == len && !memcmp(old->text, text, len)) {
+            int cluster_offset = line->cluster_offset;
+            *line = *old;
+            line->cluster_offset = cluster_offset;
+            memset(old, 0, sizeof(*old));
+            return 1;
+        }
+    }
+    return 0;
 }
 
 static int measure_text(AVFilterContext *ctx, TextMetrics *metrics)
@@ -1396,18 +1547,34 @@ static int measure_text(AVFilterContext *ctx, TextMetrics *metrics)
     DrawTextContext *s = ctx->priv;
     char *text = s->expanded_text.str;
     char *textdup = NULL;
-    int width64 = 0, w64 = 0;
+    int width64 = 0;
     int cur_min_y64 = 0, first_max_y64 = -32000;
     int first_min_x64 = 32000, last_max_x64 = -32000;
     int min_y64 = 32000, max_y64 = -32000, min_x64 = 32000, max_x64 = -32000;
     int line_count = 0;
     uint32_t code = 0;
-    Glyph *glyph = NULL;
+    TextLine *old_lines = NULL;
+    int old_line_count = 0;
 
-    int i, tab_idx = 0, last_tab_idx = 0, line_offset = 0;
+    int i, tab_idx = 0, line_tab_idx = 0, line_offset = 0;
     uint8_t *start, *p;
     int ret = 0;
 
+    // Reuse the shaped lines if neither the text nor the font size changed
+    if (s->layout_text && s->layout_fontsize == s->fontsize &&
+        !strcmp(text, s->layout_text)) {
+        *metrics = s->layout_metrics;
+        return 0;
+    }
+    // Otherwise keep the lines to reshape only those which changed
+    if (s->layout_fontsize == s->fontsize) {
+        old_lines      = s->lines;
+        old_line_count = s->line_count;
+        s->lines       = NULL;
+        s->line_count  = 0;
+    }
+    free_layout(s);
+
     // Count the lines and the tab characters
     s->tab_count = 0;
     for (i = 0, p = text; 1; i++) {
@@ -1434,9 +1601,13 @@ continue_on_failed:
         hb_destroy(&hb_data);
     }
 
-    s->line_count = line_count;
     s->lines = av_mallocz(line_count * sizeof(TextLine));
     s->tab_clusters = av_mallocz(s->tab_count * sizeof(uint32_t));
+    if (!s->lines || !s->tab_clusters) {
+        ret = AVERROR(ENOMEM);
+        goto done;
+    }
+    s->line_count = line_count;
     for (i = 0; i < s->tab_count; ++i) {
         s->tab_clusters[i] = -1;
     }
@@ -1457,68 +1628,49 @@ continue_on_failed2:
         if (ff_is_newline(code) || code == 0) {
             TextLine *cur_line = &s->lines[line_count];
             HarfbuzzData *hb = &cur_line->hb_data;
+            // the line as in the text, with its tabs
+            const char *line_text = text + (start - (uint8_t *)textdup);
             cur_line->cluster_offset = line_offset;
-            ret = shape_text_hb(s, hb, start, p - start);
-            if (ret != 0) {
-                goto done;
-            }
-            w64 = 0;
-            cur_min_y64 = 32000;
-            for (int t = 0; t < hb->glyph_count; ++t) {
-                uint8_t is_tab = last_tab_idx < s->tab_count &&
-                    hb->glyph_info[t].cluster == s->tab_clusters[last_tab_idx] - line_offset;
-                if (is_tab) {
-                    ++last_tab_idx;
+            if (!reuse_line(old_lines, old_line_count, cur_line, line_text, p - start)) {
+                cur_line->text = av_memdup(line_text, p - start);
+                if (!cur_line->text) {
+                    ret = AVERROR(ENOMEM);
+                    goto done;
                 }
-                ret = load_glyph(ctx, &glyph, hb->glyph_info[t].codepoint, -1, -1);
+                cur_line->text_len = p - start;
+                ret = shape_text_hb(s, hb, start, p - start);
                 if (ret != 0) {
                     goto done;
                 }
-                if (line_count == 0) {
-                    first_max_y64 = FFMAX(glyph->bbox.yMax, first_max_y64);
-                }
-                if (t == 0) {
-                    cur_line->offset_left64 = glyph->bbox.xMin;
-                    first_min_x64 = FFMIN(glyph->bbox.xMin, first_min_x64);
-                }
-                if (t == hb->glyph_count - 1) {
-                    // The following code measures the width of the line up to the last
-                    // character's horizontal advance
-                    int last_char_width = hb->glyph_pos[t].x_advance;
-
-                    // The following code measures the width of the line up to the rightmost
-                    // visible pixel of the last character
-                    // int last_char_width = glyph->bbox.xMax;
-
-                    w64 += last_char_width;
-                    last_max_x64 = FFMAX(last_char_width, last_max_x64);
-                    cur_line->offset_right64 = last_char_width;
-                } else {
-                    if (is_tab) {
-                        int size = s->blank_advance64 * s->tabsize;
-                        w64 = (w64 / size + 1) * size;
-                    } else {
-                        w64 += hb->glyph_pos[t].x_advance;
-                    }
+                ret = measure_line(ctx, cur_line, line_tab_idx);
+                if (ret != 0) {
+                    goto done;
                 }
-                cur_min_y64 = FFMIN(glyph->bbox.yMin, cur_min_y64);
-                min_y64 = FFMIN(glyph->bbox.yMin, min_y64);
-                max_y64 = FFMAX(glyph->bbox.yMax, max_y64);
-                min_x64 = FFMIN(glyph->bbox.xMin, min_x64);
-                max_x64 = FFMAX(glyph->bbox.xMax, max_x64);
             }
 
-            cur_line->width64 = w64;
+            if (line_count == 0) {
+                first_max_y64 = cur_line->max_y64;
+            }
+            if (hb->glyph_count) {
+                first_min_x64 = FFMIN(cur_line->offset_left64, first_min_x64);
+                last_max_x64 = FFMAX(cur_line->offset_right64, last_max_x64);
+            }
+            cur_min_y64 = cur_line->min_y64;
+            min_y64 = FFMIN(cur_line->min_y64, min_y64);
+            max_y64 = FFMAX(cur_line->max_y64, max_y64);
+            min_x64 = FFMIN(cur_line->min_x64, min_x64);
+            max_x64 = FFMAX(cur_line->max_x64, max_x64);
 
             av_log(ctx, AV_LOG_DEBUG, "  Line: %d -- glyphs count: %d - width64: %d - offset_left64: %d - offset_right64: %d)\n",
                 line_count, hb->glyph_count, cur_line->width64, cur_line->offset_left64, cur_line->offset_right64);
 
-            if (w64 > width64) {
-                width64 = w64;
+            if (cur_line->width64 > width64) {
+                width64 = cur_line->width64;
             }
             start = p;
             ++line_count;
             line_offset = i + 1;
+            line_tab_idx = tab_idx;
         }
 
         if (code == 0) break;
@@ -1543,8 +1695,19 @@ continue_on_failed2:
     metrics->max_x64 = max_x64;
     metrics->max_y64 = max_y64;
 
+    s->layout_text = av_strdup(text);
+    if (!s->layout_text) {
+        ret = AVERROR(ENOMEM);
+        goto done;
+    }
+    s->layout_fontsize = s->fontsize;
+    s->layout_metrics  = *metrics;
+
 done:
     av_free(textdup);
+    free_lines(&old_lines, old_line_count);
+    if (ret < 0)
+        free_layout(s);
     return ret;
 }
 
@@ -1569,7 +1732,6 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
 
     int width = frame->width;
     int height = frame->height;
-    int rec_x = 0, rec_y = 0, rec_width = 0, rec_height = 0;
     int is_outside = 0;
     int last_tab_idx = 0;
 
@@ -1718,7 +1880,11 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
     for (int l = 0; l < s->line_count; ++l) {
         TextLine *line = &s->lines[l];
         HarfbuzzData *hb = &line->hb_data;
-        line->glyphs = av_mallocz(hb->glyph_count * sizeof(GlyphInfo));
+        if (!line->glyphs) {
+            line->glyphs = av_mallocz(hb->glyph_count * sizeof(GlyphInfo));
+            if (!line->glyphs)
+                return AVERROR(ENOMEM);
+        }
 
         for (int t = 0; t < hb->glyph_count; ++t) {
             GlyphInfo *g_info = &line->glyphs[t];
@@ -1737,6 +1903,7 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
             if (ret != 0) {
                 return ret;
             }
+            g_info->glyph = glyph;
             g_info->code = hb->glyph_info[t].codepoint;
             g_info->x = (x64 + true_x) >> 6;
             g_info->y = ((y64 + true_y) >> 6) + (shift_y64 > 0 ? 1 : 0);
@@ -1783,46 +1950,31 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
                     metrics.rect_y + s->box_height + s->bb_bottom <= 0;
 
     if (!is_outside) {
-        /* draw box */
-        if (s->draw_box) {
-            rec_x = metrics.rect_x - s->bb_left;
-            rec_y = metrics.rect_y - s->bb_top;
-            rec_width = s->box_width + s->bb_right + s->bb_left;
-            rec_height = s->box_height + s->bb_bottom + s->bb_top;
-            ff_blend_rectangle(&s->dc, &boxcolor,
-                frame->data, frame->linesize, width, height,
-                rec_x, rec_y, rec_width, rec_height);
-        }
-
-        if (s->shadowx || s->shadowy) {
-            if ((ret = draw_glyphs(ctx, frame, &shadowcolor, &metrics,
-                    s->shadowx, s->shadowy, s->borderw)) < 0) {
-                return ret;
-            }
-        }
-
-        if (s->borderw) {
-            if ((ret = draw_glyphs(ctx, frame, &bordercolor, &metrics,
-                    0, 0, s->borderw)) < 0) {
-                return ret;
+        const int align = 1 << s->dc.vsub_max;
+        ThreadData td = {
+            .frame       = frame,
+            .metrics     = &metrics,
+            .fontcolor   = fontcolor,
+            .shadowcolor = shadowcolor,
+            .bordercolor = bordercolor,
+            .boxcolor    = boxcolor,
+            .top         = FFMAX(metrics.rect_y - s->bb_top, 0) & ~(align - 1),
+            .bottom      = FFMIN(metrics.rect_y + s->box_height + s->bb_bottom, height),
+        };
+        int nb_jobs = FFMIN(ff_filter_get_nb_threads(ctx),
+                            (td.bottom - td.top + align - 1) / align);
+
+        if (!(s->text_align & TA_LEFT) || (s->text_align & TA_RIGHT)) {
+            if (!s->tab_warning_printed && s->tab_count > 0) {
+                s->tab_warning_printed = 1;
+                av_log(ctx, AV_LOG_WARNING, "Tab characters are only supported with left horizontal alignment\n");
             }
         }
 
-        if ((ret = draw_glyphs(ctx, frame, &fontcolor, &metrics, 0,
-                0, 0)) < 0) {
-            return ret;
-        }
+        if (nb_jobs > 0)
+            ff_filter_execute(ctx, draw_text_slice, &td, NULL, nb_jobs);
     }
 
-    // FREE data structures
-    for (int l = 0; l < s->line_count; ++l) {
-        TextLine *line = &s->lines[l];
-        av_freep(&line->glyphs);
-        hb_destroy(&line->hb_data);
-    }
-    av_freep(&s->lines);
-    av_freep(&s->tab_clusters);
-
     return 0;
 }
 
@@ -1903,7 +2055,8 @@ const FFFilter ff_vf_drawtext = {
     .p.name        = "drawtext",
     .p.description = NULL_IF_CONFIG_SMALL("Draw text on top of video frames using libfreetype library."),
     .p.priv_class  = &drawtext_class,
-    .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                     AVFILTER_FLAG_SLICE_THREADS,
     .priv_size     = sizeof(DrawTextContext),
     .init          = init,
     .uninit        = uninit,
@@ -0,0 +1,332 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * scale one input to several output sizes, e.g. for adaptive streaming ladders
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+
+#include "avfilter.h"
+#include "filters.h"
+#include "formats.h"
+#include "video.h"
+
+typedef struct MultiScaleOutput {
+    int w, h;
+    SwsContext *sws;
+} MultiScaleOutput;
+
+typedef struct MultiScaleContext {
+    const AVClass *class;
+
+    char *sizes_str;
+    char *flags_str;
+    int   cascade;
+    int   threads;
+
+    MultiScaleOutput *outputs;
+    int            nb_outputs;
+
+    /* output indices, sorted by decreasing area */
+    int *order;
+    /* temporary storage for the frames being produced */
+    AVFrame **frames;
+} MultiScaleContext;
+
+static int parse_sizes(AVFilterContext *ctx)
+{
+    MultiScaleContext *s = ctx->priv;
+    char *sizes = av_strdup(s->sizes_str), *saveptr = NULL, *p;
+    int ret = 0;
+
+    if (!sizes)
+        return AVERROR(ENOMEM);
+
+    for (p = sizes; (p = av_strtok(p, "|", &saveptr)); p = NULL) {
+        MultiScaleOutput *o;
+        int w, h;
+
+        ret = av_parse_video_size(&w, &h, p);
+        if (ret < 0) {
+            av_log(ctx, AV_LOG_ERROR, "Invalid output size '%s'\n", p);
+            goto end;
+        }
+
+        o = av_dynarray2_add((void **)&s->outputs, &s->nb_outputs,
+                             sizeof(*s->outputs), NULL);
+        if (!o) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        *o = (MultiScaleOutput){ .w = w, .h = h };
+    }
+
+    if (!s->nb_outputs) {
+        av_log(ctx, AV_LOG_ERROR, "No output sizes specified\n");
+        ret = AVERROR(EINVAL);
+    }
+
+end:
+    av_free(sizes);
+    return ret;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    MultiScaleContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    const MultiScaleOutput *o = &s->outputs[FF_OUTLINK_IDX(outlink)];
+
+    outlink->w = o->w;
+    outlink->h = o->h;
+
+    if (inlink->sample_aspect_ratio.num)
+        outlink->sample_aspect_ratio = av_mul_q((AVRational){ outlink->h * inlink->w,
+                                                              outlink->w * inlink->h },
+                                                inlink->sample_aspect_ratio);
+    else
+        outlink->sample_aspect_ratio = inlink->sample_aspect_ratio;
+
+    return 0;
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    MultiScaleContext *s = ctx->priv;
+    int ret;
+
+    ret = parse_sizes(ctx);
+    if (ret < 0)
+        return ret;
+
+    s->order  = av_calloc(s->nb_outputs, sizeof(*s->order));
+    s->frames = av_calloc(s->nb_outputs, sizeof(*s->frames));
+    if (!s->order || !s->frames)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < s->nb_outputs; i++) {
+        MultiScaleOutput *o = &s->outputs[i];
+        AVFilterPad pad = { 0 };
+
+        /* insertion sort by decreasing area */
+        int j = i;
+        for (; j > 0; j--) {
+            const MultiScaleOutput *prev = &s->outputs[s->order[j - 1]];
+            if ((int64_t)prev->w * prev->h >= (int64_t)o->w * o->h)
+                break;
+            s->order[j] = s->order[j - 1];
+        }
+        s->order[j] = i;
+
+        o->sws = sws_alloc_context();
+        if (!o->sws)
+            return AVERROR(ENOMEM);
+
+        if (s->flags_str && *s->flags_str) {
+            ret = av_opt_set(o->sws, "sws_flags", s->flags_str, 0);
+            if (ret < 0)
+                return ret;
+        }
+        o->sws->threads = s->threads ? s->threads : ff_filter_get_nb_threads(ctx);
+
+        pad.type         = AVMEDIA_TYPE_VIDEO;
+        pad.config_props = config_output;
+        pad.name         = av_asprintf("output%d", i);
+        if (!pad.name)
+            return AVERROR(ENOMEM);
+
+        if ((ret = ff_append_outpad_free_name(ctx, &pad)) < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    MultiScaleContext *s = ctx->priv;
+
+    for (int i = 0; i < s->nb_outputs; i++)
+        sws_free_context(&s->outputs[i].sws);
+    if (s->frames)
+        for (int i = 0; i < s->nb_outputs; i++)
+            av_frame_free(&s->frames[i]);
+
+    av_freep(&s->outputs);
+    s->nb_outputs = 0;
+    av_freep(&s->order);
+    av_freep(&s->frames);
+}
+
+static int query_formats(const AVFilterContext *ctx,
+                         AVFilterFormatsConfig **cfg_in,
+                         AVFilterFormatsConfig **cfg_out)
+{
+    AVFilterFormats *formats = NULL;
+    const AVPixFmtDescriptor *desc = NULL;
+    int ret;
+
+    /* all outputs share the input format, so that any format conversion is
+     * done only once before this filter */
+    while ((desc = av_pix_fmt_desc_next(desc))) {
+        enum AVPixelFormat pix_fmt = av_pix_fmt_desc_get_id(desc);
+        if (sws_test_format(pix_fmt, 0) && sws_test_format(pix_fmt, 1)) {
+            if ((ret = ff_add_format(&formats, pix_fmt)) < 0)
+                return ret;
+        }
+    }
+
+    return ff_set_common_formats2(ctx, cfg_in, cfg_out, formats);
+}
+
+static int scale_frame(AVFilterContext *ctx, AVFrame *in)
+{
+    MultiScaleContext *s = ctx->priv;
+    int ret = 0;
+
+    /* Produce the outputs from the largest to the smallest one. In cascade
+     * mode, the default, each output is scaled from the smallest already
+     * produced frame that is at least as large and has the same shape,
+     * instead of from the full-size input. */
+    for (int i = 0; i < s->nb_outputs; i++) {
+        int idx = s->order[i];
+        AVFilterLink *outlink = ctx->outputs[idx];
+        const AVFrame *src = in;
+        AVFrame *out;
+
+        if (ff_outlink_get_status(outlink))
+            continue;
+
+        for (int j = i - 1; s->cascade && j >= 0; j--) {
+            const AVFrame *prev = s->frames[s->order[j]];
+            if (prev && prev->width >= outlink->w && prev->height >= outlink->h &&
+                (int64_t)prev->width * outlink->h == (int64_t)prev->height * outlink->w) {
+                src = prev;
+                break;
+            }
+        }
+
+        out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!out) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        s->frames[idx] = out;
+
+        ret = av_frame_copy_props(out, in);
+        if (ret < 0)
+            goto fail;
+
+        ret = sws_scale_frame(s->outputs[idx].sws, out, src);
+        if (ret < 0)
+            goto fail;
+
+        out->sample_aspect_ratio = outlink->sample_aspect_ratio;
+    }
+
+    for (int i = 0; i < s->nb_outputs; i++) {
+        AVFrame *out = s->frames[i];
+        if (!out)
+            continue;
+        s->frames[i] = NULL;
+        ret = ff_filter_frame(ctx->outputs[i], out);
+        if (ret < 0)
+            goto fail;
+    }
+
+fail:
+    for (int i = 0; i < s->nb_outputs; i++)
+        av_frame_free(&s->frames[i]);
+    av_frame_free(&in);
+    return ret;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    AVFrame *in;
+    int status, ret, nb_eofs = 0;
+    int64_t pts;
+
+    for (int i = 0; i < ctx->nb_outputs; i++)
+        nb_eofs += ff_outlink_get_status(ctx->outputs[i]) == AVERROR_EOF;
+
+    if (nb_eofs == ctx->nb_outputs) {
+        ff_inlink_set_status(inlink, AVERROR_EOF);
+        return 0;
+    }
+
+    ret = ff_inlink_consume_frame(inlink, &in);
+    if (ret < 0)
+        return ret;
+    if (ret > 0)
+        return scale_frame(ctx, in);
+
+    if (ff_inlink_acknowledge_status(inlink, &status, &pts)) {
+        for (int i = 0; i < ctx->nb_outputs; i++) {
+            if (ff_outlink_get_status(ctx->outputs[i]))
+                continue;
+            ff_outlink_set_status(ctx->outputs[i], status, pts);
+        }
+        return 0;
+    }
+
+    FF_FILTER_FORWARD_WANTED_ANY(ctx, inlink);
+
+    return FFERROR_NOT_READY;
+}
+
+#define OFFSET(x) offsetof(MultiScaleContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_FILTERING_PARAM
+static const AVOption multiscale_options[] = {
+    { "sizes",   "set '|'-separated list of output sizes", OFFSET(sizes_str), AV_OPT_TYPE_STRING, { .str = NULL }, .flags = FLAGS },
+    { "flags",   "set libswscale flags",                   OFFSET(flags_str), AV_OPT_TYPE_STRING, { .str = "" },   .flags = FLAGS },
+    { "cascade", "scale each output from the next larger one", OFFSET(cascade), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, FLAGS },
+    { "threads", "set number of scaling threads per output", OFFSET(threads), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(multiscale);
+
+static const AVFilterPad multiscale_inputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+};
+
+const FFFilter ff_vf_multiscale = {
+    .p.name        = "multiscale",
+    .p.description = NULL_IF_CONFIG_SMALL("Scale the input video to several output sizes."),
+    .p.priv_class  = &multiscale_class,
+    .p.flags       = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+    .priv_size     = sizeof(MultiScaleContext),
+    .init          = init,
+    .uninit        = uninit,
+    .activate      = activate,
+    FILTER_INPUTS(multiscale_inputs),
+    FILTER_QUERY_FUNC2(query_formats),
+};
@@ -64,8 +64,18 @@ typedef struct AssContext {
     int shaping;
     FFDrawContext draw;
     int wrap_unicode;
+
+    FFDrawColor *colors;       ///< colors of the images of the last rendered frame
+    unsigned int colors_size;
+    int nb_images;             ///< number of images of the last rendered frame, -1 if unknown
+    int top, bottom;           ///< rows covered by the images of the last rendered frame
 } AssContext;
 
+typedef struct ThreadData {
+    AVFrame *picref;
+    const ASS_Image *image;
+} ThreadData;
+
 #define OFFSET(x) offsetof(AssContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 
@@ -170,6 +180,7 @@ static av_cold void uninit(AVFilterContext *ctx)
         ass_renderer_done(ass->renderer);
     if (ass->library)
         ass_library_done(ass->library);
+    av_freep(&ass->colors);
 }
 
 static int query_formats(const AVFilterContext *ctx,
@@ -206,6 +217,8 @@ static int config_input(AVFilterLink *inlink)
     if (ass->shaping != -1)
         ass_set_shaper(ass->renderer, ass->shaping);
 
+    ass->nb_images = -1;
+
     return 0;
 }
 
@@ -215,19 +228,72 @@ static int config_input(AVFilterLink *inlink)
 #define AB(c)  (((c)>>8) &0xFF)
 #define AA(c)  ((0xFF-(c)) &0xFF)
 
-static void overlay_ass_image(AssContext *ass, AVFrame *picref,
-                              const ASS_Image *image)
+/**
+ * Convert the colors of the images and compute the rows they cover.
+ */
+static int update_images(AssContext *ass, const ASS_Image *image, int w, int h)
 {
-    for (; image; image = image->next) {
+    const int align = 1 << ass->draw.vsub_max;
+    int nb_images = 0;
+
+    for (const ASS_Image *img = image; img; img = img->next)
+        nb_images++;
+
+    av_fast_malloc(&ass->colors, &ass->colors_size, nb_images * sizeof(*ass->colors));
+    if (nb_images && !ass->colors)
+        return AVERROR(ENOMEM);
+
+    ass->top    = h;
+    ass->bottom = 0;
+    for (int i = 0; image; image = image->next, i++) {
         uint8_t rgba_color[] = {AR(image->color), AG(image->color), AB(image->color), AA(image->color)};
-        FFDrawColor color;
-        ff_draw_color(&ass->draw, &color, rgba_color);
-        ff_blend_mask(&ass->draw, &color,
+        ff_draw_color(&ass->draw, &ass->colors[i], rgba_color);
+        if (image->w > 0 && image->h > 0 && image->dst_x < w && image->dst_x + image->w > 0) {
+            ass->top    = FFMIN(ass->top,    image->dst_y);
+            ass->bottom = FFMAX(ass->bottom, image->dst_y + image->h);
+        }
+    }
+    /* keep the chroma rows of a slice within the slice */
+    ass->top    = FFMAX(ass->top, 0) & ~(align - 1);
+    ass->bottom = FFMIN(ass->bottom, h);
+    ass->nb_images = nb_images;
+
+    return 0;
+}
+
+static int overlay_ass_image_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AssContext *ass = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *picref = td->picref;
+    const int align = 1 << ass->draw.vsub_max;
+    const int rows = ass->bottom - ass->top;
+    const int slice_start = ass->top + ((rows * jobnr / nb_jobs) & ~(align - 1));
+    const int slice_end   = jobnr == nb_jobs - 1 ? ass->bottom :
+                            ass->top + ((rows * (jobnr + 1) / nb_jobs) & ~(align - 1));
+    const ASS_Image *image = td->image;
+
+    for (int i = 0; image; image = image->next, i++) {
+        const uint8_t *bitmap = image->bitmap;
+        int y = image->dst_y, h = image->h;
+
+        if (y < slice_start) {
+            bitmap += (ptrdiff_t)(slice_start - y) * image->stride;
+            h      -= slice_start - y;
+            y       = slice_start;
+        }
+        h = FFMIN(h, slice_end - y);
+        if (h <= 0)
+            continue;
+
+        ff_blend_mask(&ass->draw, &ass->colors[i],
                       picref->data, picref->linesize,
-                      picref->width, picref->height,
-                      image->bitmap, image->stride, image->w, image->h,
-                      3, 0, image->dst_x, image->dst_y);
+                      picref->width, slice_end,
+                      bitmap, image->stride, image->w, h,
+                      3, 0, image->dst_x, y);
     }
+
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
@@ -239,11 +305,27 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
     double time_ms = picref->pts * av_q2d(inlink->time_base) * 1000;
     ASS_Image *image = ass_render_frame(ass->renderer, ass->track,
                                         time_ms, &detect_change);
+    const int align = 1 << ass->draw.vsub_max;
+    int nb_jobs, ret;
 
     if (detect_change)
         av_log(ctx, AV_LOG_DEBUG, "Change happened at time ms:%f\n", time_ms);
 
-    overlay_ass_image(ass, picref, image);
+    /* the images are unchanged, so are their colors and position */
+    if (detect_change || ass->nb_images < 0) {
+        ret = update_images(ass, image, picref->width, picref->height);
+        if (ret < 0) {
+            av_frame_free(&picref);
+            return ret;
+        }
+    }
+
+    nb_jobs = FFMIN(ff_filter_get_nb_threads(ctx),
+                    (ass->bottom - ass->top + align - 1) / align);
+    if (nb_jobs > 0) {
+        ThreadData td = { .picref = picref, .image = image };
+        ff_filter_execute(ctx, overlay_ass_image_slice, &td, NULL, nb_jobs);
+    }
 
     return ff_filter_frame(outlink, picref);
 }
@@ -296,6 +378,7 @@ const FFFilter ff_vf_ass = {
     .p.name        = "ass",
     .p.description = NULL_IF_CONFIG_SMALL("Render ASS subtitles onto input video using the libass library."),
     .p.priv_class  = &ass_class,
+    .p.flags       = AVFILTER_FLAG_SLICE_THREADS,
     .priv_size     = sizeof(AssContext),
     .init          = init_ass,
     .uninit        = uninit,
@@ -551,6 +634,7 @@ const FFFilter ff_vf_subtitles = {
     .p.name        = "subtitles",
     .p.description = NULL_IF_CONFIG_SMALL("Render text subtitles onto input video using the libass library."),
     .p.priv_class  = &subtitles_class,
+    .p.flags       = AVFILTER_FLAG_SLICE_THREADS,
     .priv_size     = sizeof(AssContext),
     .init          = init_subtitles,
     .uninit        = uninit,
@@ -46,30 +46,14 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h)
     return ff_get_video_buffer(link->dst->outputs[0], w, h);
 }
 
-AVFrame *ff_default_get_video_buffer2(AVFilterLink *link, int w, int h, int align)
+static AVFrame *pool_get_video(FilterLinkInternal *li, int w, int h, int align)
 {
-    FilterLinkInternal *const li = ff_link_internal(link);
-    AVFrame *frame = NULL;
+    AVFilterLink *const link = &li->l.pub;
     int pool_width = 0;
     int pool_height = 0;
     int pool_align = 0;
     enum AVPixelFormat pool_format = AV_PIX_FMT_NONE;
 
-    if (li->l.hw_frames_ctx &&
-        ((AVHWFramesContext*)li->l.hw_frames_ctx->data)->format == link->format) {
-        int ret;
-        frame = av_frame_alloc();
-
-        if (!frame)
-            return NULL;
-
-        ret = av_hwframe_get_buffer(li->l.hw_frames_ctx, frame, 0);
-        if (ret < 0)
-            av_frame_free(&frame);
-
-        return frame;
-    }
-
     if (!li->frame_pool) {
         li->frame_pool = ff_frame_pool_video_init(CONFIG_MEMORY_POISONING
                                                      ? NULL
@@ -98,7 +82,38 @@ AVFrame *ff_default_get_video_buffer2(AVFilterLink *link, int w, int h, int alig
         }
     }
 
-    frame = ff_frame_pool_get(li->frame_pool);
+    return ff_frame_pool_get(li->frame_pool);
+}
+
+AVFrame *ff_default_get_video_buffer2(AVFilterLink *link, int w, int h, int align)
+{
+    FilterLinkInternal *const li = ff_link_internal(link);
+    AVFrame *frame = NULL;
+
+    if (li->l.hw_frames_ctx &&
+        ((AVHWFramesContext*)li->l.hw_frames_ctx->data)->format == link->format) {
+        int ret;
+        frame = av_frame_alloc();
+
+        if (!frame)
+            return NULL;
+
+        ret = av_hwframe_get_buffer(li->l.hw_frames_ctx, frame, 0);
+        if (ret < 0)
+            av_frame_free(&frame);
+
+        return frame;
+    }
+
+    /* with pipeline threading, buffers requested through pass-through
+     * filters may come from different threads */
+    if (li->l.graph && fffiltergraph(li->l.graph)->pipeline) {
+        ff_graph_pipeline_lock(fffiltergraph(li->l.graph));
+        frame = pool_get_video(li, w, h, align);
+        ff_graph_pipeline_unlock(fffiltergraph(li->l.graph));
+    } else {
+        frame = pool_get_video(li, w, h, align);
+    }
     if (!frame)
         return NULL;
 
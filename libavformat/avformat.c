@@ -29,6 +29,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/random_seed.h"
 #include "libavutil/samplefmt.h"
 #include "libavcodec/avcodec.h"
 #include "libavcodec/codec.h"
@@ -188,8 +189,11 @@ void avformat_free_context(AVFormatContext *s)
     avpriv_packet_list_free(&si->packet_buffer);
     av_freep(&s->streams);
     av_freep(&s->stream_groups);
-    if (s->iformat)
+    if (s->iformat) {
         ff_flush_packet_queue(s);
+        ff_index_cache_free(s);
+        ff_probe_cache_free(s);
+    }
     av_freep(&s->url);
     av_freep(&s->name);
     av_free(s);
@@ -908,3 +912,49 @@ int ff_format_io_close(AVFormatContext *s, AVIOContext **pb)
     *pb = NULL;
     return ret;
 }
+
+int ff_format_io_replace(AVFormatContext *s, const char *url, const char *what,
+                         void (*write)(AVFormatContext *s, void *opaque,
+                                       AVIOContext *pb),
+                         void *opaque)
+{
+    const char *proto = avio_find_protocol_name(url);
+    int use_rename = proto && !strcmp(proto, "file");
+    AVIOContext *pb;
+    char *tmp;
+    int ret, ret2;
+
+    /* Local files are written under a name that no other writer uses and
+     * then renamed into place, so readers never see a partial file. */
+    if (use_rename)
+        tmp = av_asprintf("%s.%08"PRIx32"%08"PRIx32".tmp", url,
+                          av_get_random_seed(), av_get_random_seed());
+    else
+        tmp = av_strdup(url);
+    if (!tmp)
+        return AVERROR(ENOMEM);
+
+    ret = s->io_open(s, &pb, tmp, AVIO_FLAG_WRITE, NULL);
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "Could not write %s '%s': %s\n",
+               what, tmp, av_err2str(ret));
+        av_free(tmp);
+        return ret;
+    }
+    write(s, opaque, pb);
+    avio_flush(pb);
+    ret  = pb->error;
+    ret2 = ff_format_io_close(s, &pb);
+    if (ret >= 0)
+        ret = ret2;
+
+    if (ret < 0)
+        av_log(s, AV_LOG_WARNING, "Could not write %s '%s': %s\n",
+               what, tmp, av_err2str(ret));
+    else if (use_rename)
+        ret = ff_rename(tmp, url, s);
+    if (ret < 0 && use_rename)
+        ffurl_delete(tmp);
+    av_free(tmp);
+    return ret;
+}
@@ -1888,6 +1888,27 @@ typedef struct AVFormatContext {
      * Name of this format context, only used for logging purposes.
      */
     char *name;
+
+    /**
+     * Path of a file in which the seek indexes built while demuxing, and the
+     * stream timings, are kept from one opening of the input to the next one.
+     * The cache is only used for seekable inputs of known size and is ignored
+     * when it was written for another file.
+     *
+     * Demuxing only, set by the caller before avformat_open_input().
+     */
+    char *index_cache;
+
+    /**
+     * Path of a directory in which the stream parameters found by
+     * avformat_find_stream_info() are stored, keyed by a fingerprint of the
+     * first bytes of the input. When an input starting with the same bytes is
+     * probed, the parameters are taken from there instead of being found
+     * by decoding its streams.
+     *
+     * Demuxing only, set by the caller before avformat_open_input().
+     */
+    char *probe_cache;
 } AVFormatContext;
 
 /**
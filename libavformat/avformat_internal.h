@@ -30,6 +30,9 @@
 #include "avformat.h"
 #include "internal.h"
 
+#define FF_FINGERPRINT_SIZE (64 << 10)
+#define FF_FINGERPRINT_HASH_SIZE 32
+
 typedef struct FormatContextInternal {
     FFFormatContext fc;
 
@@ -93,6 +96,26 @@ typedef struct FormatContextInternal {
              * Set if chapter ids are strictly monotonic.
              */
             int chapter_ids_monotonic;
+
+            /**
+             * SHA-256 of the first bytes of the input and number of bytes it
+             * was computed on, identifying the input for the caches; the size
+             * is 0 if they are not enabled.
+             */
+            uint8_t  fingerprint[FF_FINGERPRINT_HASH_SIZE];
+            int      fingerprint_size;
+
+            /**
+             * State of the seek index cache, if enabled with
+             * AVFormatContext.index_cache.
+             */
+            struct FFIndexCache *index_cache;
+
+            /**
+             * State of the probe cache during avformat_find_stream_info(),
+             * if enabled with AVFormatContext.probe_cache.
+             */
+            struct FFProbeCache *probe_cache;
         };
     };
 } FormatContextInternal;
@@ -139,6 +162,56 @@ static av_always_inline const FFStreamGroup *cffstreamgroup(const AVStreamGroup
 
 void ff_flush_packet_queue(AVFormatContext *s);
 
+/**
+ * Identify the input and load the matching index cache, if any.
+ * Must be called before reading anything after probing.
+ */
+int ff_index_cache_open(AVFormatContext *s);
+
+/**
+ * Add the cached index entries to the streams that have not got them yet.
+ */
+void ff_index_cache_apply(AVFormatContext *s);
+
+/**
+ * Set the stream timings from the cache.
+ *
+ * @return 1 if the timings were set, 0 if they are not cached
+ */
+int ff_index_cache_restore_timings(AVFormatContext *s);
+
+/**
+ * Write the index cache if it was updated, and free it.
+ */
+void ff_index_cache_close(AVFormatContext *s);
+
+void ff_index_cache_free(AVFormatContext *s);
+
+/**
+ * Load the stream parameters cached for inputs starting like this one, if any.
+ */
+int ff_probe_cache_open(AVFormatContext *s);
+
+/**
+ * Set the cached parameters on the streams once all of them have been found,
+ * if they all match the cache; the cache is dropped otherwise.
+ */
+int ff_probe_cache_apply(AVFormatContext *s);
+
+/**
+ * @return 1 if all the streams of the cache have been found
+ */
+int ff_probe_cache_complete(AVFormatContext *s);
+
+/**
+ * Store the stream parameters if they were not cached yet, and free the cache.
+ *
+ * @param success whether the parameters of all the streams were found
+ */
+void ff_probe_cache_close(AVFormatContext *s, int success);
+
+void ff_probe_cache_free(AVFormatContext *s);
+
 const struct AVCodec *ff_find_decoder(AVFormatContext *s, const AVStream *st,
                                       enum AVCodecID codec_id);
 
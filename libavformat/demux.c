@@ -26,6 +26,7 @@
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/dict.h"
+#include "libavutil/hash.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mathematics.h"
@@ -228,6 +229,39 @@ static av_always_inline int is_id3v2_format(const AVInputFormat *fmt) {
     return ffifmt(fmt)->flags_internal & FF_INFMT_FLAG_ID3V2_AUTO;
 }
 
+static int fingerprint_input(AVFormatContext *s)
+{
+    FormatContextInternal *const fci = ff_fc_internal(s);
+    int64_t pos = avio_tell(s->pb);
+    struct AVHashContext *hash;
+    uint8_t *buf;
+    int ret;
+
+    /* the probe data is still buffered, so this costs at most a short read */
+    if ((ret = ffio_ensure_seekback(s->pb, FF_FINGERPRINT_SIZE)) < 0)
+        return ret;
+    if ((ret = av_hash_alloc(&hash, "SHA256")) < 0)
+        return ret;
+    if (!(buf = av_malloc(FF_FINGERPRINT_SIZE))) {
+        av_hash_freep(&hash);
+        return AVERROR(ENOMEM);
+    }
+    ret = avio_read(s->pb, buf, FF_FINGERPRINT_SIZE);
+    if (ret > 0) {
+        av_hash_init(hash);
+        av_hash_update(hash, buf, ret);
+        av_hash_final_bin(hash, fci->fingerprint, sizeof(fci->fingerprint));
+        fci->fingerprint_size = ret;
+    }
+    av_hash_freep(&hash);
+    av_free(buf);
+    if (avio_seek(s->pb, pos, SEEK_SET) < 0) {
+        fci->fingerprint_size = 0;
+        return AVERROR(EIO);
+    }
+    return 0;
+}
+
 int avformat_open_input(AVFormatContext **ps, const char *filename,
                         const AVInputFormat *fmt, AVDictionary **options)
 {
@@ -289,6 +323,16 @@ int avformat_open_input(AVFormatContext **ps, const char *filename,
         goto fail;
     }
 
+    if ((s->index_cache || s->probe_cache) && s->pb) {
+        ret = fingerprint_input(s);
+        if (ret == AVERROR(ENOMEM))
+            goto fail;
+        if (ret < 0)
+            av_log(s, AV_LOG_WARNING, "Could not identify the input for caching\n");
+    }
+    if (s->index_cache && s->pb && (ret = ff_index_cache_open(s)) < 0)
+        goto fail;
+
     avio_skip(s->pb, s->skip_initial_bytes);
 
     /* Check filename in case an image number is expected. */
@@ -354,6 +398,8 @@ int avformat_open_input(AVFormatContext **ps, const char *filename,
 
     update_stream_avctx(s);
 
+    ff_index_cache_apply(s);
+
     if (options) {
         av_dict_free(options);
         *options = tmp;
@@ -389,9 +435,11 @@ void avformat_close_input(AVFormatContext **ps)
         (s->flags & AVFMT_FLAG_CUSTOM_IO))
         pb = NULL;
 
-    if (s->iformat)
+    if (s->iformat) {
+        ff_index_cache_close(s);
         if (ffifmt(s->iformat)->read_close)
             ffifmt(s->iformat)->read_close(s);
+    }
 
     ff_format_io_close(s, &pb);
     avformat_free_context(s);
@@ -2036,9 +2084,11 @@ static void estimate_timings(AVFormatContext *ic, int64_t old_offset)
         file_size = FFMAX(0, file_size);
     }
 
-    if ((!strcmp(ic->iformat->name, "mpeg") ||
-         !strcmp(ic->iformat->name, "mpegts")) &&
-        file_size && (ic->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+    if (ff_index_cache_restore_timings(ic)) {
+        /* estimated the last time the file was opened */
+    } else if ((!strcmp(ic->iformat->name, "mpeg") ||
+                !strcmp(ic->iformat->name, "mpegts")) &&
+               file_size && (ic->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
         /* get accurate estimate from the PTSes */
         estimate_timings_from_pts(ic, old_offset);
         ic->duration_estimation_method = AVFMT_DURATION_FROM_PTS;
@@ -2091,6 +2141,9 @@ static int has_codec_parameters(const AVStream *st, const char **errmsg_ptr)
     const FFStream *const sti = cffstream(st);
     const AVCodecContext *const avctx = sti->avctx;
 
+    if (sti->info->from_cache)
+        return 1;
+
 #define FAIL(errmsg) do {                                         \
         if (errmsg_ptr)                                           \
             *errmsg_ptr = errmsg;                                 \
@@ -2642,6 +2695,11 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
                avio_tell(ic->pb), ctx->bytes_read, ctx->seek_count, ic->nb_streams);
     }
 
+    if ((ret = ff_probe_cache_open(ic)) < 0 ||
+        (ret = ff_probe_cache_apply(ic)) < 0 ||
+        (ret = update_stream_avctx(ic)) < 0)
+        goto find_stream_info_err;
+
     for (unsigned i = 0; i < ic->nb_streams; i++) {
         const AVCodec *codec;
         AVDictionary *thread_opt = NULL;
@@ -2712,6 +2770,10 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             break;
         }
 
+        ret = ff_probe_cache_apply(ic);
+        if (ret < 0)
+            goto unref_then_goto_end;
+
         /* read_frame_internal() in a previous iteration of this loop may
          * have made changes to streams without returning a packet for them.
          * Handle that here. */
@@ -2728,6 +2790,15 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 
             if (!has_codec_parameters(st, NULL))
                 break;
+            if (sti->first_dts == AV_NOPTS_VALUE &&
+                (!(ic->iformat->flags & AVFMT_NOTIMESTAMPS) || sti->need_parsing == AVSTREAM_PARSE_FULL_RAW) &&
+                sti->codec_info_nb_frames < ((st->disposition & AV_DISPOSITION_ATTACHED_PIC) ? 1 : ic->max_ts_probe) &&
+                (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ||
+                 st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO))
+                break;
+            /* the rest is known from the cache */
+            if (sti->info->from_cache)
+                continue;
             /* If the timebase is coarse (like the usual millisecond precision
              * of mkv), we need to analyze more frames to reliably arrive at
              * the correct fps. */
@@ -2756,19 +2827,14 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
                 (!sti->extract_extradata.inited || sti->extract_extradata.bsf) &&
                 extract_extradata_check(st))
                 break;
-            if (sti->first_dts == AV_NOPTS_VALUE &&
-                (!(ic->iformat->flags & AVFMT_NOTIMESTAMPS) || sti->need_parsing == AVSTREAM_PARSE_FULL_RAW) &&
-                sti->codec_info_nb_frames < ((st->disposition & AV_DISPOSITION_ATTACHED_PIC) ? 1 : ic->max_ts_probe) &&
-                (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ||
-                 st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO))
-                break;
         }
         analyzed_all_streams = 0;
         if (i == ic->nb_streams && !si->missing_streams) {
             analyzed_all_streams = 1;
             /* NOTE: If the format has no header, then we need to read some
-             * packets to get most of the streams, so we cannot stop here. */
-            if (!(ic->ctx_flags & AVFMTCTX_NOHEADER)) {
+             * packets to get most of the streams, so we cannot stop here,
+             * unless the probe cache tells that all of them were found. */
+            if (!(ic->ctx_flags & AVFMTCTX_NOHEADER) || ff_probe_cache_complete(ic)) {
                 /* If we found the info for all the codecs, we can stop. */
                 ret = count;
                 av_log(ic, AV_LOG_DEBUG, "All info found\n");
@@ -2918,7 +2984,7 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             if (pkt->dts != pkt->pts && pkt->dts != AV_NOPTS_VALUE && pkt->pts != AV_NOPTS_VALUE)
                 sti->info->frame_delay_evidence = 1;
         }
-        if (!sti->avctx->extradata) {
+        if (!sti->avctx->extradata && !sti->info->from_cache) {
             ret = extract_extradata(si, st, pkt);
             if (ret < 0)
                 goto unref_then_goto_end;
@@ -2933,8 +2999,9 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
          * least one frame of codec data, this makes sure the codec initializes
          * the channel configuration and does not only trust the values from
          * the container. */
-        try_decode_frame(ic, st, pkt,
-                         (options && i < orig_nb_streams) ? &options[i] : NULL);
+        if (!sti->info->from_cache)
+            try_decode_frame(ic, st, pkt,
+                             (options && i < orig_nb_streams) ? &options[i] : NULL);
 
         if (ic->flags & AVFMT_FLAG_NOBUFFER)
             av_packet_unref(pkt1);
@@ -3090,6 +3157,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         }
     }
 
+    ff_index_cache_apply(ic);
+
     if (probesize)
         estimate_timings(ic, old_offset);
 
@@ -3183,6 +3252,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     }
 
 find_stream_info_err:
+    ff_probe_cache_close(ic, ret >= 0);
+
     for (unsigned i = 0; i < ic->nb_streams; i++) {
         AVStream *const st  = ic->streams[i];
         FFStream *const sti = ffstream(st);
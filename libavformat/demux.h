@@ -206,6 +206,12 @@ typedef struct FFStreamInfo {
      */
     int found_decoder;
 
+    /**
+     * The codec parameters were set from the probe cache, no need to
+     * decode anything.
+     */
+    int from_cache;
+
     int64_t last_duration;
 
     /**
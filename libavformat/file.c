@@ -97,6 +97,9 @@ typedef struct FileContext {
     int pkt_size;
     int follow;
     int seekable;
+    int readahead;
+    int64_t pos;
+    int64_t readahead_end;
 #if HAVE_DIRENT_H
     DIR *dir;
 #endif
@@ -108,6 +111,7 @@ static const AVOption file_options[] = {
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "seekable", "Sets if the file is seekable", offsetof(FileContext, seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
     { "pkt_size", "Maximum packet size", offsetof(FileContext, pkt_size), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "readahead", "set amount of data the kernel is asked to prefetch ahead of the read position", offsetof(FileContext, readahead), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -138,12 +142,34 @@ static const AVClass fd_class = {
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
+static void file_readahead(FileContext *c)
+{
+#if HAVE_POSIX_FADVISE && defined(POSIX_FADV_WILLNEED)
+    int64_t start = c->pos;
+
+    /* Only re-arm once half of the previously requested window is consumed,
+     * so that sequential reads cost one extra syscall per readahead / 2 bytes. */
+    if (c->pos >= c->readahead_end - c->readahead &&
+        c->pos <  c->readahead_end - c->readahead / 2)
+        return;
+    if (c->pos >= c->readahead_end - c->readahead && c->pos < c->readahead_end)
+        start = c->readahead_end;
+
+    c->readahead_end = c->pos + c->readahead;
+    posix_fadvise(c->fd, start, c->readahead_end - start, POSIX_FADV_WILLNEED);
+#endif
+}
+
 static int file_read(URLContext *h, unsigned char *buf, int size)
 {
     FileContext *c = h->priv_data;
     int ret;
     size = FFMIN(size, c->blocksize);
+    if (c->readahead)
+        file_readahead(c);
     ret = read(c->fd, buf, size);
+    if (ret > 0)
+        c->pos += ret;
     if (ret == 0 && c->follow)
         return AVERROR(EAGAIN);
     if (ret == 0)
@@ -240,6 +266,8 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
     }
 
     ret = lseek(c->fd, pos, whence);
+    if (ret >= 0)
+        c->pos = ret;
 
     return ret < 0 ? AVERROR(errno) : ret;
 }
@@ -287,7 +315,7 @@ static int file_open(URLContext *h, const char *filename, int flags)
     FileContext *c = h->priv_data;
     int access;
     int fd;
-    struct stat st;
+    struct stat st = { 0 };
 
     av_strstart(filename, "file:", &filename);
 
@@ -328,6 +356,14 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (c->seekable >= 0)
         h->is_streamed = !c->seekable;
 
+#if HAVE_POSIX_FADVISE && defined(POSIX_FADV_SEQUENTIAL)
+    /* Let the kernel use a larger readahead window of its own as well */
+    if (c->readahead && !(flags & AVIO_FLAG_WRITE) && S_ISREG(st.st_mode))
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    else
+#endif
+        c->readahead = 0;
+
     return 0;
 }
 
@@ -0,0 +1,342 @@
+/*
+ * Persistent seek index cache
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Sidecar file keeping the seek indexes built while demuxing a file, and the
+ * stream timings estimated by avformat_find_stream_info(), so that they do not
+ * have to be built again the next time the same file is opened.
+ *
+ * The file is identified by its size, the name of the demuxer and the
+ * fingerprints of its first and last bytes; a cache written for another file
+ * is ignored and replaced.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/crc.h"
+#include "libavutil/mem.h"
+
+#include "avformat.h"
+#include "avformat_internal.h"
+#include "avio_internal.h"
+#include "demux.h"
+#include "internal.h"
+
+#define INDEX_CACHE_TAG         MKBETAG('F', 'F', 'I', 'X')
+#define INDEX_CACHE_VERSION     3
+#define MAX_STREAMS             4096
+
+typedef struct IndexCacheStream {
+    int id;
+    enum AVMediaType codec_type;
+    AVRational time_base;
+    int64_t start_time;
+    int64_t duration;
+    AVIndexEntry *entries;
+    int nb_entries;
+    int applied;
+} IndexCacheStream;
+
+typedef struct FFIndexCache {
+    int64_t  file_size;
+    uint32_t tail_fingerprint;
+
+    /* contents of the cache file, if it matched the input */
+    int64_t start_time;
+    int64_t duration;
+    enum AVDurationEstimationMethod duration_estimation_method;
+    IndexCacheStream *streams;
+    int nb_streams;
+    int nb_applied;
+} FFIndexCache;
+
+static void free_streams(FFIndexCache *c)
+{
+    for (int i = 0; i < c->nb_streams; i++)
+        av_freep(&c->streams[i].entries);
+    av_freep(&c->streams);
+    c->nb_streams = c->nb_applied = 0;
+}
+
+static int read_cache(AVFormatContext *s, FFIndexCache *c, AVIOContext *pb)
+{
+    FormatContextInternal *const fci = ff_fc_internal(s);
+    uint8_t fingerprint[FF_FINGERPRINT_HASH_SIZE];
+    char name[64];
+    int nb_streams;
+
+    if (avio_rb32(pb) != INDEX_CACHE_TAG || avio_rb32(pb) != INDEX_CACHE_VERSION)
+        return AVERROR_INVALIDDATA;
+    avio_get_str(pb, INT_MAX, name, sizeof(name));
+    if (strcmp(name, s->iformat->name) ||
+        avio_rb64(pb) != c->file_size ||
+        avio_rb32(pb) != fci->fingerprint_size ||
+        avio_read(pb, fingerprint, sizeof(fingerprint)) != sizeof(fingerprint) ||
+        memcmp(fingerprint, fci->fingerprint, sizeof(fingerprint)) ||
+        avio_rb32(pb) != c->tail_fingerprint)
+        return AVERROR(EINVAL);
+
+    c->start_time = avio_rb64(pb);
+    c->duration   = avio_rb64(pb);
+    c->duration_estimation_method = avio_rb32(pb);
+    nb_streams    = avio_rb32(pb);
+    if (nb_streams > MAX_STREAMS)
+        return AVERROR_INVALIDDATA;
+    if (!(c->streams = av_calloc(nb_streams, sizeof(*c->streams))))
+        return AVERROR(ENOMEM);
+    c->nb_streams = nb_streams;
+
+    for (int i = 0; i < nb_streams; i++) {
+        IndexCacheStream *cst = &c->streams[i];
+        unsigned nb_entries;
+
+        cst->id             = avio_rb32(pb);
+        cst->codec_type     = avio_rb32(pb);
+        cst->time_base.num  = avio_rb32(pb);
+        cst->time_base.den  = avio_rb32(pb);
+        cst->start_time     = avio_rb64(pb);
+        cst->duration       = avio_rb64(pb);
+        nb_entries          = avio_rb32(pb);
+        if (avio_feof(pb) || nb_entries > s->max_index_size / sizeof(AVIndexEntry))
+            return AVERROR_INVALIDDATA;
+        if (!(cst->entries = av_malloc_array(nb_entries, sizeof(*cst->entries))))
+            return AVERROR(ENOMEM);
+        cst->nb_entries = nb_entries;
+
+        for (unsigned j = 0; j < nb_entries; j++) {
+            AVIndexEntry *e = &cst->entries[j];
+            unsigned size_flags;
+
+            e->pos          = avio_rb64(pb);
+            e->timestamp    = avio_rb64(pb);
+            size_flags      = avio_rb32(pb);
+            e->min_distance = avio_rb32(pb);
+            e->size         = size_flags >> 2;
+            e->flags        = size_flags & 3;
+        }
+        if (avio_feof(pb))
+            return AVERROR_INVALIDDATA;
+    }
+    return 0;
+}
+
+/* Files of the same size often start alike (same muxer, same headers), the
+ * end of the file tells edited copies apart.
+ * @return 1 on success, 0 if the end of the file cannot be read */
+static int fingerprint_tail(AVFormatContext *s, FFIndexCache *c)
+{
+    int64_t pos = avio_tell(s->pb), ret;
+    int size = FFMIN(c->file_size, FF_FINGERPRINT_SIZE);
+    uint8_t *buf;
+
+    if (!(buf = av_malloc(size)))
+        return AVERROR(ENOMEM);
+    ret = avio_seek(s->pb, c->file_size - size, SEEK_SET);
+    if (ret >= 0)
+        ret = avio_read(s->pb, buf, size);
+    if (ret == size)
+        c->tail_fingerprint = av_crc(av_crc_get_table(AV_CRC_32_IEEE_LE), 0, buf, size);
+    av_free(buf);
+    if (avio_seek(s->pb, pos, SEEK_SET) < 0)
+        return AVERROR(EIO);
+    return ret == size;
+}
+
+int ff_index_cache_open(AVFormatContext *s)
+{
+    FormatContextInternal *const fci = ff_fc_internal(s);
+    FFIndexCache *c;
+    AVIOContext *pb;
+    int ret;
+
+    /* Demuxers with their own seeking function manage their index
+     * themselves, usually from data of the file. */
+    if (ffifmt(s->iformat)->read_seek || ffifmt(s->iformat)->read_seek2)
+        return 0;
+
+    if (!fci->fingerprint_size || !(s->pb->seekable & AVIO_SEEKABLE_NORMAL) ||
+        avio_size(s->pb) <= 0) {
+        av_log(s, AV_LOG_VERBOSE, "Not using the index cache with this input\n");
+        return 0;
+    }
+
+    if (!(c = av_mallocz(sizeof(*c))))
+        return AVERROR(ENOMEM);
+    c->file_size = avio_size(s->pb);
+    c->duration  = AV_NOPTS_VALUE;
+    fci->index_cache = c;
+
+    if ((ret = fingerprint_tail(s, c)) <= 0) {
+        ff_index_cache_free(s);
+        if (!ret)
+            av_log(s, AV_LOG_VERBOSE, "Not using the index cache: cannot read the end of the input\n");
+        return ret;
+    }
+
+    ret = s->io_open(s, &pb, s->index_cache, AVIO_FLAG_READ, NULL);
+    if (ret < 0) {
+        if (ret != AVERROR(ENOENT))
+            av_log(s, AV_LOG_WARNING, "Could not open index cache '%s': %s\n",
+                   s->index_cache, av_err2str(ret));
+        return 0;
+    }
+    ret = read_cache(s, c, pb);
+    ff_format_io_close(s, &pb);
+    if (ret < 0) {
+        if (ret == AVERROR(ENOMEM))
+            return ret;
+        av_log(s, AV_LOG_VERBOSE, "Ignoring index cache '%s' %s\n", s->index_cache,
+               ret == AVERROR(EINVAL) ? "written for another file" : "which is invalid");
+        free_streams(c);
+        c->duration = AV_NOPTS_VALUE;
+        return 0;
+    }
+    av_log(s, AV_LOG_VERBOSE, "Loaded index cache '%s' with %d streams\n",
+           s->index_cache, c->nb_streams);
+    return 0;
+}
+
+void ff_index_cache_apply(AVFormatContext *s)
+{
+    FFIndexCache *const c = ff_fc_internal(s)->index_cache;
+
+    if (!c || c->nb_applied == c->nb_streams)
+        return;
+
+    for (int i = 0; i < FFMIN(c->nb_streams, s->nb_streams); i++) {
+        IndexCacheStream *const cst = &c->streams[i];
+        AVStream *const st  = s->streams[i];
+        FFStream *const sti = ffstream(st);
+
+        if (cst->applied)
+            continue;
+        cst->applied = 1;
+        c->nb_applied++;
+
+        if (st->id != cst->id ||
+            av_cmp_q(st->time_base, cst->time_base))
+            continue;
+        for (int j = 0; j < cst->nb_entries; j++) {
+            const AVIndexEntry *e = &cst->entries[j];
+            if (ff_add_index_entry(&sti->index_entries, &sti->nb_index_entries,
+                                   &sti->index_entries_allocated_size,
+                                   e->pos, e->timestamp, e->size,
+                                   e->min_distance, e->flags) < 0)
+                break;
+        }
+    }
+}
+
+int ff_index_cache_restore_timings(AVFormatContext *s)
+{
+    FFIndexCache *const c = ff_fc_internal(s)->index_cache;
+
+    if (!c || c->duration == AV_NOPTS_VALUE || c->nb_streams != s->nb_streams)
+        return 0;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        const AVStream *st = s->streams[i];
+        if (st->id != c->streams[i].id ||
+            st->codecpar->codec_type != c->streams[i].codec_type ||
+            av_cmp_q(st->time_base, c->streams[i].time_base))
+            return 0;
+    }
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        s->streams[i]->start_time = c->streams[i].start_time;
+        s->streams[i]->duration   = c->streams[i].duration;
+    }
+    s->start_time = c->start_time;
+    s->duration   = c->duration;
+    s->duration_estimation_method = c->duration_estimation_method;
+    return 1;
+}
+
+static int cache_outdated(AVFormatContext *s, const FFIndexCache *c)
+{
+    if (c->nb_streams != s->nb_streams ||
+        (c->duration == AV_NOPTS_VALUE && s->duration != AV_NOPTS_VALUE))
+        return 1;
+    for (int i = 0; i < s->nb_streams; i++)
+        if (ffstream(s->streams[i])->nb_index_entries > c->streams[i].nb_entries)
+            return 1;
+    return 0;
+}
+
+static void write_cache(AVFormatContext *s, void *opaque, AVIOContext *pb)
+{
+    const FFIndexCache *c = opaque;
+
+    avio_wb32(pb, INDEX_CACHE_TAG);
+    avio_wb32(pb, INDEX_CACHE_VERSION);
+    avio_put_str(pb, s->iformat->name);
+    avio_wb64(pb, c->file_size);
+    avio_wb32(pb, ff_fc_internal(s)->fingerprint_size);
+    avio_write(pb, ff_fc_internal(s)->fingerprint, FF_FINGERPRINT_HASH_SIZE);
+    avio_wb32(pb, c->tail_fingerprint);
+
+    avio_wb64(pb, s->start_time);
+    avio_wb64(pb, s->duration);
+    avio_wb32(pb, s->duration_estimation_method);
+    avio_wb32(pb, s->nb_streams);
+    for (int i = 0; i < s->nb_streams; i++) {
+        const AVStream *st  = s->streams[i];
+        const FFStream *sti = cffstream(st);
+        int nb_entries = sti->nb_index_entries;
+
+        avio_wb32(pb, st->id);
+        avio_wb32(pb, st->codecpar->codec_type);
+        avio_wb32(pb, st->time_base.num);
+        avio_wb32(pb, st->time_base.den);
+        avio_wb64(pb, st->start_time);
+        avio_wb64(pb, st->duration);
+        avio_wb32(pb, nb_entries);
+        for (int j = 0; j < nb_entries; j++) {
+            const AVIndexEntry *e = &sti->index_entries[j];
+            avio_wb64(pb, e->pos);
+            avio_wb64(pb, e->timestamp);
+            avio_wb32(pb, (unsigned)e->size << 2 | (e->flags & 3));
+            avio_wb32(pb, e->min_distance);
+        }
+    }
+}
+
+void ff_index_cache_close(AVFormatContext *s)
+{
+    FormatContextInternal *const fci = ff_fc_internal(s);
+    FFIndexCache *c = fci->index_cache;
+
+    if (!c)
+        return;
+
+    if (s->nb_streams <= MAX_STREAMS && cache_outdated(s, c))
+        ff_format_io_replace(s, s->index_cache, "index cache", write_cache, c);
+    ff_index_cache_free(s);
+}
+
+void ff_index_cache_free(AVFormatContext *s)
+{
+    FormatContextInternal *const fci = ff_fc_internal(s);
+
+    if (!fci->index_cache)
+        return;
+    free_streams(fci->index_cache);
+    av_freep(&fci->index_cache);
+}
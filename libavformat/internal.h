@@ -609,6 +609,23 @@ int ff_copy_whiteblacklists(AVFormatContext *dst, const AVFormatContext *src);
  */
 int ff_format_io_close(AVFormatContext *s, AVIOContext **pb);
 
+/**
+ * Create or replace a file through AVFormatContext.io_open.
+ *
+ * Local files are written under a unique temporary name next to url and
+ * then renamed over it, so that concurrent readers and writers of url never
+ * see a partial file. Other protocols are written to url directly.
+ *
+ * @param what  description of the file for the log messages
+ * @param write callback writing the contents to pb; errors are taken from
+ *              pb->error
+ * @return >=0 on success, negative AVERROR in case of failure
+ */
+int ff_format_io_replace(AVFormatContext *s, const char *url, const char *what,
+                         void (*write)(AVFormatContext *s, void *opaque,
+                                       AVIOContext *pb),
+                         void *opaque);
+
 /**
  * Utility function to check if the file uses http or https protocol
  *
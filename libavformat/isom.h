@@ -386,6 +386,9 @@ typedef struct MOVContext {
     int64_t idat_offset;
     int interleaved_read;
     AVDictionary* decryption_keys;
+    int prefetch_threads;
+    int prefetch_chunk_size;
+    struct FFPrefetchContext *prefetch;
 } MOVContext;
 
 int ff_mp4_read_descr_len(AVIOContext *pb);
@@ -66,6 +66,7 @@
 #include "isom.h"
 #include "matroska.h"
 #include "oggdec.h"
+#include "prefetch.h"
 /* For ff_codec_get_id(). */
 #include "riff.h"
 #include "rmsipr.h"
@@ -438,6 +439,10 @@ typedef struct MatroskaDemuxContext {
 
     /* Bandwidth value for WebM DASH Manifest */
     int bandwidth;
+
+    FFPrefetchContext *prefetch;
+    int prefetch_threads;
+    int prefetch_chunk_size;
 } MatroskaDemuxContext;
 
 #define CHILD_OF(parent) { .def = { .n = parent } }
@@ -3310,6 +3315,40 @@ static int matroska_parse_tracks(AVFormatContext *s)
     return 0;
 }
 
+/*
+ * Read the clusters ahead with several threads: they span from the first one
+ * up to the end of the segment or to the first level 1 element after them.
+ */
+static void matroska_init_prefetch(MatroskaDemuxContext *matroska)
+{
+    AVFormatContext *s = matroska->ctx;
+    int64_t start = avio_tell(s->pb) - 4, end = avio_size(s->pb);
+    int ret;
+
+    if (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) ||
+        matroska->current_id != MATROSKA_ID_CLUSTER || matroska->num_levels != 1)
+        return;
+
+    if (matroska->levels[0].length != EBML_UNKNOWN_LENGTH)
+        end = FFMIN(end, matroska->levels[0].start + matroska->levels[0].length);
+    for (int i = 0; i < matroska->num_level1_elems; i++) {
+        const MatroskaLevel1Element *elem = &matroska->level1_elems[i];
+        if (elem->pos > start)
+            end = FFMIN(end, elem->pos);
+    }
+    if (end <= start)
+        return;
+
+    ret = ff_prefetch_init(&matroska->prefetch, s, matroska->prefetch_threads,
+                           matroska->prefetch_chunk_size);
+    if (ret >= 0)
+        ret = ff_prefetch_add_range(matroska->prefetch, start, end - start);
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "Cannot prefetch the clusters: %s\n", av_err2str(ret));
+        ff_prefetch_uninit(&matroska->prefetch);
+    }
+}
+
 static int matroska_read_header(AVFormatContext *s)
 {
     FFFormatContext *const si = ffformatcontext(s);
@@ -3459,6 +3498,9 @@ static int matroska_read_header(AVFormatContext *s)
 
     matroska_convert_tags(s);
 
+    if (matroska->prefetch_threads)
+        matroska_init_prefetch(matroska);
+
     return 0;
 }
 
@@ -4401,6 +4443,7 @@ static int matroska_read_close(AVFormatContext *s)
     int n;
 
     matroska_clear_queue(matroska);
+    ff_prefetch_uninit(&matroska->prefetch);
 
     for (n = 0; n < matroska->tracks.nb_elem; n++)
         if (tracks[n].type == MATROSKA_TRACK_TYPE_AUDIO)
@@ -4410,6 +4453,8 @@ static int matroska_read_close(AVFormatContext *s)
     return 0;
 }
 
+#define OFFSET(x) offsetof(MatroskaDemuxContext, x)
+
 #if CONFIG_WEBM_DASH_MANIFEST_DEMUXER
 typedef struct {
     int64_t start_time_ns;
@@ -4833,7 +4878,6 @@ static int webm_dash_manifest_read_packet(AVFormatContext *s, AVPacket *pkt)
     return AVERROR_EOF;
 }
 
-#define OFFSET(x) offsetof(MatroskaDemuxContext, x)
 static const AVOption options[] = {
     { "live", "flag indicating that the input is a live file that only has the headers.", OFFSET(is_live), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "bandwidth", "bandwidth of this stream to be specified in the DASH manifest.", OFFSET(bandwidth), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_DECODING_PARAM },
@@ -4859,11 +4903,25 @@ const FFInputFormat ff_webm_dash_manifest_demuxer = {
 };
 #endif
 
+static const AVOption matroska_options[] = {
+    { "prefetch_threads", "number of threads reading the clusters ahead of the demuxer", OFFSET(prefetch_threads), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, AV_OPT_FLAG_DECODING_PARAM },
+    { "prefetch_chunk_size", "size of the blocks read ahead by each thread", OFFSET(prefetch_chunk_size), AV_OPT_TYPE_INT, {.i64 = 4 << 20}, 1 << 12, 1 << 28, AV_OPT_FLAG_DECODING_PARAM },
+    { NULL },
+};
+
+static const AVClass matroska_class = {
+    .class_name = "matroska,webm demuxer",
+    .item_name  = av_default_item_name,
+    .option     = matroska_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 const FFInputFormat ff_matroska_demuxer = {
     .p.name         = "matroska,webm",
     .p.long_name    = NULL_IF_CONFIG_SMALL("Matroska / WebM"),
     .p.extensions   = "mkv,mk3d,mka,mks,webm",
     .p.mime_type    = "audio/webm,audio/x-matroska,video/webm,video/x-matroska",
+    .p.priv_class   = &matroska_class,
     .priv_data_size = sizeof(MatroskaDemuxContext),
     .flags_internal = FF_INFMT_FLAG_INIT_CLEANUP,
     .read_probe     = matroska_probe,
@@ -69,6 +69,7 @@
 #include "libavcodec/get_bits.h"
 #include "id3v1.h"
 #include "mov_chan.h"
+#include "prefetch.h"
 #include "replaygain.h"
 
 #if CONFIG_ZLIB
@@ -10114,6 +10115,8 @@ static int mov_read_close(AVFormatContext *s)
         mov_free_stream_context(s, st);
     }
 
+    ff_prefetch_uninit(&mov->prefetch);
+
     av_freep(&mov->dv_demux);
     avformat_free_context(mov->dv_fctx);
     mov->dv_fctx = NULL;
@@ -10872,6 +10875,32 @@ static void fix_stream_ids(AVFormatContext *s)
     }
 }
 
+/*
+ * Read the fragments ahead with several threads, from the first one up to the
+ * end of the file.
+ */
+static void mov_init_prefetch(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+    int64_t start, end = avio_size(s->pb);
+    int ret;
+
+    if (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) || !mov->frag_index.nb_items)
+        return;
+    start = mov->frag_index.item[0].moof_offset;
+    if (start < 0 || end <= start)
+        return;
+
+    ret = ff_prefetch_init(&mov->prefetch, s, mov->prefetch_threads,
+                           mov->prefetch_chunk_size);
+    if (ret >= 0)
+        ret = ff_prefetch_add_range(mov->prefetch, start, end - start);
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "Cannot prefetch the fragments: %s\n", av_err2str(ret));
+        ff_prefetch_uninit(&mov->prefetch);
+    }
+}
+
 static int mov_read_header(AVFormatContext *s)
 {
     MOVContext *mov = s->priv_data;
@@ -11112,6 +11141,9 @@ static int mov_read_header(AVFormatContext *s)
         if (mov->frag_index.item[i].moof_offset <= mov->fragment.moof_offset)
             mov->frag_index.item[i].headers_read = 1;
 
+    if (mov->prefetch_threads)
+        mov_init_prefetch(s);
+
     return 0;
 }
 
@@ -11777,6 +11809,8 @@ static const AVOption mov_options[] = {
         {.i64 = 0}, 0, 1, FLAGS },
     { "max_stts_delta", "treat offsets above this value as invalid", OFFSET(max_stts_delta), AV_OPT_TYPE_INT, {.i64 = UINT_MAX-48000*10 }, 0, UINT_MAX, .flags = AV_OPT_FLAG_DECODING_PARAM },
     { "interleaved_read", "Interleave packets from multiple tracks at demuxer level", OFFSET(interleaved_read), AV_OPT_TYPE_BOOL, {.i64 = 1 }, 0, 1, .flags = AV_OPT_FLAG_DECODING_PARAM },
+    { "prefetch_threads", "Number of threads reading the fragments ahead of the demuxer", OFFSET(prefetch_threads), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, 64, .flags = AV_OPT_FLAG_DECODING_PARAM },
+    { "prefetch_chunk_size", "Size of the blocks read ahead by each thread", OFFSET(prefetch_chunk_size), AV_OPT_TYPE_INT, {.i64 = 4 << 20 }, 1 << 12, 1 << 28, .flags = AV_OPT_FLAG_DECODING_PARAM },
 
     { NULL },
 };
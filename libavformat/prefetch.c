@@ -0,0 +1,472 @@
+/*
+ * Concurrent read-ahead for demuxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/dict.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "avio_internal.h"
+#include "internal.h"
+#include "prefetch.h"
+
+#if HAVE_THREADS
+
+enum ChunkState {
+    CHUNK_IDLE,
+    CHUNK_QUEUED,
+    CHUNK_LOADING,
+    CHUNK_DONE,
+    CHUNK_FAILED,           ///< read it synchronously from the fallback
+};
+
+typedef struct PrefetchChunk {
+    int64_t pos;
+    int size;
+    enum ChunkState state;
+    uint8_t *data;
+} PrefetchChunk;
+
+typedef struct PrefetchWorker {
+    FFPrefetchContext *pf;
+    AVIOContext *pb;
+    pthread_t thread;
+    int thread_created;
+} PrefetchWorker;
+
+struct FFPrefetchContext {
+    AVFormatContext *s;
+    AVIOContext *pb;        ///< s->pb, NULL until the callbacks below are replaced
+
+    /* original callbacks of pb, used for the data that is not prefetched */
+    void *opaque;
+    int (*read_packet)(void *opaque, uint8_t *buf, int buf_size);
+    int64_t (*seek)(void *opaque, int64_t offset, int whence);
+    int (*read_pause)(void *opaque, int pause);
+    int64_t (*read_seek)(void *opaque, int stream_index,
+                         int64_t timestamp, int flags);
+    int (*short_seek_get)(void *opaque);
+
+    int64_t pos;            ///< position of the data returned by the next read
+    int64_t fallback_pos;   ///< position of the original callbacks
+
+    int chunk_size;
+    PrefetchChunk *chunks;
+    int nb_chunks;
+    int cur;                ///< first chunk of the window, -1 before the first read
+    int window;             ///< number of chunks loaded or being loaded ahead
+
+    PrefetchWorker *workers;
+    int nb_workers;
+
+    int sync_init;
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    int abort;
+};
+
+static int in_window(const FFPrefetchContext *pf, int i)
+{
+    return pf->cur >= 0 && i >= pf->cur && i < pf->cur + pf->window;
+}
+
+static void *prefetch_worker(void *arg)
+{
+    PrefetchWorker *w = arg;
+    FFPrefetchContext *pf = w->pf;
+
+    pthread_mutex_lock(&pf->mutex);
+    while (!pf->abort) {
+        PrefetchChunk *c;
+        uint8_t *data;
+        int64_t pos, ret;
+        int i, end, size;
+
+        end = pf->cur < 0 ? 0 : FFMIN(pf->cur + pf->window, pf->nb_chunks);
+        for (i = FFMAX(pf->cur, 0); i < end; i++)
+            if (pf->chunks[i].state == CHUNK_QUEUED)
+                break;
+        if (i >= end) {
+            pthread_cond_wait(&pf->work_cond, &pf->mutex);
+            continue;
+        }
+
+        c        = &pf->chunks[i];
+        c->state = CHUNK_LOADING;
+        pos      = c->pos;
+        size     = c->size;
+        pthread_mutex_unlock(&pf->mutex);
+
+        data = av_malloc(size);
+        ret  = AVERROR(ENOMEM);
+        if (data) {
+            ret = avio_seek(w->pb, pos, SEEK_SET);
+            if (ret >= 0)
+                ret = avio_read(w->pb, data, size);
+        }
+
+        pthread_mutex_lock(&pf->mutex);
+        c = &pf->chunks[i];
+        if (ret == size && in_window(pf, i)) {
+            c->data  = data;
+            c->state = CHUNK_DONE;
+        } else {
+            av_free(data);
+            c->state = in_window(pf, i) ? CHUNK_FAILED : CHUNK_IDLE;
+        }
+        pthread_cond_broadcast(&pf->done_cond);
+    }
+    pthread_mutex_unlock(&pf->mutex);
+
+    return NULL;
+}
+
+static int find_chunk(const FFPrefetchContext *pf, int64_t pos)
+{
+    int lo = 0, hi = pf->nb_chunks;
+
+    if (pf->cur >= 0 && pf->cur < pf->nb_chunks &&
+        pos >= pf->chunks[pf->cur].pos) {
+        for (int i = pf->cur; i < FFMIN(pf->cur + 2, pf->nb_chunks); i++)
+            if (pos < pf->chunks[i].pos + pf->chunks[i].size)
+                return pos >= pf->chunks[i].pos ? i : -1;
+    }
+
+    /* first chunk ending after pos */
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (pf->chunks[mid].pos + pf->chunks[mid].size <= pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < pf->nb_chunks && pos >= pf->chunks[lo].pos ? lo : -1;
+}
+
+/* Called with the mutex locked. */
+static void move_window(FFPrefetchContext *pf, int cur)
+{
+    int old = pf->cur;
+
+    pf->cur = cur;
+    if (old >= 0) {
+        for (int i = old; i < FFMIN(old + pf->window, pf->nb_chunks); i++) {
+            PrefetchChunk *c = &pf->chunks[i];
+            if (in_window(pf, i) || c->state == CHUNK_LOADING)
+                continue;
+            av_freep(&c->data);
+            c->state = CHUNK_IDLE;
+        }
+    }
+    for (int i = cur; i < FFMIN(cur + pf->window, pf->nb_chunks); i++)
+        if (pf->chunks[i].state == CHUNK_IDLE)
+            pf->chunks[i].state = CHUNK_QUEUED;
+    pthread_cond_broadcast(&pf->work_cond);
+}
+
+static int prefetch_read(void *opaque, uint8_t *buf, int buf_size)
+{
+    FFPrefetchContext *pf = opaque;
+    int i = find_chunk(pf, pf->pos);
+    int64_t ret;
+
+    if (i >= 0) {
+        PrefetchChunk *c = &pf->chunks[i];
+        int off = pf->pos - c->pos;
+
+        pthread_mutex_lock(&pf->mutex);
+        if (i != pf->cur)
+            move_window(pf, i);
+        while (c->state == CHUNK_QUEUED || c->state == CHUNK_LOADING)
+            pthread_cond_wait(&pf->done_cond, &pf->mutex);
+        pthread_mutex_unlock(&pf->mutex);
+
+        buf_size = FFMIN(buf_size, c->size - off);
+        if (c->state == CHUNK_DONE) {
+            memcpy(buf, c->data + off, buf_size);
+            pf->pos += buf_size;
+            return buf_size;
+        }
+    } else {
+        /* do not read over the next chunk */
+        int lo = 0, hi = pf->nb_chunks;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (pf->chunks[mid].pos <= pf->pos)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo < pf->nb_chunks)
+            buf_size = FFMIN(buf_size, pf->chunks[lo].pos - pf->pos);
+    }
+
+    if (pf->fallback_pos != pf->pos) {
+        ret = pf->seek(pf->opaque, pf->pos, SEEK_SET);
+        if (ret < 0)
+            return ret;
+        pf->fallback_pos = pf->pos;
+    }
+    ret = pf->read_packet(pf->opaque, buf, buf_size);
+    if (ret <= 0)
+        return ret ? ret : AVERROR_EOF;
+    pf->pos          += ret;
+    pf->fallback_pos += ret;
+    return ret;
+}
+
+static int64_t prefetch_seek(void *opaque, int64_t offset, int whence)
+{
+    FFPrefetchContext *pf = opaque;
+    int64_t size;
+
+    switch (whence) {
+    case AVSEEK_SIZE:
+        return pf->seek(pf->opaque, 0, AVSEEK_SIZE);
+    case SEEK_CUR:
+        offset += pf->pos;
+        break;
+    case SEEK_END:
+        size = pf->seek(pf->opaque, 0, AVSEEK_SIZE);
+        if (size < 0)
+            return size;
+        offset += size;
+        break;
+    case SEEK_SET:
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (offset < 0)
+        return AVERROR(EINVAL);
+    return pf->pos = offset;
+}
+
+int ff_prefetch_init(FFPrefetchContext **ppf, AVFormatContext *s,
+                     int nb_threads, int chunk_size)
+{
+    AVIOContext *pb = s->pb;
+    AVDictionary *opts = NULL;
+    FFPrefetchContext *pf;
+    int ret;
+
+    *ppf = NULL;
+    /* The callbacks of a caller-provided context are not ours to replace, and
+     * its URL may not be openable anyway. */
+    if (!pb || !(pb->seekable & AVIO_SEEKABLE_NORMAL) || !pb->seek ||
+        pb->write_flag || (s->flags & AVFMT_FLAG_CUSTOM_IO))
+        return AVERROR(ENOSYS);
+
+    pf = av_mallocz(sizeof(*pf));
+    if (!pf)
+        return AVERROR(ENOMEM);
+    *ppf = pf;
+
+    pf->s          = s;
+    pf->chunk_size = chunk_size;
+    pf->cur        = -1;
+    pf->window     = 2 * nb_threads;
+
+    if ((ret = AVERROR(pthread_mutex_init(&pf->mutex, NULL))))
+        goto fail;
+    if ((ret = AVERROR(pthread_cond_init(&pf->work_cond, NULL)))) {
+        pthread_mutex_destroy(&pf->mutex);
+        goto fail;
+    }
+    if ((ret = AVERROR(pthread_cond_init(&pf->done_cond, NULL)))) {
+        pthread_cond_destroy(&pf->work_cond);
+        pthread_mutex_destroy(&pf->mutex);
+        goto fail;
+    }
+    pf->sync_init = 1;
+
+    pf->workers = av_calloc(nb_threads, sizeof(*pf->workers));
+    if (!pf->workers) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    /* Open the URL again the way s->pb was opened: with the same HTTP
+     * headers, cookies and timeouts, and within the same protocol lists. */
+    if ((ret = ffio_copy_url_options(pb, &opts)) < 0 ||
+        (ret = av_dict_set(&opts, "protocol_whitelist", s->protocol_whitelist, 0)) < 0 ||
+        (ret = av_dict_set(&opts, "protocol_blacklist", s->protocol_blacklist, 0)) < 0)
+        goto fail;
+    for (; pf->nb_workers < nb_threads; pf->nb_workers++) {
+        PrefetchWorker *w = &pf->workers[pf->nb_workers];
+        AVDictionary *tmp = NULL;
+
+        w->pf = pf;
+        if ((ret = av_dict_copy(&tmp, opts, 0)) >= 0)
+            ret = s->io_open(s, &w->pb, s->url, AVIO_FLAG_READ, &tmp);
+        av_dict_free(&tmp);
+        if (ret < 0)
+            goto fail;
+    }
+    av_dict_free(&opts);
+    for (int i = 0; i < pf->nb_workers; i++) {
+        PrefetchWorker *w = &pf->workers[i];
+
+        ret = AVERROR(pthread_create(&w->thread, NULL, prefetch_worker, w));
+        if (ret < 0)
+            goto fail;
+        w->thread_created = 1;
+    }
+
+    pf->pb             = pb;
+    pf->opaque         = pb->opaque;
+    pf->read_packet    = pb->read_packet;
+    pf->seek           = pb->seek;
+    pf->read_pause     = pb->read_pause;
+    pf->read_seek      = pb->read_seek;
+    pf->short_seek_get = ffiocontext(pb)->short_seek_get;
+    pf->pos            = pb->pos;
+    pf->fallback_pos   = pb->pos;
+
+    pb->opaque         = pf;
+    pb->read_packet    = prefetch_read;
+    pb->seek           = prefetch_seek;
+    pb->read_pause     = NULL;
+    pb->read_seek      = NULL;
+    ffiocontext(pb)->short_seek_get = NULL;
+
+    av_log(s, AV_LOG_VERBOSE, "Reading ahead with %d threads in chunks of %d bytes\n",
+           nb_threads, chunk_size);
+
+    return 0;
+fail:
+    av_dict_free(&opts);
+    ff_prefetch_uninit(ppf);
+    return ret;
+}
+
+int ff_prefetch_add_range(FFPrefetchContext *pf, int64_t pos, int64_t size)
+{
+    const PrefetchChunk *last = pf->nb_chunks ? &pf->chunks[pf->nb_chunks - 1] : NULL;
+    int nb_new = (size + pf->chunk_size - 1) / pf->chunk_size;
+    PrefetchChunk *chunks;
+
+    if (pos < 0 || size <= 0 || (last && pos < last->pos + last->size) ||
+        nb_new > INT_MAX - 1 - pf->nb_chunks)
+        return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&pf->mutex);
+    chunks = av_realloc_array(pf->chunks, pf->nb_chunks + nb_new, sizeof(*chunks));
+    if (!chunks) {
+        pthread_mutex_unlock(&pf->mutex);
+        return AVERROR(ENOMEM);
+    }
+    pf->chunks = chunks;
+    for (; size > 0; pf->nb_chunks++) {
+        PrefetchChunk *c = &chunks[pf->nb_chunks];
+
+        *c = (PrefetchChunk){
+            .pos  = pos,
+            .size = FFMIN(size, pf->chunk_size),
+        };
+        if (in_window(pf, pf->nb_chunks))
+            c->state = CHUNK_QUEUED;
+        pos  += c->size;
+        size -= c->size;
+    }
+    pthread_cond_broadcast(&pf->work_cond);
+    pthread_mutex_unlock(&pf->mutex);
+
+    return 0;
+}
+
+/* Give the context its callbacks back, positioned where it expects them. */
+static void restore_pb(FFPrefetchContext *pf)
+{
+    AVIOContext *pb = pf->pb;
+
+    pb->opaque      = pf->opaque;
+    pb->read_packet = pf->read_packet;
+    pb->seek        = pf->seek;
+    pb->read_pause  = pf->read_pause;
+    pb->read_seek   = pf->read_seek;
+    ffiocontext(pb)->short_seek_get = pf->short_seek_get;
+
+    if (pf->fallback_pos != pf->pos) {
+        int64_t ret = pf->seek(pf->opaque, pf->pos, SEEK_SET);
+        if (ret < 0) {
+            pb->error   = ret;
+            pb->pos     = pf->fallback_pos;
+            pb->buf_ptr = pb->buf_end = pb->buffer;
+        }
+    }
+}
+
+void ff_prefetch_uninit(FFPrefetchContext **ppf)
+{
+    FFPrefetchContext *pf = *ppf;
+
+    if (!pf)
+        return;
+
+    if (pf->sync_init) {
+        pthread_mutex_lock(&pf->mutex);
+        pf->abort = 1;
+        pthread_cond_broadcast(&pf->work_cond);
+        pthread_mutex_unlock(&pf->mutex);
+    }
+    for (int i = 0; i < pf->nb_workers; i++) {
+        PrefetchWorker *w = &pf->workers[i];
+
+        if (w->thread_created)
+            pthread_join(w->thread, NULL);
+        ff_format_io_close(pf->s, &w->pb);
+    }
+    av_freep(&pf->workers);
+
+    if (pf->pb)
+        restore_pb(pf);
+
+    for (int i = 0; i < pf->nb_chunks; i++)
+        av_freep(&pf->chunks[i].data);
+    av_freep(&pf->chunks);
+
+    if (pf->sync_init) {
+        pthread_cond_destroy(&pf->done_cond);
+        pthread_cond_destroy(&pf->work_cond);
+        pthread_mutex_destroy(&pf->mutex);
+    }
+    av_freep(ppf);
+}
+
+#else /* HAVE_THREADS */
+
+int ff_prefetch_init(FFPrefetchContext **pf, AVFormatContext *s,
+                     int nb_threads, int chunk_size)
+{
+    *pf = NULL;
+    return AVERROR(ENOSYS);
+}
+
+int ff_prefetch_add_range(FFPrefetchContext *pf, int64_t pos, int64_t size)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_prefetch_uninit(FFPrefetchContext **pf)
+{
+}
+
+#endif /* HAVE_THREADS */
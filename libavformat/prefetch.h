@@ -0,0 +1,67 @@
+/*
+ * Concurrent read-ahead for demuxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_PREFETCH_H
+#define AVFORMAT_PREFETCH_H
+
+/**
+ * @file
+ * Concurrent read-ahead of the parts of a file a demuxer knows it is going
+ * to read sequentially, e.g. the clusters or fragments of an indexed file.
+ *
+ * The registered ranges are split into chunks which are read a few chunks
+ * ahead of the demuxer by worker threads, each one using its own I/O context
+ * opened on the input URL. The read and seek callbacks of the demuxer's own
+ * AVIOContext are replaced while prefetching, so that it serves the data from
+ * the loaded chunks and reads everything else as before: s->pb stays the one
+ * context everything is read and positioned through, and the data, and thus
+ * the packets, are seen in the same order as without prefetching.
+ */
+
+#include <stdint.h>
+
+#include "avformat.h"
+
+typedef struct FFPrefetchContext FFPrefetchContext;
+
+/**
+ * Start the reading threads and make s->pb read through them.
+ *
+ * @param nb_threads number of reading threads
+ * @param chunk_size size of the units read by the threads
+ * @return 0 on success, a negative error code if prefetching is not possible
+ *         (e.g. without threads support, for a non-seekable or caller-provided
+ *         s->pb, or if the URL cannot be reopened)
+ */
+int ff_prefetch_init(FFPrefetchContext **pf, AVFormatContext *s,
+                     int nb_threads, int chunk_size);
+
+/**
+ * Register a range of bytes that is going to be read sequentially.
+ * Ranges must be added in increasing order and must not overlap.
+ */
+int ff_prefetch_add_range(FFPrefetchContext *pf, int64_t pos, int64_t size);
+
+/**
+ * Stop the reading threads and give s->pb its own callbacks back.
+ */
+void ff_prefetch_uninit(FFPrefetchContext **pf);
+
+#endif /* AVFORMAT_PREFETCH_H */
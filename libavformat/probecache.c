@@ -0,0 +1,468 @@
+/*
+ * Cache of the stream parameters found by avformat_find_stream_info()
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * The codec parameters found by avformat_find_stream_info() are stored in a
+ * directory, in a file named after the SHA-256 of the first bytes of the
+ * input. When an input with the same beginning is probed, the parameters are
+ * taken from that file, so that its streams do not have to be decoded, and
+ * reading stops as soon as all the streams have been seen.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/samplefmt.h"
+
+#include "libavcodec/codec_desc.h"
+#include "libavcodec/codec_par.h"
+
+#include "avformat.h"
+#include "avformat_internal.h"
+#include "avio_internal.h"
+#include "demux.h"
+#include "internal.h"
+
+#define PROBE_CACHE_TAG         MKBETAG('F', 'F', 'P', 'C')
+#define PROBE_CACHE_VERSION     2
+#define MAX_STREAMS             4096
+#define MAX_EXTRADATA_SIZE      (1 << 24)
+#define MAX_SIDE_DATA           64
+
+typedef struct ProbeCacheStream {
+    int id;
+    AVCodecParameters *par;
+    AVRational avg_frame_rate;
+    AVRational r_frame_rate;
+    AVRational sample_aspect_ratio;
+    int codec_info_nb_frames;
+} ProbeCacheStream;
+
+typedef struct FFProbeCache {
+    char *path;
+    ProbeCacheStream *streams;
+    int nb_streams;
+    int applied;
+} FFProbeCache;
+
+static void free_streams(FFProbeCache *c)
+{
+    for (int i = 0; i < c->nb_streams; i++)
+        avcodec_parameters_free(&c->streams[i].par);
+    av_freep(&c->streams);
+    c->nb_streams = 0;
+}
+
+static AVRational read_q(AVIOContext *pb)
+{
+    AVRational q;
+    q.num = avio_rb32(pb);
+    q.den = avio_rb32(pb);
+    return q;
+}
+
+static void write_q(AVIOContext *pb, AVRational q)
+{
+    avio_wb32(pb, q.num);
+    avio_wb32(pb, q.den);
+}
+
+static int read_par(AVIOContext *pb, AVCodecParameters *par)
+{
+    enum AVChannelOrder order;
+    int nb_channels, nb_side_data, ret;
+
+    par->codec_type             = avio_rb32(pb);
+    par->codec_id               = avio_rb32(pb);
+    par->codec_tag              = avio_rb32(pb);
+    par->format                 = avio_rb32(pb);
+    par->bit_rate               = avio_rb64(pb);
+    par->bits_per_coded_sample  = avio_rb32(pb);
+    par->bits_per_raw_sample    = avio_rb32(pb);
+    par->profile                = avio_rb32(pb);
+    par->level                  = avio_rb32(pb);
+    par->width                  = avio_rb32(pb);
+    par->height                 = avio_rb32(pb);
+    par->sample_aspect_ratio    = read_q(pb);
+    par->framerate              = read_q(pb);
+    par->field_order            = avio_rb32(pb);
+    par->color_range            = avio_rb32(pb);
+    par->color_primaries        = avio_rb32(pb);
+    par->color_trc              = avio_rb32(pb);
+    par->color_space            = avio_rb32(pb);
+    par->chroma_location        = avio_rb32(pb);
+    par->video_delay            = avio_rb32(pb);
+    par->sample_rate            = avio_rb32(pb);
+    par->block_align            = avio_rb32(pb);
+    par->frame_size             = avio_rb32(pb);
+    par->initial_padding        = avio_rb32(pb);
+    par->trailing_padding       = avio_rb32(pb);
+    par->seek_preroll           = avio_rb32(pb);
+    par->alpha_mode             = avio_rb32(pb);
+
+    if ((unsigned)par->codec_type >= AVMEDIA_TYPE_NB ||
+        (par->codec_id && !avcodec_descriptor_get(par->codec_id)) ||
+        par->width < 0 || par->height < 0 || par->sample_rate < 0 ||
+        (unsigned)par->field_order > AV_FIELD_BT ||
+        !av_color_range_name(par->color_range) ||
+        !av_color_primaries_name(par->color_primaries) ||
+        !av_color_transfer_name(par->color_trc) ||
+        !av_color_space_name(par->color_space) ||
+        !av_chroma_location_name(par->chroma_location) ||
+        !av_alpha_mode_name(par->alpha_mode))
+        return AVERROR_INVALIDDATA;
+    if (par->format != -1 &&
+        (par->codec_type == AVMEDIA_TYPE_VIDEO ? !av_pix_fmt_desc_get(par->format) :
+         par->codec_type == AVMEDIA_TYPE_AUDIO ? !av_get_sample_fmt_name(par->format) : 0))
+        return AVERROR_INVALIDDATA;
+
+    order       = avio_rb32(pb);
+    nb_channels = avio_rb32(pb);
+    if (nb_channels < 0 || nb_channels > 512 ||
+        (!nb_channels && order != AV_CHANNEL_ORDER_UNSPEC))
+        return AVERROR_INVALIDDATA;
+    if (order == AV_CHANNEL_ORDER_CUSTOM) {
+        if ((ret = av_channel_layout_custom_init(&par->ch_layout, nb_channels)) < 0)
+            return ret;
+        for (int i = 0; i < nb_channels; i++)
+            par->ch_layout.u.map[i].id = avio_rb32(pb);
+    } else {
+        par->ch_layout.order       = order;
+        par->ch_layout.nb_channels = nb_channels;
+        par->ch_layout.u.mask      = avio_rb64(pb);
+    }
+    if (nb_channels ? !av_channel_layout_check(&par->ch_layout) : !!par->ch_layout.u.mask)
+        return AVERROR_INVALIDDATA;
+
+    nb_side_data = avio_rb32(pb);
+    if (nb_side_data > MAX_SIDE_DATA)
+        return AVERROR_INVALIDDATA;
+    for (int i = 0; i < nb_side_data; i++) {
+        enum AVPacketSideDataType type = avio_rb32(pb);
+        unsigned size = avio_rb32(pb);
+        uint8_t *data;
+
+        if ((unsigned)type >= AV_PKT_DATA_NB || size > MAX_EXTRADATA_SIZE ||
+            avio_feof(pb))
+            return AVERROR_INVALIDDATA;
+        if (!(data = av_malloc(size + !size)))
+            return AVERROR(ENOMEM);
+        avio_read(pb, data, size);
+        if (!av_packet_side_data_add(&par->coded_side_data, &par->nb_coded_side_data,
+                                     type, data, size, 0)) {
+            av_free(data);
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    par->extradata_size = avio_rb32(pb);
+    if ((unsigned)par->extradata_size > MAX_EXTRADATA_SIZE) {
+        par->extradata_size = 0;
+        return AVERROR_INVALIDDATA;
+    }
+    if (par->extradata_size) {
+        par->extradata = av_mallocz(par->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+        if (!par->extradata) {
+            par->extradata_size = 0;
+            return AVERROR(ENOMEM);
+        }
+        avio_read(pb, par->extradata, par->extradata_size);
+    }
+    return avio_feof(pb) ? AVERROR_INVALIDDATA : 0;
+}
+
+static void write_par(AVIOContext *pb, const AVCodecParameters *par)
+{
+    avio_wb32(pb, par->codec_type);
+    avio_wb32(pb, par->codec_id);
+    avio_wb32(pb, par->codec_tag);
+    avio_wb32(pb, par->format);
+    avio_wb64(pb, par->bit_rate);
+    avio_wb32(pb, par->bits_per_coded_sample);
+    avio_wb32(pb, par->bits_per_raw_sample);
+    avio_wb32(pb, par->profile);
+    avio_wb32(pb, par->level);
+    avio_wb32(pb, par->width);
+    avio_wb32(pb, par->height);
+    write_q(pb, par->sample_aspect_ratio);
+    write_q(pb, par->framerate);
+    avio_wb32(pb, par->field_order);
+    avio_wb32(pb, par->color_range);
+    avio_wb32(pb, par->color_primaries);
+    avio_wb32(pb, par->color_trc);
+    avio_wb32(pb, par->color_space);
+    avio_wb32(pb, par->chroma_location);
+    avio_wb32(pb, par->video_delay);
+    avio_wb32(pb, par->sample_rate);
+    avio_wb32(pb, par->block_align);
+    avio_wb32(pb, par->frame_size);
+    avio_wb32(pb, par->initial_padding);
+    avio_wb32(pb, par->trailing_padding);
+    avio_wb32(pb, par->seek_preroll);
+    avio_wb32(pb, par->alpha_mode);
+
+    avio_wb32(pb, par->ch_layout.order);
+    avio_wb32(pb, par->ch_layout.nb_channels);
+    if (par->ch_layout.order == AV_CHANNEL_ORDER_CUSTOM) {
+        for (int i = 0; i < par->ch_layout.nb_channels; i++)
+            avio_wb32(pb, par->ch_layout.u.map[i].id);
+    } else
+        avio_wb64(pb, par->ch_layout.u.mask);
+
+    avio_wb32(pb, par->nb_coded_side_data);
+    for (int i = 0; i < par->nb_coded_side_data; i++) {
+        const AVPacketSideData *sd = &par->coded_side_data[i];
+        avio_wb32(pb, sd->type);
+        avio_wb32(pb, sd->size);
+        avio_write(pb, sd->data, sd->size);
+    }
+
+    avio_wb32(pb, par->extradata_size);
+    avio_write(pb, par->extradata, par->extradata_size);
+}
+
+static int read_cache(AVFormatContext *s, FFProbeCache *c, AVIOContext *pb)
+{
+    char name[64];
+    int nb_streams, ret;
+
+    if (avio_rb32(pb) != PROBE_CACHE_TAG || avio_rb32(pb) != PROBE_CACHE_VERSION)
+        return AVERROR_INVALIDDATA;
+    avio_get_str(pb, INT_MAX, name, sizeof(name));
+    if (strcmp(name, s->iformat->name))
+        return AVERROR(EINVAL);
+
+    nb_streams = avio_rb32(pb);
+    if (nb_streams <= 0 || nb_streams > MAX_STREAMS)
+        return AVERROR_INVALIDDATA;
+    if (!(c->streams = av_calloc(nb_streams, sizeof(*c->streams))))
+        return AVERROR(ENOMEM);
+    c->nb_streams = nb_streams;
+
+    for (int i = 0; i < nb_streams; i++) {
+        ProbeCacheStream *cst = &c->streams[i];
+
+        cst->id                   = avio_rb32(pb);
+        cst->avg_frame_rate       = read_q(pb);
+        cst->r_frame_rate         = read_q(pb);
+        cst->sample_aspect_ratio  = read_q(pb);
+        cst->codec_info_nb_frames = avio_rb32(pb);
+        if (!(cst->par = avcodec_parameters_alloc()))
+            return AVERROR(ENOMEM);
+        if ((ret = read_par(pb, cst->par)) < 0)
+            return ret;
+    }
+    return 0;
+}
+
+int ff_probe_cache_open(AVFormatContext *s)
+{
+    FormatContextInternal *const fci = ff_fc_internal(s);
+    char hex[2 * FF_FINGERPRINT_HASH_SIZE + 1];
+    FFProbeCache *c;
+    AVIOContext *pb;
+    int ret;
+
+    if (!s->probe_cache || !fci->fingerprint_size)
+        return 0;
+
+    if (!(c = av_mallocz(sizeof(*c))))
+        return AVERROR(ENOMEM);
+    fci->probe_cache = c;
+    ff_data_to_hex(hex, fci->fingerprint, FF_FINGERPRINT_HASH_SIZE, 1);
+    c->path = av_asprintf("%s/%s-%d.probe", s->probe_cache, hex,
+                          fci->fingerprint_size);
+    if (!c->path)
+        return AVERROR(ENOMEM);
+
+    ret = s->io_open(s, &pb, c->path, AVIO_FLAG_READ, NULL);
+    if (ret < 0) {
+        if (ret != AVERROR(ENOENT))
+            av_log(s, AV_LOG_WARNING, "Could not open probe cache '%s': %s\n",
+                   c->path, av_err2str(ret));
+        return 0;
+    }
+    ret = read_cache(s, c, pb);
+    ff_format_io_close(s, &pb);
+    if (ret < 0) {
+        free_streams(c);
+        if (ret == AVERROR(ENOMEM))
+            return ret;
+        av_log(s, AV_LOG_VERBOSE, "Ignoring probe cache '%s' %s\n", c->path,
+               ret == AVERROR(EINVAL) ? "written by another demuxer" : "which is invalid");
+        return 0;
+    }
+    av_log(s, AV_LOG_VERBOSE, "Using the parameters of %d streams cached in '%s'\n",
+           c->nb_streams, c->path);
+    return 0;
+}
+
+static int stream_matches(const AVStream *st, const ProbeCacheStream *cst)
+{
+    /* The codec id is not compared, as probing may refine it, e.g. from
+     * MP3 to MP2; it may even be unknown until the data is probed. */
+    return st->id == cst->id &&
+           (cffstream(st)->request_probe > 0 ||
+            st->codecpar->codec_type == AVMEDIA_TYPE_UNKNOWN ||
+            st->codecpar->codec_type == cst->par->codec_type);
+}
+
+int ff_probe_cache_apply(AVFormatContext *s)
+{
+    FFProbeCache *const c = ff_fc_internal(s)->probe_cache;
+
+    /* The streams of demuxers without a header show up while probing: wait for
+     * all of them, so that the cache is used either for every stream or for
+     * none, and an entry of another input never mixes with real probing. */
+    if (!c || !c->nb_streams || c->applied || s->nb_streams < c->nb_streams)
+        return 0;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        if (i >= c->nb_streams || !stream_matches(s->streams[i], &c->streams[i])) {
+            av_log(s, AV_LOG_VERBOSE, "Stream %d does not match the probe cache '%s', "
+                   "probing the streams\n", i, c->path);
+            free_streams(c);
+            return 0;
+        }
+    }
+    c->applied = 1;
+
+    for (int i = 0; i < c->nb_streams; i++) {
+        ProbeCacheStream *const cst = &c->streams[i];
+        AVStream *const st  = s->streams[i];
+        FFStream *const sti = ffstream(st);
+        AVCodecParameters *const par = st->codecpar;
+        AVPacketSideData *side_data;
+        int nb_side_data, ret;
+
+        /* keep the side data exported by the demuxer, and add the one
+         * found when probing */
+        side_data    = par->coded_side_data;
+        nb_side_data = par->nb_coded_side_data;
+        par->coded_side_data    = NULL;
+        par->nb_coded_side_data = 0;
+        ret = avcodec_parameters_copy(par, cst->par);
+        FFSWAP(AVPacketSideData *, par->coded_side_data, side_data);
+        FFSWAP(int, par->nb_coded_side_data, nb_side_data);
+        for (int j = 0; j < nb_side_data && ret >= 0; j++) {
+            const AVPacketSideData *sd = &side_data[j];
+            if (av_packet_side_data_get(par->coded_side_data, par->nb_coded_side_data,
+                                        sd->type))
+                continue;
+            if (!av_packet_side_data_new(&par->coded_side_data, &par->nb_coded_side_data,
+                                         sd->type, sd->size, 0))
+                ret = AVERROR(ENOMEM);
+            else
+                memcpy(par->coded_side_data[par->nb_coded_side_data - 1].data,
+                       sd->data, sd->size);
+        }
+        av_packet_side_data_free(&side_data, &nb_side_data);
+        if (ret < 0)
+            return ret;
+
+        if (cst->avg_frame_rate.num)
+            st->avg_frame_rate = cst->avg_frame_rate;
+        if (cst->r_frame_rate.num)
+            st->r_frame_rate = cst->r_frame_rate;
+        st->sample_aspect_ratio = cst->sample_aspect_ratio;
+
+        if (sti->request_probe > 0) {
+            av_freep(&sti->probe_data.buf);
+            sti->probe_data.buf_size = 0;
+            sti->request_probe = -1;
+        }
+        sti->need_context_update = 1;
+        sti->info->from_cache    = 1;
+    }
+    return 0;
+}
+
+int ff_probe_cache_complete(AVFormatContext *s)
+{
+    const FFProbeCache *c = ff_fc_internal(s)->probe_cache;
+
+    return c && c->applied && c->nb_streams == s->nb_streams;
+}
+
+static void write_cache(AVFormatContext *s, void *opaque, AVIOContext *pb)
+{
+    avio_wb32(pb, PROBE_CACHE_TAG);
+    avio_wb32(pb, PROBE_CACHE_VERSION);
+    avio_put_str(pb, s->iformat->name);
+    avio_wb32(pb, s->nb_streams);
+    for (int i = 0; i < s->nb_streams; i++) {
+        const AVStream *st = s->streams[i];
+
+        avio_wb32(pb, st->id);
+        write_q(pb, st->avg_frame_rate);
+        write_q(pb, st->r_frame_rate);
+        write_q(pb, st->sample_aspect_ratio);
+        avio_wb32(pb, cffstream(st)->codec_info_nb_frames);
+        write_par(pb, st->codecpar);
+    }
+}
+
+static int cacheable(const AVFormatContext *s)
+{
+    if (!s->nb_streams || s->nb_streams > MAX_STREAMS)
+        return 0;
+    for (int i = 0; i < s->nb_streams; i++) {
+        const AVCodecParameters *par = s->streams[i]->codecpar;
+        if ((par->codec_id == AV_CODEC_ID_NONE && par->codec_type != AVMEDIA_TYPE_DATA) ||
+            par->extradata_size > MAX_EXTRADATA_SIZE ||
+            par->ch_layout.nb_channels > 512)
+            return 0;
+    }
+    return 1;
+}
+
+void ff_probe_cache_close(AVFormatContext *s, int success)
+{
+    FormatContextInternal *const fci = ff_fc_internal(s);
+    FFProbeCache *c = fci->probe_cache;
+
+    if (!c)
+        return;
+
+    /* the stream selection prefers the streams with more probed frames */
+    for (int i = 0; i < FFMIN(c->nb_streams, s->nb_streams); i++) {
+        FFStream *const sti = ffstream(s->streams[i]);
+        if (sti->info && sti->info->from_cache)
+            sti->codec_info_nb_frames = FFMAX(sti->codec_info_nb_frames,
+                                              c->streams[i].codec_info_nb_frames);
+    }
+
+    if (success && !ff_probe_cache_complete(s) && cacheable(s))
+        ff_format_io_replace(s, c->path, "probe cache", write_cache, NULL);
+    ff_probe_cache_free(s);
+}
+
+void ff_probe_cache_free(AVFormatContext *s)
+{
+    FormatContextInternal *const fci = ff_fc_internal(s);
+
+    if (!fci->probe_cache)
+        return;
+    free_streams(fci->probe_cache);
+    av_freep(&fci->probe_cache->path);
+    av_freep(&fci->probe_cache);
+}
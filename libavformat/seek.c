@@ -618,6 +618,8 @@ static int seek_frame_internal(AVFormatContext *s, int stream_index,
                                AV_TIME_BASE * (int64_t) st->time_base.num);
     }
 
+    ff_index_cache_apply(s);
+
     /* first, we try the format specific seek */
     if (ffifmt(s->iformat)->read_seek) {
         ff_read_frame_flush(s);
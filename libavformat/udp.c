@@ -26,6 +26,9 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     /* Needed for recvmmsg() */
+#endif
 
 #include "avformat.h"
 #include "libavutil/avassert.h"
@@ -78,6 +81,7 @@
 #define UDP_RX_BUF_SIZE 393216
 #define UDP_MAX_PKT_SIZE 65536
 #define UDP_HEADER_SIZE 8
+#define UDP_RX_BATCH_SIZE (HAVE_RECVMMSG && HAVE_PTHREAD_CANCEL ? 16 : 1)
 
 typedef struct UDPQueuedPacketHeader {
     int pkt_size;
@@ -115,6 +119,14 @@ typedef struct UDPContext {
     pthread_cond_t cond;
     int thread_started;
 #endif
+#if HAVE_RECVMMSG
+    struct mmsghdr *rx_msgs;
+    struct iovec *rx_iov;
+    uint8_t *rx_batch_buf;
+#endif
+    int batch_size;
+    int64_t rx_batches;
+    int64_t rx_batch_packets;
     uint8_t tmp[UDP_MAX_PKT_SIZE + sizeof(UDPQueuedPacketHeader)];
     int remaining_in_dg;
     char *localaddr;
@@ -148,6 +160,7 @@ static const AVOption options[] = {
     { "connect",        "set if connect() should be called on socket",     OFFSET(is_connected),   AV_OPT_TYPE_BOOL,   { .i64 =  0 },     0, 1,       .flags = D|E },
     { "fifo_size",      "set the UDP circular buffer size (in 188-byte packets)", OFFSET(circular_buffer_size), AV_OPT_TYPE_INT, {.i64 = HAVE_PTHREAD_CANCEL ? 7*4096 : 0}, 0, INT_MAX, D },
     { "overrun_nonfatal", "survive in case of UDP receiving circular buffer overrun", OFFSET(overrun_nonfatal), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1,    D },
+    { "batch_size",     "set maximum number of datagrams received per system call by the circular buffer thread", OFFSET(batch_size), AV_OPT_TYPE_INT, {.i64 = UDP_RX_BATCH_SIZE}, 1, 1024, D },
     { "timeout",        "set raise error timeout, in microseconds (only in read mode)",OFFSET(timeout),         AV_OPT_TYPE_INT,  {.i64 = 0}, 0, INT_MAX, D },
     { "sources",        "Source list",                                     OFFSET(sources),        AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "block",          "Block list",                                      OFFSET(block),          AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
@@ -526,11 +539,88 @@ static int udp_get_file_handle(URLContext *h)
 }
 
 #if HAVE_PTHREAD_CANCEL
+/**
+ * Queue a received datagram into the circular buffer.
+ * Must be called with the mutex held.
+ *
+ * @param buf datagram payload, preceded by room for the packet header
+ * @return 0 on success or if the datagram was dropped, a negative error
+ *         code if the receiving thread must stop
+ */
+static int circular_buffer_queue_rx(URLContext *h, UDPQueuedPacketHeader *pkt_header,
+                                    uint8_t *buf)
+{
+    UDPContext *s = h->priv_data;
+
+    if (ff_ip_check_source_lists(&pkt_header->addr, &s->filters))
+        return 0;
+    memcpy(buf, pkt_header, sizeof(*pkt_header));
+
+    if (av_fifo_can_write(s->rx_fifo) < pkt_header->pkt_size + sizeof(*pkt_header)) {
+        /* No Space left */
+        if (s->overrun_nonfatal) {
+            av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
+                    "Surviving due to overrun_nonfatal option\n");
+            return 0;
+        } else {
+            av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
+                    "To avoid, increase fifo_size URL option. "
+                    "To survive in such case, use overrun_nonfatal option\n");
+            return AVERROR(EIO);
+        }
+    }
+    av_fifo_write(s->rx_fifo, buf, pkt_header->pkt_size + sizeof(*pkt_header));
+    return 0;
+}
+
+#if HAVE_RECVMMSG
+static int circular_buffer_alloc_rx_batch(UDPContext *s)
+{
+    s->rx_msgs      = av_calloc(s->batch_size, sizeof(*s->rx_msgs));
+    s->rx_iov       = av_calloc(s->batch_size, sizeof(*s->rx_iov));
+    s->rx_batch_buf = av_malloc_array(s->batch_size, sizeof(s->tmp));
+    if (!s->rx_msgs || !s->rx_iov || !s->rx_batch_buf)
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
+static void circular_buffer_free_rx_batch(UDPContext *s)
+{
+    av_freep(&s->rx_msgs);
+    av_freep(&s->rx_iov);
+    av_freep(&s->rx_batch_buf);
+}
+
+/**
+ * Receive up to batch_size datagrams with a single recvmmsg() call.
+ * Blocks until at least one datagram is available.
+ */
+static int circular_buffer_recv_batch(UDPContext *s, UDPQueuedPacketHeader *hdr)
+{
+    for (int i = 0; i < s->batch_size; i++) {
+        uint8_t *slot = s->rx_batch_buf + i * sizeof(s->tmp);
+
+        s->rx_iov[i].iov_base = slot + sizeof(*hdr);
+        s->rx_iov[i].iov_len  = sizeof(s->tmp) - sizeof(*hdr);
+        s->rx_msgs[i].msg_hdr = (struct msghdr) {
+            .msg_name    = &hdr[i].addr,
+            .msg_namelen = sizeof(hdr[i].addr),
+            .msg_iov     = &s->rx_iov[i],
+            .msg_iovlen  = 1,
+        };
+    }
+    return recvmmsg(s->udp_fd, s->rx_msgs, s->batch_size, MSG_WAITFORONE, NULL);
+}
+#endif
+
 static void *circular_buffer_task_rx( void *_URLContext)
 {
     URLContext *h = _URLContext;
     UDPContext *s = h->priv_data;
     int old_cancelstate;
+#if HAVE_RECVMMSG
+    UDPQueuedPacketHeader *batch_hdr = NULL;
+#endif
 
     ff_thread_setname("udp-rx");
 
@@ -541,8 +631,18 @@ static void *circular_buffer_task_rx( void *_URLContext)
         s->circular_buffer_error = AVERROR(EIO);
         goto end;
     }
+#if HAVE_RECVMMSG
+    if (s->rx_batch_buf) {
+        batch_hdr = av_calloc(s->batch_size, sizeof(*batch_hdr));
+        if (!batch_hdr) {
+            s->circular_buffer_error = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+#endif
     while(1) {
         UDPQueuedPacketHeader pkt_header;
+        int ret = 0, nb_pkts = 1;
         pkt_header.addr_len = sizeof(pkt_header.addr);
 
         pthread_mutex_unlock(&s->mutex);
@@ -550,41 +650,49 @@ static void *circular_buffer_task_rx( void *_URLContext)
            see "General Information" / "Thread Cancellation Overview"
            in Single Unix. */
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
-        pkt_header.pkt_size = recvfrom(s->udp_fd, s->tmp + sizeof(pkt_header), sizeof(s->tmp) - sizeof(pkt_header), 0, (struct sockaddr *)&pkt_header.addr, &pkt_header.addr_len);
+#if HAVE_RECVMMSG
+        if (batch_hdr)
+            ret = nb_pkts = circular_buffer_recv_batch(s, batch_hdr);
+        else
+#endif
+        ret = pkt_header.pkt_size = recvfrom(s->udp_fd, s->tmp + sizeof(pkt_header), sizeof(s->tmp) - sizeof(pkt_header), 0, (struct sockaddr *)&pkt_header.addr, &pkt_header.addr_len);
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
         pthread_mutex_lock(&s->mutex);
-        if (pkt_header.pkt_size < 0) {
+        if (ret < 0) {
             if (ff_neterrno() != AVERROR(EAGAIN) && ff_neterrno() != AVERROR(EINTR)) {
                 s->circular_buffer_error = ff_neterrno();
                 goto end;
             }
             continue;
         }
-        if (ff_ip_check_source_lists(&pkt_header.addr, &s->filters))
-            continue;
-        memcpy(s->tmp, &pkt_header, sizeof(pkt_header));
-
-        if (av_fifo_can_write(s->rx_fifo) < pkt_header.pkt_size + sizeof(pkt_header)) {
-            /* No Space left */
-            if (s->overrun_nonfatal) {
-                av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
-                        "Surviving due to overrun_nonfatal option\n");
-                continue;
-            } else {
-                av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
-                        "To avoid, increase fifo_size URL option. "
-                        "To survive in such case, use overrun_nonfatal option\n");
-                s->circular_buffer_error = AVERROR(EIO);
-                goto end;
+#if HAVE_RECVMMSG
+        if (batch_hdr) {
+            for (int i = 0; i < nb_pkts; i++) {
+                batch_hdr[i].pkt_size = s->rx_msgs[i].msg_len;
+                batch_hdr[i].addr_len = s->rx_msgs[i].msg_hdr.msg_namelen;
+                ret = circular_buffer_queue_rx(h, &batch_hdr[i],
+                                               s->rx_batch_buf + i * sizeof(s->tmp));
+                if (ret < 0)
+                    break;
             }
+        } else
+#endif
+        ret = circular_buffer_queue_rx(h, &pkt_header, s->tmp);
+        if (ret < 0) {
+            s->circular_buffer_error = ret;
+            goto end;
         }
-        av_fifo_write(s->rx_fifo, s->tmp, pkt_header.pkt_size + sizeof(pkt_header));
+        s->rx_batches++;
+        s->rx_batch_packets += nb_pkts;
         pthread_cond_signal(&s->cond);
     }
 
 end:
     pthread_cond_signal(&s->cond);
     pthread_mutex_unlock(&s->mutex);
+#if HAVE_RECVMMSG
+    av_free(batch_hdr);
+#endif
     return NULL;
 }
 
@@ -926,6 +1034,15 @@ static int udp_open(URLContext *h, const char *uri, int flags)
             s->tx_fifo = fifo;
         else
             s->rx_fifo = fifo;
+        if (is_output || !HAVE_RECVMMSG)
+            s->batch_size = 1;
+#if HAVE_RECVMMSG
+        if (s->batch_size > 1) {
+            ret = circular_buffer_alloc_rx_batch(s);
+            if (ret < 0)
+                goto fail;
+        }
+#endif
         ret = pthread_mutex_init(&s->mutex, NULL);
         if (ret != 0) {
             av_log(h, AV_LOG_ERROR, "pthread_mutex_init failed : %s\n", strerror(ret));
@@ -960,6 +1077,9 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         closesocket(udp_fd);
     av_fifo_freep2(&s->rx_fifo);
     av_fifo_freep2(&s->tx_fifo);
+#if HAVE_PTHREAD_CANCEL && HAVE_RECVMMSG
+    circular_buffer_free_rx_batch(s);
+#endif
     ff_ip_reset_filters(&s->filters);
     return ret;
 }
@@ -1128,11 +1248,20 @@ static int udp_close(URLContext *h)
             av_log(h, AV_LOG_ERROR, "pthread_join(): %s\n", strerror(ret));
         pthread_mutex_destroy(&s->mutex);
         pthread_cond_destroy(&s->cond);
+        if (s->rx_batches)
+            av_log(h, AV_LOG_VERBOSE, "Received %"PRId64" datagrams in %"PRId64" "
+                   "system calls (average batch fill %.1f/%d)\n",
+                   s->rx_batch_packets, s->rx_batches,
+                   (double)s->rx_batch_packets / s->rx_batches,
+                   s->batch_size);
     }
 #endif
     closesocket(s->udp_fd);
     av_fifo_freep2(&s->rx_fifo);
     av_fifo_freep2(&s->tx_fifo);
+#if HAVE_PTHREAD_CANCEL && HAVE_RECVMMSG
+    circular_buffer_free_rx_batch(s);
+#endif
     ff_ip_reset_filters(&s->filters);
     return 0;
 }
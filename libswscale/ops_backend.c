@@ -55,7 +55,68 @@ static const SwsOpTable *const tables[] = {
     &bitfn(op_table_float, f32),
 };
 
-static int compile(SwsContext *ctx, SwsOpList *ops, SwsCompiledOp *out)
+/* Kernels fusing two adjacent ops, see compile_fused() */
+static const SwsOpTable *const tables_read_f32[] = {
+    &bitfn(op_table_read_f32,  u8),
+    &bitfn(op_table_read_f32, u16),
+    &bitfn(op_table_read_f32, u32),
+};
+
+static const SwsOpTable *const tables_write_f32[] = {
+    &bitfn(op_table_write_f32,  u8),
+    &bitfn(op_table_write_f32, u16),
+    &bitfn(op_table_write_f32, u32),
+};
+
+static const SwsOpTable *const tables_linear_dither[] = {
+    &bitfn(op_table_linear_dither, f32),
+};
+
+/**
+ * Try to compile the first two ops of `ops` into a single fused kernel.
+ * Returns AVERROR(ENOTSUP) if they can not be fused.
+ */
+static int compile_fused(SwsOpList *ops, SwsOpChain *chain)
+{
+    const SwsOp *op0 = &ops->ops[0], *op1 = &ops->ops[1];
+    SwsOpList tmp = *ops;
+    int ret;
+
+    if (ops->num_ops < 2)
+        return AVERROR(ENOTSUP);
+
+    if (op0->op == SWS_OP_READ && op1->op == SWS_OP_CONVERT &&
+        op1->convert.to == SWS_PIXEL_F32 && !op1->convert.expand) {
+        ret = ff_sws_op_compile_tables(tables_read_f32,
+                                       FF_ARRAY_ELEMS(tables_read_f32),
+                                       &tmp, SWS_BLOCK_SIZE, chain);
+    } else if (op0->op == SWS_OP_CONVERT && op1->op == SWS_OP_WRITE &&
+               op0->type == SWS_PIXEL_F32 && op0->convert.to == op1->type &&
+               !op0->convert.expand) {
+        tmp.ops++;
+        tmp.num_ops--;
+        ret = ff_sws_op_compile_tables(tables_write_f32,
+                                       FF_ARRAY_ELEMS(tables_write_f32),
+                                       &tmp, SWS_BLOCK_SIZE, chain);
+    } else if (op0->op == SWS_OP_LINEAR && op1->op == SWS_OP_DITHER) {
+        /* The setup of these kernels also reads the dither op from `tmp` */
+        ret = ff_sws_op_compile_tables(tables_linear_dither,
+                                       FF_ARRAY_ELEMS(tables_linear_dither),
+                                       &tmp, SWS_BLOCK_SIZE, chain);
+    } else {
+        return AVERROR(ENOTSUP);
+    }
+
+    if (ret < 0 && ret != AVERROR(EAGAIN))
+        return ret;
+
+    ops->ops     += 2;
+    ops->num_ops -= 2;
+    return ops->num_ops ? AVERROR(EAGAIN) : 0;
+}
+
+static int compile_chain(SwsContext *ctx, SwsOpList *ops, SwsCompiledOp *out,
+                         const bool fuse)
 {
     int ret;
 
@@ -69,8 +130,10 @@ static int compile(SwsContext *ctx, SwsOpList *ops, SwsCompiledOp *out)
     /* Make on-stack copy of `ops` to iterate over */
     SwsOpList rest = *ops;
     do {
-        ret = ff_sws_op_compile_tables(tables, FF_ARRAY_ELEMS(tables), &rest,
-                                       SWS_BLOCK_SIZE, chain);
+        ret = fuse ? compile_fused(&rest, chain) : AVERROR(ENOTSUP);
+        if (ret == AVERROR(ENOTSUP))
+            ret = ff_sws_op_compile_tables(tables, FF_ARRAY_ELEMS(tables), &rest,
+                                           SWS_BLOCK_SIZE, chain);
     } while (ret == AVERROR(EAGAIN));
 
     if (ret < 0) {
@@ -101,8 +164,25 @@ static int compile(SwsContext *ctx, SwsOpList *ops, SwsCompiledOp *out)
     return 0;
 }
 
+static int compile(SwsContext *ctx, SwsOpList *ops, SwsCompiledOp *out)
+{
+    return compile_chain(ctx, ops, out, true);
+}
+
+static int compile_unfused(SwsContext *ctx, SwsOpList *ops, SwsCompiledOp *out)
+{
+    return compile_chain(ctx, ops, out, false);
+}
+
 const SwsOpBackend backend_c = {
     .name       = "c",
     .compile    = compile,
     .hw_format  = AV_PIX_FMT_NONE,
 };
+
+/* One kernel per op; not in ff_sws_op_backends, used to test the fused kernels */
+const SwsOpBackend backend_c_unfused = {
+    .name       = "c_unfused",
+    .compile    = compile_unfused,
+    .hw_format  = AV_PIX_FMT_NONE,
+};
@@ -139,6 +139,14 @@ DECL_SETUP(setup_linear)
     return SETUP_MEMDUP(c);
 }
 
+/* Computes component I of the linear transformation `c`, `mask` into VAR */
+#define LINEAR_COMP(VAR, I, XX, YY, ZZ, WW)                                     \
+    VAR  = (mask & SWS_MASK_OFF(I)) ? c.k[I] : 0;                               \
+    VAR += (mask & SWS_MASK(I, 0))  ? c.m[I][0] * XX : (I == 0) ? XX : 0;       \
+    VAR += (mask & SWS_MASK(I, 1))  ? c.m[I][1] * YY : (I == 1) ? YY : 0;       \
+    VAR += (mask & SWS_MASK(I, 2))  ? c.m[I][2] * ZZ : (I == 2) ? ZZ : 0;       \
+    VAR += (mask & SWS_MASK(I, 3))  ? c.m[I][3] * WW : (I == 3) ? WW : 0;
+
 /**
  * Fully general case for a 5x5 linear affine transformation. Should never be
  * called without constant `mask`. This function will compile down to the
@@ -156,29 +164,10 @@ DECL_FUNC(linear_mask, const uint32_t mask)
         const pixel_t zz = z[i];
         const pixel_t ww = w[i];
 
-        x[i]  = (mask & SWS_MASK_OFF(0)) ? c.k[0] : 0;
-        x[i] += (mask & SWS_MASK(0, 0))  ? c.m[0][0] * xx : xx;
-        x[i] += (mask & SWS_MASK(0, 1))  ? c.m[0][1] * yy : 0;
-        x[i] += (mask & SWS_MASK(0, 2))  ? c.m[0][2] * zz : 0;
-        x[i] += (mask & SWS_MASK(0, 3))  ? c.m[0][3] * ww : 0;
-
-        y[i]  = (mask & SWS_MASK_OFF(1)) ? c.k[1] : 0;
-        y[i] += (mask & SWS_MASK(1, 0))  ? c.m[1][0] * xx : 0;
-        y[i] += (mask & SWS_MASK(1, 1))  ? c.m[1][1] * yy : yy;
-        y[i] += (mask & SWS_MASK(1, 2))  ? c.m[1][2] * zz : 0;
-        y[i] += (mask & SWS_MASK(1, 3))  ? c.m[1][3] * ww : 0;
-
-        z[i]  = (mask & SWS_MASK_OFF(2)) ? c.k[2] : 0;
-        z[i] += (mask & SWS_MASK(2, 0))  ? c.m[2][0] * xx : 0;
-        z[i] += (mask & SWS_MASK(2, 1))  ? c.m[2][1] * yy : 0;
-        z[i] += (mask & SWS_MASK(2, 2))  ? c.m[2][2] * zz : zz;
-        z[i] += (mask & SWS_MASK(2, 3))  ? c.m[2][3] * ww : 0;
-
-        w[i]  = (mask & SWS_MASK_OFF(3)) ? c.k[3] : 0;
-        w[i] += (mask & SWS_MASK(3, 0))  ? c.m[3][0] * xx : 0;
-        w[i] += (mask & SWS_MASK(3, 1))  ? c.m[3][1] * yy : 0;
-        w[i] += (mask & SWS_MASK(3, 2))  ? c.m[3][2] * zz : 0;
-        w[i] += (mask & SWS_MASK(3, 3))  ? c.m[3][3] * ww : ww;
+        LINEAR_COMP(x[i], 0, xx, yy, zz, ww)
+        LINEAR_COMP(y[i], 1, xx, yy, zz, ww)
+        LINEAR_COMP(z[i], 2, xx, yy, zz, ww)
+        LINEAR_COMP(w[i], 3, xx, yy, zz, ww)
     }
 
     CONTINUE(block_t, x, y, z, w);
@@ -212,6 +201,124 @@ WRAP_LINEAR(affine3a,  SWS_MASK_MAT3 | SWS_MASK_OFF3 | SWS_MASK_ALPHA)
 WRAP_LINEAR(matrix4,   SWS_MASK_MAT4)
 WRAP_LINEAR(affine4,   SWS_MASK_MAT4 | SWS_MASK_OFF4)
 
+/**
+ * Linear transformation fused with the dither that follows it, so that the
+ * dither is added while the transformed pixels are still in registers.
+ */
+typedef struct {
+    fn(LinCoeffs) lin;
+    int8_t offset[4];
+    int size_log2;
+    /* Dither matrix padded to the block size, followed by a row of zeros for
+     * the components that are not dithered */
+    pixel_t matrix[];
+} fn(LinDither);
+
+/* Takes the linear op; the dither op is the next one in the list */
+DECL_SETUP(setup_linear_dither)
+{
+    const SwsDitherOp *dither = &op[1].dither;
+    const int size  = 1 << dither->size_log2;
+    const int width = FFMAX(size, SWS_BLOCK_SIZE);
+    fn(LinDither) *ld;
+
+    av_assert1(op[1].op == SWS_OP_DITHER);
+    ld = out->ptr = av_mallocz(sizeof(*ld) + sizeof(pixel_t) * (size + 1) * width);
+    if (!ld)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++)
+            ld->lin.m[i][j] = av_q2pixel(op->lin.m[i][j]);
+        ld->lin.k[i] = av_q2pixel(op->lin.m[i][4]);
+        ld->offset[i] = dither->y_offset[i];
+    }
+
+    ld->size_log2 = dither->size_log2;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < width; x++)
+            ld->matrix[y * width + x] = av_q2pixel(dither->matrix[y * size + (x % size)]);
+    }
+
+    return 0;
+}
+
+DECL_FUNC(linear_dither_mask, const uint32_t mask)
+{
+    const fn(LinDither) *restrict ld = impl->priv.ptr;
+    const fn(LinCoeffs) c = ld->lin;
+    const int size  = 1 << ld->size_log2;
+    const int width = FFMAX(size, SWS_BLOCK_SIZE);
+    const int base  = iter->x & ~(SWS_BLOCK_SIZE - 1) & (size - 1);
+    const pixel_t *restrict zero = &ld->matrix[size * width];
+    const pixel_t *restrict d[4];
+
+    for (int n = 0; n < 4; n++) {
+        const int row = (iter->y + ld->offset[n]) & (size - 1);
+        d[n] = ld->offset[n] >= 0 ? &ld->matrix[row * width + base] : zero;
+    }
+
+    SWS_LOOP
+    for (int i = 0; i < SWS_BLOCK_SIZE; i++) {
+        const pixel_t xx = x[i];
+        const pixel_t yy = y[i];
+        const pixel_t zz = z[i];
+        const pixel_t ww = w[i];
+        pixel_t xv, yv, zv, wv;
+
+        LINEAR_COMP(xv, 0, xx, yy, zz, ww)
+        LINEAR_COMP(yv, 1, xx, yy, zz, ww)
+        LINEAR_COMP(zv, 2, xx, yy, zz, ww)
+        LINEAR_COMP(wv, 3, xx, yy, zz, ww)
+
+        x[i] = xv + d[0][i];
+        y[i] = yv + d[1][i];
+        z[i] = zv + d[2][i];
+        w[i] = wv + d[3][i];
+    }
+
+    CONTINUE(block_t, x, y, z, w);
+}
+
+#define WRAP_LINEAR_DITHER(NAME, MASK)                                          \
+DECL_IMPL(linear_dither_##NAME)                                                 \
+{                                                                               \
+    CALL(linear_dither_mask, MASK);                                             \
+}                                                                               \
+                                                                                \
+DECL_ENTRY(linear_dither_##NAME,                                                \
+    .op    = SWS_OP_LINEAR,                                                     \
+    .setup = fn(setup_linear_dither),                                           \
+    .free  = av_free,                                                           \
+    .linear_mask = (MASK),                                                      \
+);
+
+/* The linear ops most commonly followed by a dither */
+WRAP_LINEAR_DITHER(luma,      SWS_MASK_LUMA)
+WRAP_LINEAR_DITHER(lumalpha,  SWS_MASK_LUMA | SWS_MASK_ALPHA)
+WRAP_LINEAR_DITHER(dot3,      0x7)
+WRAP_LINEAR_DITHER(row0,      SWS_MASK_ROW(0))
+WRAP_LINEAR_DITHER(row0a,     SWS_MASK_ROW(0) | SWS_MASK_ALPHA)
+WRAP_LINEAR_DITHER(diag3,     SWS_MASK_DIAG3)
+WRAP_LINEAR_DITHER(affine3,   SWS_MASK_MAT3 | SWS_MASK_OFF3)
+WRAP_LINEAR_DITHER(affine3a,  SWS_MASK_MAT3 | SWS_MASK_OFF3 | SWS_MASK_ALPHA)
+
+/* Matched against the linear op of a linear + dither pair */
+static const SwsOpTable fn(op_table_linear_dither) = {
+    .block_size = SWS_BLOCK_SIZE,
+    .entries = {
+        &fn(op_linear_dither_luma),
+        &fn(op_linear_dither_lumalpha),
+        &fn(op_linear_dither_dot3),
+        &fn(op_linear_dither_row0),
+        &fn(op_linear_dither_row0a),
+        &fn(op_linear_dither_diag3),
+        &fn(op_linear_dither_affine3),
+        &fn(op_linear_dither_affine3a),
+        NULL
+    },
+};
+
 static const SwsOpTable fn(op_table_float) = {
     .block_size = SWS_BLOCK_SIZE,
     .entries = {
@@ -20,6 +20,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/bswap.h"
+#include "libavutil/mem_internal.h"
 
 #include "ops_backend.h"
 
@@ -166,6 +167,143 @@ WRAP_WRITE(write_packed, 2, 0, true)
 WRAP_WRITE(write_packed, 3, 0, true)
 WRAP_WRITE(write_packed, 4, 0, true)
 
+/**
+ * Fused kernels for a read followed by a conversion to float, and for a
+ * conversion from float followed by a write. The pixels are converted as they
+ * are loaded or stored, without an integer block in between.
+ */
+#define DECL_READ_FLOAT(FUNC, ELEMS, PACKED)                                    \
+static SWS_FUNC void fn(FUNC##ELEMS##_f32)(SwsOpIter *restrict iter,            \
+                                           const SwsOpImpl *restrict impl,      \
+                                           block_t x, block_t y,                \
+                                           block_t z, block_t w)                \
+{                                                                               \
+    const pixel_t *restrict in0 = (const pixel_t *) iter->in[0];                \
+    const pixel_t *restrict in1 = (const pixel_t *) iter->in[1];                \
+    const pixel_t *restrict in2 = (const pixel_t *) iter->in[2];                \
+    const pixel_t *restrict in3 = (const pixel_t *) iter->in[3];                \
+    DECLARE_ALIGNED_64(f32block_t, xf);                                         \
+    DECLARE_ALIGNED_64(f32block_t, yf);                                         \
+    DECLARE_ALIGNED_64(f32block_t, zf);                                         \
+    DECLARE_ALIGNED_64(f32block_t, wf);                                         \
+                                                                                \
+    SWS_LOOP                                                                    \
+    for (int i = 0; i < SWS_BLOCK_SIZE; i++) {                                  \
+        xf[i] = PACKED ? in0[ELEMS * i + 0] : in0[i];                           \
+        if (ELEMS > 1)                                                          \
+            yf[i] = PACKED ? in0[ELEMS * i + 1] : in1[i];                       \
+        if (ELEMS > 2)                                                          \
+            zf[i] = PACKED ? in0[ELEMS * i + 2] : in2[i];                       \
+        if (ELEMS > 3)                                                          \
+            wf[i] = PACKED ? in0[ELEMS * i + 3] : in3[i];                       \
+    }                                                                           \
+                                                                                \
+    CONTINUE(f32block_t, xf, yf, zf, wf);                                       \
+    for (int i = 0; i < (PACKED ? 1 : ELEMS); i++)                              \
+        iter->in[i] += sizeof(block_t) * (PACKED ? ELEMS : 1);                  \
+}                                                                               \
+                                                                                \
+DECL_ENTRY(FUNC##ELEMS##_f32,                                                   \
+    .op = SWS_OP_READ,                                                          \
+    .rw = {                                                                     \
+        .elems  = ELEMS,                                                        \
+        .packed = PACKED,                                                       \
+    },                                                                          \
+);
+
+#define DECL_WRITE_FLOAT(FUNC, ELEMS, PACKED)                                   \
+static SWS_FUNC void fn(FUNC##ELEMS##_f32)(SwsOpIter *restrict iter,            \
+                                           const SwsOpImpl *restrict impl,      \
+                                           f32block_t x, f32block_t y,          \
+                                           f32block_t z, f32block_t w)          \
+{                                                                               \
+    pixel_t *restrict out0 = (pixel_t *) iter->out[0];                          \
+    pixel_t *restrict out1 = (pixel_t *) iter->out[1];                          \
+    pixel_t *restrict out2 = (pixel_t *) iter->out[2];                          \
+    pixel_t *restrict out3 = (pixel_t *) iter->out[3];                          \
+                                                                                \
+    if (PACKED) {                                                               \
+        SWS_LOOP                                                                \
+        for (int i = 0; i < SWS_BLOCK_SIZE; i++) {                              \
+            out0[ELEMS * i + 0] = x[i];                                         \
+            if (ELEMS > 1)                                                      \
+                out0[ELEMS * i + 1] = y[i];                                     \
+            if (ELEMS > 2)                                                      \
+                out0[ELEMS * i + 2] = z[i];                                     \
+            if (ELEMS > 3)                                                      \
+                out0[ELEMS * i + 3] = w[i];                                     \
+        }                                                                       \
+    } else {                                                                    \
+        SWS_LOOP                                                                \
+        for (int i = 0; i < SWS_BLOCK_SIZE; i++) {                              \
+            out0[i] = x[i];                                                     \
+            if (ELEMS > 1)                                                      \
+                out1[i] = y[i];                                                 \
+            if (ELEMS > 2)                                                      \
+                out2[i] = z[i];                                                 \
+            if (ELEMS > 3)                                                      \
+                out3[i] = w[i];                                                 \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    for (int i = 0; i < (PACKED ? 1 : ELEMS); i++)                              \
+        iter->out[i] += sizeof(block_t) * (PACKED ? ELEMS : 1);                 \
+}                                                                               \
+                                                                                \
+DECL_ENTRY(FUNC##ELEMS##_f32,                                                   \
+    .op = SWS_OP_WRITE,                                                         \
+    .rw = {                                                                     \
+        .elems  = ELEMS,                                                        \
+        .packed = PACKED,                                                       \
+    },                                                                          \
+);
+
+DECL_READ_FLOAT(read_planar, 1, false)
+DECL_READ_FLOAT(read_planar, 2, false)
+DECL_READ_FLOAT(read_planar, 3, false)
+DECL_READ_FLOAT(read_planar, 4, false)
+DECL_READ_FLOAT(read_packed, 2, true)
+DECL_READ_FLOAT(read_packed, 3, true)
+DECL_READ_FLOAT(read_packed, 4, true)
+
+DECL_WRITE_FLOAT(write_planar, 1, false)
+DECL_WRITE_FLOAT(write_planar, 2, false)
+DECL_WRITE_FLOAT(write_planar, 3, false)
+DECL_WRITE_FLOAT(write_planar, 4, false)
+DECL_WRITE_FLOAT(write_packed, 2, true)
+DECL_WRITE_FLOAT(write_packed, 3, true)
+DECL_WRITE_FLOAT(write_packed, 4, true)
+
+/* Matched against the read op of a read + convert to float pair */
+static const SwsOpTable fn(op_table_read_f32) = {
+    .block_size = SWS_BLOCK_SIZE,
+    .entries = {
+        &fn(op_read_planar1_f32),
+        &fn(op_read_planar2_f32),
+        &fn(op_read_planar3_f32),
+        &fn(op_read_planar4_f32),
+        &fn(op_read_packed2_f32),
+        &fn(op_read_packed3_f32),
+        &fn(op_read_packed4_f32),
+        NULL
+    },
+};
+
+/* Matched against the write op of a convert from float + write pair */
+static const SwsOpTable fn(op_table_write_f32) = {
+    .block_size = SWS_BLOCK_SIZE,
+    .entries = {
+        &fn(op_write_planar1_f32),
+        &fn(op_write_planar2_f32),
+        &fn(op_write_planar3_f32),
+        &fn(op_write_planar4_f32),
+        &fn(op_write_packed2_f32),
+        &fn(op_write_packed3_f32),
+        &fn(op_write_packed4_f32),
+        NULL
+    },
+};
+
 #if BIT_DEPTH == 8
 DECL_READ(read_nibbles, const int elems)
 {
@@ -0,0 +1,223 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Runs the op list of every format conversion through the C backend, once
+ * with its fused kernels and once with one kernel per op, and checks that
+ * both give the same output.
+ */
+
+#include <string.h>
+
+#include "libavutil/bswap.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/format.h"
+#include "libswscale/ops.h"
+#include "libswscale/ops_dispatch.h"
+#include "libswscale/ops_internal.h"
+
+extern const SwsOpBackend backend_c;
+extern const SwsOpBackend backend_c_unfused;
+
+enum {
+    LINES     = 4,
+    PIXELS    = 64,
+    LINE_SIZE = PIXELS * 16, /* up to 4 components of 4 bytes each */
+};
+
+typedef uint8_t Planes[4][LINES][LINE_SIZE];
+
+static DECLARE_ALIGNED_64(Planes, src_planes);
+static DECLARE_ALIGNED_64(Planes, dst_planes)[2];
+
+static int rw_pixel_bits(const SwsOp *op)
+{
+    const int elems = op->rw.packed ? op->rw.elems : 1;
+    const int size  = ff_sws_pixel_type_size(op->type);
+    const int bits  = 8 >> op->rw.frac;
+    return elems * size * bits;
+}
+
+/* Fills the input with random pixels within the range the op list expects */
+static void fill_src(AVLFG *lfg, const SwsOp *read)
+{
+    const int planes = read->rw.packed ? 1 : read->rw.elems;
+    const int elems  = read->rw.packed ? read->rw.elems : 1;
+    const int size   = ff_sws_pixel_type_size(read->type);
+
+    for (int p = 0; p < planes; p++) {
+        for (int y = 0; y < LINES; y++) {
+            uint8_t *line = src_planes[p][y];
+
+            if (read->rw.frac) {
+                for (int i = 0; i < LINE_SIZE; i++)
+                    line[i] = av_lfg_get(lfg);
+                continue;
+            }
+
+            for (int i = 0; i < PIXELS * elems; i++) {
+                const int c = read->rw.packed ? i % elems : p;
+                const unsigned flags = read->comps.flags[c];
+                const AVRational max = read->comps.max[c];
+                const double range = (flags & SWS_COMP_GARBAGE) || !max.den ? 0 : av_q2d(max);
+                uint32_t v = av_lfg_get(lfg);
+
+                if (read->type == SWS_PIXEL_F32) {
+                    const float f = (range ? range : 1.0) * v / UINT32_MAX;
+                    memcpy(&v, &f, sizeof(v));
+                } else if (range > 0 && range < UINT32_MAX) {
+                    v %= (uint32_t) range + 1;
+                }
+
+                switch (size) {
+                case 1: line[i] = v; break;
+                case 2: ((uint16_t *) line)[i] = (flags & SWS_COMP_SWAPPED) ? av_bswap16(v) : v; break;
+                case 4: ((uint32_t *) line)[i] = (flags & SWS_COMP_SWAPPED) ? av_bswap32(v) : v; break;
+                }
+            }
+        }
+    }
+}
+
+static void run(const SwsCompiledOp *comp, const SwsOp *read, const SwsOp *write,
+                Planes out)
+{
+    const int read_size  = PIXELS * rw_pixel_bits(read)  >> 3;
+    const int write_size = PIXELS * rw_pixel_bits(write) >> 3;
+    SwsOpExec exec = {
+        .width          = PIXELS,
+        .height         = LINES,
+        .slice_h        = LINES,
+        .block_size_in  = comp->block_size * rw_pixel_bits(read)  >> 3,
+        .block_size_out = comp->block_size * rw_pixel_bits(write) >> 3,
+    };
+
+    for (int i = 0; i < 4; i++) {
+        exec.in[i]         = src_planes[i][0];
+        exec.out[i]        = out[i][0];
+        exec.in_stride[i]  = LINE_SIZE;
+        exec.out_stride[i] = LINE_SIZE;
+        exec.in_bump[i]    = LINE_SIZE - read_size;
+        exec.out_bump[i]   = LINE_SIZE - write_size;
+    }
+
+    comp->func(&exec, comp->priv, 0, 0, PIXELS / comp->block_size, LINES);
+}
+
+static int run_test(SwsContext *const ctx, AVFrame *frame, AVLFG *lfg,
+                    const AVPixFmtDescriptor *const src_desc,
+                    const AVPixFmtDescriptor *const dst_desc)
+{
+    SwsCompiledOp comp[2] = {0};
+    int ret = 0;
+
+    /* Same op list setup as in sws_ops.c */
+    frame->format = av_pix_fmt_desc_get_id(src_desc);
+    SwsFormat src_fmt = ff_fmt_from_frame(frame, 0);
+    frame->format = av_pix_fmt_desc_get_id(dst_desc);
+    SwsFormat dst_fmt = ff_fmt_from_frame(frame, 0);
+    bool incomplete = ff_infer_colors(&src_fmt.color, &dst_fmt.color);
+
+    SwsOpList *ops = ff_sws_op_list_alloc();
+    if (!ops)
+        return AVERROR(ENOMEM);
+    ops->src = src_fmt;
+    ops->dst = dst_fmt;
+
+    if (ff_sws_decode_pixfmt(ops, src_fmt.format) < 0)
+        goto done;
+    if (ff_sws_decode_colors(ctx, SWS_PIXEL_F32, ops, &src_fmt, &incomplete) < 0)
+        goto done;
+    if (ff_sws_encode_colors(ctx, SWS_PIXEL_F32, ops, &src_fmt, &dst_fmt, &incomplete) < 0)
+        goto done;
+    if (ff_sws_encode_pixfmt(ops, dst_fmt.format) < 0)
+        goto done;
+
+    ff_sws_op_list_optimize(ops);
+    if (ff_sws_op_list_is_noop(ops))
+        goto done;
+    ff_sws_op_list_update_comps(ops);
+
+    /* Silently skip the op lists the C backend can not compile */
+    if (ff_sws_ops_compile_backend(ctx, &backend_c_unfused, ops, &comp[0]) < 0 ||
+        ff_sws_ops_compile_backend(ctx, &backend_c, ops, &comp[1]) < 0)
+        goto done;
+
+    const SwsOp *read  = &ops->ops[0];
+    const SwsOp *write = &ops->ops[ops->num_ops - 1];
+    const int planes   = write->rw.packed ? 1 : write->rw.elems;
+    const int size     = PIXELS * rw_pixel_bits(write) >> 3;
+
+    fill_src(lfg, read);
+    for (int n = 0; n < 2; n++) {
+        memset(dst_planes[n], 0, sizeof(dst_planes[n]));
+        run(&comp[n], read, write, dst_planes[n]);
+    }
+
+    for (int p = 0; p < planes; p++) {
+        for (int y = 0; y < LINES; y++) {
+            if (memcmp(dst_planes[0][p][y], dst_planes[1][p][y], size)) {
+                av_log(NULL, AV_LOG_ERROR, "%s -> %s: plane %d, line %d differs\n",
+                       av_get_pix_fmt_name(src_fmt.format),
+                       av_get_pix_fmt_name(dst_fmt.format), p, y);
+                ret = 1;
+                goto done;
+            }
+        }
+    }
+
+done:
+    for (int n = 0; n < 2; n++) {
+        if (comp[n].free)
+            comp[n].free(comp[n].priv);
+    }
+    ff_sws_op_list_free(&ops);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int ret = 1, failed = 0;
+    AVLFG lfg;
+
+    av_lfg_init(&lfg, 0xC0FFEE);
+
+    SwsContext *ctx = sws_alloc_context();
+    AVFrame *frame = av_frame_alloc();
+    if (!ctx || !frame)
+        goto fail;
+    ctx->flags = SWS_BITEXACT;
+    frame->width = frame->height = 16;
+
+    for (const AVPixFmtDescriptor *src = NULL; (src = av_pix_fmt_desc_next(src));) {
+        for (const AVPixFmtDescriptor *dst = NULL; (dst = av_pix_fmt_desc_next(dst));) {
+            int err = run_test(ctx, frame, &lfg, src, dst);
+            if (err < 0)
+                goto fail;
+            failed += err;
+        }
+    }
+
+    ret = !!failed;
+fail:
+    av_frame_free(&frame);
+    sws_free_context(&ctx);
+    return ret;
+}
@@ -0,0 +1,252 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * frame_progress test: the rows reported as final must be equal to the
+ * ones of the frame eventually returned by the decoder.
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/imgutils.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+
+#define MAX_FRAMES 64
+
+typedef struct Shadow {
+    const uint8_t *key;         ///< data of the first buffer of the frame
+    uint8_t *data[4];
+    int rows;                   ///< rows copied so far
+    int calls;
+} Shadow;
+
+static Shadow shadows[MAX_FRAMES];
+static AVMutex shadow_mutex = AV_MUTEX_INITIALIZER;
+// incremented from the decoder threads
+static atomic_int errors;
+
+static Shadow *get_shadow(const uint8_t *key)
+{
+    for (int i = 0; i < MAX_FRAMES; i++)
+        if (shadows[i].key == key)
+            return &shadows[i];
+    for (int i = 0; i < MAX_FRAMES; i++)
+        if (!shadows[i].key) {
+            shadows[i].key = key;
+            return &shadows[i];
+        }
+    return NULL;
+}
+
+static int plane_rows(const AVPixFmtDescriptor *desc, int plane, int rows, int full)
+{
+    int shift = plane == 1 || plane == 2 ? desc->log2_chroma_h : 0;
+    return full ? AV_CEIL_RSHIFT(rows, shift) : rows >> shift;
+}
+
+static void frame_progress(AVCodecContext *avctx, const AVFrame *frame, int rows)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    Shadow *s;
+
+    ff_mutex_lock(&shadow_mutex);
+    s = get_shadow(frame->buf[0]->data);
+    ff_mutex_unlock(&shadow_mutex);
+    if (!s) {
+        atomic_fetch_add(&errors, 1);
+        return;
+    }
+
+    /* progress of a previous frame that used the same buffer */
+    if (rows <= s->rows)
+        s->rows = s->calls = 0;
+    if (rows > frame->height) {
+        av_log(avctx, AV_LOG_ERROR, "%d rows reported for a frame of %d\n",
+               rows, frame->height);
+        atomic_fetch_add(&errors, 1);
+        return;
+    }
+
+    for (int p = 0; p < 4 && frame->data[p]; p++) {
+        size_t size = (size_t)frame->linesize[p] * frame->height;
+        int from    = plane_rows(desc, p, s->rows, 0);
+        int to      = plane_rows(desc, p, rows, rows == frame->height);
+
+        if (!s->data[p] && !(s->data[p] = av_mallocz(size))) {
+            atomic_fetch_add(&errors, 1);
+            return;
+        }
+        memcpy(s->data[p] + (size_t)from * frame->linesize[p],
+               frame->data[p] + (size_t)from * frame->linesize[p],
+               (size_t)(to - from) * frame->linesize[p]);
+    }
+    s->rows = rows;
+    s->calls++;
+}
+
+static int check_frame(AVCodecContext *avctx, const AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    Shadow *s;
+
+    ff_mutex_lock(&shadow_mutex);
+    s = get_shadow(frame->buf[0]->data);
+    ff_mutex_unlock(&shadow_mutex);
+    if (!s || s->rows != frame->height) {
+        av_log(avctx, AV_LOG_ERROR, "Frame was not completely reported: %d rows\n",
+               s ? s->rows : -1);
+        return -1;
+    }
+    for (int p = 0; p < 4 && frame->data[p]; p++) {
+        int width = av_image_get_linesize(frame->format, frame->width, p);
+        int h     = plane_rows(desc, p, frame->height, 1);
+
+        for (int y = 0; y < h; y++)
+            if (memcmp(s->data[p] + (size_t)y * frame->linesize[p],
+                       frame->data[p] + (size_t)y * frame->linesize[p], width)) {
+                av_log(avctx, AV_LOG_ERROR, "Plane %d row %d changed after "
+                       "being reported as final\n", p, y);
+                return -1;
+            }
+    }
+    return 0;
+}
+
+static int video_decode(const char *input_filename, int threads, int thread_type)
+{
+    const AVCodec *codec = NULL;
+    AVCodecContext *ctx = NULL;
+    AVFrame *fr = NULL;
+    AVPacket *pkt = NULL;
+    AVFormatContext *fmt_ctx = NULL;
+    int video_stream, nb_frames = 0;
+    int result;
+
+    result = avformat_open_input(&fmt_ctx, input_filename, NULL, NULL);
+    if (result < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't open file\n");
+        return result;
+    }
+
+    result = avformat_find_stream_info(fmt_ctx, NULL);
+    if (result < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't get stream info\n");
+        goto finish;
+    }
+
+    video_stream = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (video_stream < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't find video stream in input file\n");
+        result = video_stream;
+        goto finish;
+    }
+
+    ctx = avcodec_alloc_context3(codec);
+    fr  = av_frame_alloc();
+    pkt = av_packet_alloc();
+    if (!ctx || !fr || !pkt) {
+        result = AVERROR(ENOMEM);
+        goto finish;
+    }
+
+    result = avcodec_parameters_to_context(ctx, fmt_ctx->streams[video_stream]->codecpar);
+    if (result < 0)
+        goto finish;
+
+    ctx->frame_progress = frame_progress;
+    ctx->apply_cropping = 0;
+    ctx->thread_count   = threads;
+    ctx->thread_type    = thread_type;
+
+    result = avcodec_open2(ctx, codec, NULL);
+    if (result < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Can't open decoder\n");
+        goto finish;
+    }
+
+    while (result >= 0) {
+        result = av_read_frame(fmt_ctx, pkt);
+        if (result >= 0 && pkt->stream_index != video_stream) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        // pkt will be empty on read error/EOF
+        result = avcodec_send_packet(ctx, pkt);
+        av_packet_unref(pkt);
+        if (result < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Error submitting a packet for decoding\n");
+            goto finish;
+        }
+
+        while (result >= 0) {
+            result = avcodec_receive_frame(ctx, fr);
+            if (result == AVERROR_EOF) {
+                result = 0;
+                goto finish;
+            } else if (result == AVERROR(EAGAIN)) {
+                result = 0;
+                break;
+            } else if (result < 0) {
+                av_log(NULL, AV_LOG_ERROR, "Error decoding frame\n");
+                goto finish;
+            }
+
+            result = check_frame(ctx, fr);
+            av_frame_unref(fr);
+            nb_frames++;
+        }
+    }
+
+finish:
+    if (!result && (atomic_load(&errors) || !nb_frames))
+        result = -1;
+    av_packet_free(&pkt);
+    av_frame_free(&fr);
+    avformat_close_input(&fmt_ctx);
+    avcodec_free_context(&ctx);
+    for (int i = 0; i < MAX_FRAMES; i++)
+        for (int p = 0; p < 4; p++)
+            av_freep(&shadows[i].data[p]);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    int threads, thread_type;
+
+    if (argc < 4) {
+        av_log(NULL, AV_LOG_ERROR, "Incorrect input: expected %s "
+               "<threads> <slice|frame> <name of a video file>\n", argv[0]);
+        return 1;
+    }
+
+    threads     = strtol(argv[1], NULL, 0);
+    thread_type = !strcmp(argv[2], "slice") ? FF_THREAD_SLICE : FF_THREAD_FRAME;
+
+    if (video_decode(argv[3], threads, thread_type) != 0)
+        return 1;
+
+    return 0;
+}
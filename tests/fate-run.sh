@@ -413,6 +413,26 @@ lavf_container(){
         do_avconv_crc $file -auto_conversion_filters $DEC_OPTS -i $target_path/$file $3
 }
 
+seek_index_cache(){
+    cache="${outdir}/${test}.idx"
+    cleanfiles="$cleanfiles $cache"
+    rm -f $cache
+    # the second run seeks with the index saved by the first one
+    run libavformat/tests/seek${EXECSUF} $target_path/$1 -index_cache $target_path/$cache > /dev/null || return
+    run libavformat/tests/seek${EXECSUF} $target_path/$1 -index_cache $target_path/$cache
+}
+
+probe_cache(){
+    cache="${outdir}/${test}.cache"
+    rm -rf $cache && mkdir -p $cache || return
+    # the second run takes the stream parameters found by the first one
+    probe -show_streams -probe_cache $target_path/$cache $target_path/$1 > /dev/null &&
+    probe -show_streams -probe_cache $target_path/$cache $target_path/$1
+    ret=$?
+    rm -rf $cache
+    return $ret
+}
+
 lavf_container_attach() {          lavf_container "" "$1 -attach ${raw_src%/*}/00.pgm -metadata:s:t mimetype=image/x-portable-greymap"; }
 lavf_container_timecode_nodrop() { lavf_container "" "$1 -timecode 02:56:14:13"; }
 lavf_container_timecode_drop()   { lavf_container "" "$1 -timecode 02:56:14.13 -r 30000/1001"; }
@@ -16,6 +16,14 @@ FATE_API_SAMPLES_LIBAVFORMAT-$(call DEMDEC, H264, H264) += fate-api-h264-slice
 fate-api-h264-slice: $(APITESTSDIR)/api-h264-slice-test$(EXESUF)
 fate-api-h264-slice: CMD = run $(APITESTSDIR)/api-h264-slice-test$(EXESUF) 2 $(TARGET_SAMPLES)/h264/crew_cif.nal
 
+FATE_API_H264_PROGRESS = fate-api-h264-progress fate-api-h264-progress-slice fate-api-h264-progress-frame
+FATE_API_SAMPLES_LIBAVFORMAT-$(call DEMDEC, H264, H264) += $(FATE_API_H264_PROGRESS)
+$(FATE_API_H264_PROGRESS): $(APITESTSDIR)/api-h264-progress-test$(EXESUF)
+$(FATE_API_H264_PROGRESS): CMP = null
+fate-api-h264-progress:       CMD = run $(APITESTSDIR)/api-h264-progress-test$(EXESUF) 1 slice $(TARGET_SAMPLES)/h264-conformance/SVA_NL2_E.264
+fate-api-h264-progress-slice: CMD = run $(APITESTSDIR)/api-h264-progress-test$(EXESUF) 3 slice $(TARGET_SAMPLES)/h264-conformance/CAPAMA3_Sand_F.264
+fate-api-h264-progress-frame: CMD = run $(APITESTSDIR)/api-h264-progress-test$(EXESUF) 3 frame $(TARGET_SAMPLES)/h264-conformance/CAPAMA3_Sand_F.264
+
 FATE_API_LIBAVFORMAT-yes += $(if $(findstring fate-lavf-flv,$(FATE_LAVF_CONTAINER)),fate-api-seek)
 fate-api-seek: $(APITESTSDIR)/api-seek-test$(EXESUF) fate-lavf-flv
 fate-lavf-flv: KEEP_FILES ?= 1
@@ -433,6 +433,25 @@ fate-filter-atempo: CMD = pcm -i $(TARGET_PATH)/tests/data/asynth-44100-1.wav -a
 fate-filter-atempo: CMP = oneoff
 fate-filter-atempo: REF = $(SAMPLES)/filter-reference/atempo.pcm
 
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, LOUDNORM, WAV, PCM_S16LE, PCM_S16LE, FRAMECRC, PIPE_PROTOCOL) += fate-filter-loudnorm-measure-only
+fate-filter-loudnorm-measure-only: tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-measure-only: CMD = framecrc -auto_conversion_filters -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af loudnorm=measure_only=1 -c:a pcm_s16le
+
+# the meters give the same results with any number of threads
+AFILTER_5_1 = pan=5.1|c0=c0|c1=c1|c2=c0|c3=c1|c4=c0|c5=c1
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, PAN LOUDNORM ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, FRAMECRC, PIPE_PROTOCOL) += fate-filter-loudnorm fate-filter-loudnorm-threads
+fate-filter-loudnorm fate-filter-loudnorm-threads: tests/data/asynth-44100-2.wav
+fate-filter-loudnorm: CMD = framecrc -auto_conversion_filters -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af "$(AFILTER_5_1),loudnorm,aresample=44100" -c:a pcm_s16le
+fate-filter-loudnorm-threads: CMD = framecrc -auto_conversion_filters -filter_threads 4 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af "$(AFILTER_5_1),loudnorm,aresample=44100" -c:a pcm_s16le
+fate-filter-loudnorm-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-loudnorm
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, PAN EBUR128 AMETADATA, WAV, PCM_S16LE, , NULL, PIPE_PROTOCOL) += fate-filter-ebur128 fate-filter-ebur128-threads
+fate-filter-ebur128 fate-filter-ebur128-threads: tests/data/asynth-44100-2.wav
+fate-filter-ebur128: CMD = ffmpeg -auto_conversion_filters -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af "$(AFILTER_5_1),ebur128=metadata=1:peak=sample,ametadata=mode=print:file=-" -f null -
+fate-filter-ebur128-threads: CMD = ffmpeg -auto_conversion_filters -filter_threads 4 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af "$(AFILTER_5_1),ebur128=metadata=1:peak=sample,ametadata=mode=print:file=-" -f null -
+fate-filter-ebur128-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-ebur128
+
 fate-filter-aloop: CMD = framecrc -filter_complex "sine=r=48000:f=480:d=4,aloop=loop=4:start=48000:size=48000,asetnsamples=9600"
 FATE_AFILTER-$(call ALLYES, SINE_FILTER ALOOP_FILTER ASETNSAMPLES_FILTER PCM_S16LE_ENCODER FRAMECRC_MUXER PIPE_PROTOCOL) += fate-filter-aloop
 
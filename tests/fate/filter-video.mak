@@ -90,6 +90,13 @@ fate-filter-lavd-testsrc: CMD = framecrc -f lavfi -i testsrc=r=7:n=2:d=10
 FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2) += $(addprefix fate-filter-testsrc2-, yuv420p yuv444p rgb24 rgba)
 fate-filter-testsrc2-%: CMD = framecrc -lavfi testsrc2=r=7:d=10 -pix_fmt $(word 4, $(subst -, ,$(@)))
 
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 FORMAT MULTISCALE) += fate-filter-multiscale fate-filter-multiscale-cascade
+fate-filter-multiscale: CMD = framecrc -lavfi "testsrc2=r=5:d=1,format=yuv420p,multiscale=sizes=160x120|320x180|96x54:flags=bicubic+accurate_rnd+bitexact:cascade=0"
+fate-filter-multiscale-cascade: CMD = framecrc -lavfi "testsrc2=r=5:d=1,format=yuv420p,multiscale=sizes=160x120|320x180|240x180|96x72:flags=bicubic+accurate_rnd+bitexact"
+
+FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2 SPLIT HFLIP VFLIP NEGATE BOXBLUR HSTACK) += fate-filter-pipeline
+fate-filter-pipeline: CMD = framecrc -filter_pipeline -filter_complex_threads 4 -lavfi "testsrc2=r=5:d=2,split=3[a][b][c];[a]hflip[a2];[b]vflip,negate[b2];[c]boxblur[c2];[a2][b2][c2]hstack=3" -pix_fmt yuv420p
+
 FATE_FILTER-$(call FILTERFRAMECRC, ALLRGB) += fate-filter-allrgb
 fate-filter-allrgb: CMD = framecrc -lavfi allrgb=rate=5:duration=1 -pix_fmt rgb24
 
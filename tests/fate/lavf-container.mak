@@ -71,6 +71,16 @@ fate-lavf-wtv: CMD = lavf_container "" "-c:a mp2 -threads 1"
 FATE_AVCONV += $(FATE_LAVF_CONTAINER)
 fate-lavf-container fate-lavf: $(FATE_LAVF_CONTAINER)
 
+# probing with the stream parameters cached by a previous run
+FATE_LAVF_PROBE_CACHE := $(filter fate-lavf-ts, $(FATE_LAVF_CONTAINER))
+FATE_LAVF_PROBE_CACHE := $(FATE_LAVF_PROBE_CACHE:fate-lavf-%=fate-lavf-probe-cache-%)
+
+fate-lavf-probe-cache-ts: fate-lavf-ts
+fate-lavf-probe-cache-ts: CMD = probe_cache tests/data/lavf/lavf.ts
+
+FATE_FFPROBE += $(FATE_LAVF_PROBE_CACHE)
+fate-lavf: $(FATE_LAVF_PROBE_CACHE)
+
 FATE_LAVF_CONTAINER_FATE-$(call CRC, APV MOV,,           APV_PARSER MP4_MUXER) += apv.mp4
 FATE_LAVF_CONTAINER_FATE-$(call CRC, IVF MOV, AV1,       AV1_PARSER EXTRACT_EXTRADATA_BSF MP4_MUXER)      += av1.mp4
 FATE_LAVF_CONTAINER_FATE-$(call CRC, IVF MATROSKA, AV1,  AV1_PARSER EXTRACT_EXTRADATA_BSF MATROSKA_MUXER) += av1.mkv
@@ -44,6 +44,12 @@ fate-sws-ops-list: libswscale/tests/sws_ops$(EXESUF)
 fate-sws-ops-list: CMD = run libswscale/tests/sws_ops$(EXESUF) | do_md5sum | cut -d" " -f1
 endif
 
+# Compare the fused kernels of the C backend against one kernel per op
+FATE_LIBSWSCALE-$(CONFIG_UNSTABLE) += fate-sws-ops-fused
+fate-sws-ops-fused: libswscale/tests/sws_ops_fused$(EXESUF)
+fate-sws-ops-fused: CMD = run libswscale/tests/sws_ops_fused$(EXESUF)
+fate-sws-ops-fused: CMP = null
+
 FATE_LIBSWSCALE += $(FATE_LIBSWSCALE-yes)
 FATE_LIBSWSCALE_SAMPLES += $(FATE_LIBSWSCALE_SAMPLES-yes)
 FATE-$(CONFIG_SWSCALE) += $(FATE_LIBSWSCALE)
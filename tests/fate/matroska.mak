@@ -281,8 +281,15 @@ fate-matroska-side-data-pref-packet: CMD = run ffprobe$(PROGSSUF)$(EXESUF) $(TAR
     -select_streams v:0 -show_streams -show_frames -show_entries stream=stream_side_data:frame=frame_side_data_list -side_data_prefer_packet mastering_display_metadata,content_light_level
 FATE_MATROSKA_FFPROBE-$(call ALLYES, MATROSKA_DEMUXER HEVC_DECODER) += fate-matroska-side-data-pref-codec fate-matroska-side-data-pref-packet
 
+# Test reading the clusters ahead
+FATE_MATROSKA_FFMPEG-$(call TRANSCODE, PCM_S16LE, MATROSKA, WAV_DEMUXER) \
+                               += fate-matroska-prefetch
+fate-matroska-prefetch: tests/data/asynth-44100-2.wav
+fate-matroska-prefetch: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-2.wav matroska "-c:a pcm_s16le -cluster_time_limit 100 -write_crc32 0" "-c copy" "" "" "-prefetch_threads 2 -prefetch_chunk_size 4096"
+
 FATE_SAMPLES_AVCONV += $(FATE_MATROSKA-yes)
 FATE_SAMPLES_FFPROBE += $(FATE_MATROSKA_FFPROBE-yes)
 FATE_SAMPLES_FFMPEG_FFPROBE += $(FATE_MATROSKA_FFMPEG_FFPROBE-yes)
+FATE_FFMPEG += $(FATE_MATROSKA_FFMPEG-yes)
 
-fate-matroska: $(FATE_MATROSKA-yes) $(FATE_MATROSKA_FFPROBE-yes) $(FATE_MATROSKA_FFMPEG_FFPROBE-yes)
+fate-matroska: $(FATE_MATROSKA-yes) $(FATE_MATROSKA_FFMPEG-yes) $(FATE_MATROSKA_FFPROBE-yes) $(FATE_MATROSKA_FFMPEG_FFPROBE-yes)
@@ -275,6 +275,12 @@ FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_F32LE, MP4 MOV, WAV_DEMUXER PAN_FILTER) \
 fate-mov-mp4-pcm-float: tests/data/asynth-44100-1.wav
 fate-mov-mp4-pcm-float: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-af aresample,pan=FR+FL+FR|c0=c0|c1=c0|c2=c0 -c:a pcm_f32le" "-map 0 -c copy -frames:a 0"
 
+# Test reading the fragments of an indexed fragmented mp4 ahead
+FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MP4 MOV, WAV_DEMUXER) \
+                          += fate-mov-mp4-frag-prefetch
+fate-mov-mp4-frag-prefetch: tests/data/asynth-44100-2.wav
+fate-mov-mp4-frag-prefetch: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-2.wav mp4 "-c:a pcm_s16le -movflags +frag_keyframe+global_sidx -frag_duration 100000" "-c copy" "" "" "-prefetch_threads 2 -prefetch_chunk_size 4096"
+
 fate-mov-pcm-remux: tests/data/asynth-44100-1.wav
 fate-mov-pcm-remux: CMD = md5 -i $(TARGET_PATH)/tests/data/asynth-44100-1.wav -map 0 -c copy -fflags +bitexact -f mp4
 fate-mov-pcm-remux: CMP = oneline
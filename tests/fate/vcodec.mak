@@ -267,6 +267,7 @@ FATE_MPEG2 := mpeg2                                                     \
              mpeg2-idct-int                                             \
              mpeg2-ilace                                                \
              mpeg2-ivlc-qprd                                            \
+             mpeg2-mbtree                                               \
              mpeg2-thread                                               \
              mpeg2-thread-ivlc
 
@@ -293,6 +294,7 @@ fate-vsynth%-mpeg2-ivlc-qprd:    ENCOPTS = -b:v 500k                    \
                                            -intra_vlc 1                 \
                                            -cmp 2 -subcmp 2             \
                                            -mbd rd
+fate-vsynth%-mpeg2-mbtree:       ENCOPTS = -b:v 600k -bf 2 -rc_lookahead 10
 fate-vsynth%-mpeg2-thread:       ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -threads 2 -slices 2
 fate-vsynth%-mpeg2-thread-ivlc:  ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
@@ -359,8 +361,10 @@ fate-vsynth%-msmpeg4v2:          ENCOPTS = -qscale 10
 FATE_VCODEC_SCALE-$(call ENCDEC, MSRLE, AVI) += msrle
 fate-vsynth%-msrle:              CODEC   = msrle
 
-FATE_VCODEC_SCALE-$(call ENCDEC, PNG, AVI) += mpng
+FATE_VCODEC_SCALE-$(call ENCDEC, PNG, AVI) += mpng mpng-threads
 fate-vsynth%-mpng:               CODEC   = png
+fate-vsynth%-mpng-threads:       CODEC   = png
+fate-vsynth%-mpng-threads:       ENCOPTS = -threads 4 -thread_type slice
 
 FATE_VCODEC_SCALE-$(call ENCDEC, MSVIDEO1, AVI) += msvideo1
 
@@ -505,7 +509,10 @@ FATE_VCODEC += $(FATE_VCODEC-yes)
 FATE_VCODEC := $(if $(call ENCDEC, RAWVIDEO, RAWVIDEO),$(FATE_VCODEC))
 FATE_VSYNTH1 = $(FATE_VCODEC:%=fate-vsynth1-%)
 FATE_VSYNTH2 = $(FATE_VCODEC:%=fate-vsynth2-%)
-FATE_VSYNTH_LENA = $(FATE_VCODEC:%=fate-vsynth_lena-%)
+# Tests added without access to the lena sample, and so without a reference
+VSYNTH_LENA_OFF  = mpeg2-mbtree mpng-threads
+FATE_VCODEC_LENA = $(filter-out $(VSYNTH_LENA_OFF),$(FATE_VCODEC))
+FATE_VSYNTH_LENA = $(FATE_VCODEC_LENA:%=fate-vsynth_lena-%)
 # Redundant tests because they just resize the input
 RESIZE_OFF   = dnxhd-720p dnxhd-720p-rd dnxhd-720p-10bit dnxhd-1080i \
                dv dv-411 dv-50 avui snow snow-hpel snow-ll vc2-420p \
@@ -0,0 +1,166 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the throughput of the minterpolate filter converting a generated
+ * 25 fps source to 50 fps, by default at 1080p and 2160p:
+ *     tools/minterpolate_bench
+ *     tools/minterpolate_bench -t 8 -n 100 -s 1280x720 -o me=umh:vsbmc=1
+ * The time taken by the source alone is measured separately and subtracted.
+ */
+
+#include "config.h"
+#if HAVE_UNISTD_H
+#include <unistd.h>             /* getopt */
+#endif
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavutil/bprint.h"
+#include "libavutil/frame.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/time.h"
+
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+static void usage(int ret)
+{
+    fprintf(ret ? stderr : stdout,
+            "Usage: minterpolate_bench [-n frames] [-t threads] [-s WxH ...] [-o options]\n"
+            "Options are passed to the filter, e.g. me=umh:mc_mode=aobmc.\n");
+    exit(ret);
+}
+
+/**
+ * Run the graph to completion.
+ * @return the time taken in microseconds or a negative AVERROR
+ */
+static int64_t run_graph(const char *desc, int threads, int *nb_frames)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *sink;
+    AVFrame *frame = av_frame_alloc();
+    int64_t t0, ret;
+
+    *nb_frames = 0;
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = threads;
+
+    if ((ret = avfilter_graph_parse_ptr(graph, desc, NULL, NULL, NULL)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+    sink = avfilter_graph_get_filter(graph, "buffersink@sink");
+
+    t0 = av_gettime_relative();
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+        (*nb_frames)++;
+        av_frame_unref(frame);
+    }
+    if (ret == AVERROR_EOF)
+        ret = av_gettime_relative() - t0;
+
+end:
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+static int bench(int w, int h, int frames, int threads, const char *opts)
+{
+    AVBPrint src, desc;
+    int64_t t_src, t_total;
+    int nb_src, nb_out;
+    double t;
+
+    av_bprint_init(&src,  0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprint_init(&desc, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprintf(&src, "testsrc2=s=%dx%d:r=25,trim=end_frame=%d,format=yuv420p",
+               w, h, frames);
+    av_bprintf(&desc, "%s,minterpolate=fps=50%s%s,buffersink@sink", src.str,
+               *opts ? ":" : "", opts);
+    av_bprintf(&src, ",buffersink@sink");
+
+    t_src = run_graph(src.str, threads, &nb_src);
+    t_total = t_src < 0 ? t_src : run_graph(desc.str, threads, &nb_out);
+    av_bprint_finalize(&src,  NULL);
+    av_bprint_finalize(&desc, NULL);
+    if (t_total < 0) {
+        fprintf(stderr, "%dx%d: %s\n", w, h, av_err2str(t_total));
+        return t_total;
+    }
+
+    t = FFMAX(t_total - t_src, 1) / 1000000.0;
+    printf("%4dx%-4d %d -> %d frames  %8.3f s  %8.2f fps\n",
+           w, h, nb_src, nb_out, t, nb_out / t);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const default_sizes[] = { "1920x1080", "3840x2160" };
+    const char *sizes[16];
+    const char *opts = "";
+    int nb_sizes = 0, frames = 50, threads = 0;
+    int opt, ret = 0;
+
+    while ((opt = getopt(argc, argv, "hn:t:s:o:")) != -1) {
+        switch (opt) {
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        case 't':
+            threads = atoi(optarg);
+            break;
+        case 's':
+            if (nb_sizes == FF_ARRAY_ELEMS(sizes))
+                usage(1);
+            sizes[nb_sizes++] = optarg;
+            break;
+        case 'o':
+            opts = optarg;
+            break;
+        case 'h':
+            usage(0);
+        default:
+            usage(1);
+        }
+    }
+    if (optind != argc || frames <= 0 || threads < 0)
+        usage(1);
+
+    if (!nb_sizes)
+        for (; nb_sizes < FF_ARRAY_ELEMS(default_sizes); nb_sizes++)
+            sizes[nb_sizes] = default_sizes[nb_sizes];
+
+    for (int i = 0; i < nb_sizes && ret >= 0; i++) {
+        int w, h;
+
+        if (av_parse_video_size(&w, &h, sizes[i]) < 0) {
+            fprintf(stderr, "Invalid size '%s'\n", sizes[i]);
+            return 1;
+        }
+        ret = bench(w, h, frames, threads, opts);
+    }
+
+    return ret < 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the time taken by avformat_open_input() and
+ * avformat_find_stream_info(), e.g. to compare startup with and without
+ * the probe cache:
+ *     tools/probe_bench -n 20 input.ts
+ *     tools/probe_bench -n 20 -o probe_cache=/tmp/cache input.ts
+ */
+
+#include "config.h"
+#if HAVE_UNISTD_H
+#include <unistd.h>             /* getopt */
+#endif
+
+#include "libavformat/avformat.h"
+#include "libavutil/dict.h"
+#include "libavutil/mem.h"
+#include "libavutil/qsort.h"
+#include "libavutil/time.h"
+
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+static void usage(int ret)
+{
+    fprintf(ret ? stderr : stdout,
+            "Usage: probe_bench [-n runs] [-f format] [-o option=value ...] file\n"
+            "Options are applied to the demuxer, e.g. probe_cache=dir or probesize=N.\n");
+    exit(ret);
+}
+
+static int cmp_int64(const void *a, const void *b)
+{
+    return FFDIFFSIGN(*(const int64_t *)a, *(const int64_t *)b);
+}
+
+static void print_stats(const char *name, int64_t *t, int n)
+{
+    int64_t sum = 0;
+
+    for (int i = 0; i < n; i++)
+        sum += t[i];
+    AV_QSORT(t, n, int64_t, cmp_int64);
+    printf("%-20s min %8.3f ms  median %8.3f ms  mean %8.3f ms\n", name,
+           t[0] / 1000.0, t[n / 2] / 1000.0, sum / 1000.0 / n);
+}
+
+int main(int argc, char **argv)
+{
+    const AVInputFormat *fmt = NULL;
+    AVDictionary *opts = NULL;
+    int64_t *t_open, *t_info, *t_total;
+    int64_t bytes_read = 0;
+    int opt, ret, runs = 10;
+
+    while ((opt = getopt(argc, argv, "hn:f:o:")) != -1) {
+        switch (opt) {
+        case 'n':
+            runs = atoi(optarg);
+            break;
+        case 'f':
+            if (!(fmt = av_find_input_format(optarg))) {
+                fprintf(stderr, "Unknown format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            if (av_dict_parse_string(&opts, optarg, "=", "", 0) < 0) {
+                fprintf(stderr, "Invalid option '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'h':
+            usage(0);
+        default:
+            usage(1);
+        }
+    }
+    if (optind != argc - 1 || runs <= 0)
+        usage(1);
+
+    t_open  = av_calloc(runs, sizeof(*t_open));
+    t_info  = av_calloc(runs, sizeof(*t_info));
+    t_total = av_calloc(runs, sizeof(*t_total));
+    if (!t_open || !t_info || !t_total) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (int i = 0; i < runs; i++) {
+        AVFormatContext *avf = NULL;
+        AVDictionary *run_opts = NULL;
+        int64_t t0, t1, t2;
+
+        av_dict_copy(&run_opts, opts, 0);
+        t0  = av_gettime_relative();
+        ret = avformat_open_input(&avf, argv[optind], fmt, &run_opts);
+        av_dict_free(&run_opts);
+        if (ret < 0) {
+            fprintf(stderr, "%s: %s\n", argv[optind], av_err2str(ret));
+            goto end;
+        }
+        t1  = av_gettime_relative();
+        ret = avformat_find_stream_info(avf, NULL);
+        t2  = av_gettime_relative();
+        if (ret < 0) {
+            fprintf(stderr, "%s: could not find codec parameters: %s\n",
+                    argv[optind], av_err2str(ret));
+            avformat_close_input(&avf);
+            goto end;
+        }
+        if (avf->pb)
+            bytes_read += avf->pb->bytes_read;
+        avformat_close_input(&avf);
+
+        t_open[i]  = t1 - t0;
+        t_info[i]  = t2 - t1;
+        t_total[i] = t2 - t0;
+    }
+
+    printf("%d runs, %"PRId64" bytes read per run\n", runs, bytes_read / runs);
+    print_stats("open_input",       t_open,  runs);
+    print_stats("find_stream_info", t_info,  runs);
+    print_stats("total",            t_total, runs);
+    ret = 0;
+
+end:
+    av_dict_free(&opts);
+    av_free(t_open);
+    av_free(t_info);
+    av_free(t_total);
+    return ret < 0;
+}